@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+*/
+
+namespace sg {
+
+	/*
+	64 bit FNV-1a. The result is the same on every platform, so it is safe to store in files and compare between the
+	editor and the game.
+	*/
+	class Hasher {
+		uint64_t mValue = 0xcbf29ce484222325ull;
+
+	public:
+		Hasher& bytes(const void* data, size_t size) {
+			const uint8_t* p = static_cast<const uint8_t*>(data);
+			for (size_t n = 0; n < size; ++n) {
+				mValue = (mValue ^ p[n]) * 0x100000001b3ull;
+			}
+
+			return *this;
+		}
+
+		// the length is included, so "ab", "c" and "a", "bc" hash differently
+		Hasher& text(const std::string& s) {
+			value(uint64_t(s.size()));
+			return bytes(s.data(), s.size());
+		}
+
+		// integers only, they are hashed in little endian byte order
+		template<typename T>
+		Hasher& value(T v) {
+			for (size_t n = 0; n < sizeof(T); ++n) {
+				const uint8_t b = uint8_t(uint64_t(v) >> (n * 8));
+				bytes(&b, 1);
+			}
+
+			return *this;
+		}
+
+		uint64_t result() const { return mValue; }
+	};
+
+	// The Hasher result for the bytes of a string, and the hash stored with every string in a scene's text pool. constexpr
+	// so a name known at compile time is looked up with one integer compare.
+	constexpr uint64_t StringHash(const char* text, size_t length) {
+		uint64_t value = 0xcbf29ce484222325ull;
+		for (size_t n = 0; n < length; ++n) {
+			value = (value ^ uint8_t(text[n])) * 0x100000001b3ull;
+		}
+
+		return value;
+	}
+
+	/*
+	A checksum for large blocks of data, several times faster than Hasher since it reads 8 bytes at a time across
+	four independent lanes. Data may be added in pieces of any size, the result only depends on the bytes.
+	*/
+	class Checksum {
+		static const uint64_t PRIME_1 = 0x9e3779b185ebca87ull;
+		static const uint64_t PRIME_2 = 0xc2b2ae3d27d4eb4full;
+		static const size_t BLOCK_SIZE = 32;
+
+		uint64_t mLanes[4] = {PRIME_1, PRIME_2, ~PRIME_1, ~PRIME_2};
+		uint64_t mSize = 0;
+
+		uint8_t mPending[BLOCK_SIZE];
+		size_t mPendingSize = 0;
+
+		static uint64_t rotl(uint64_t v, int bits) {
+			return (v << bits) | (v >> (64 - bits));
+		}
+
+		static uint64_t load(const uint8_t* p) {
+			uint64_t v = 0;
+			for (size_t n = 0; n < 8; ++n) {
+				v |= uint64_t(p[n]) << (n * 8);
+			}
+
+			return v;
+		}
+
+		void block(const uint8_t* p) {
+			for (size_t n = 0; n < 4; ++n) {
+				mLanes[n] = rotl(mLanes[n] + load(p + n * 8) * PRIME_2, 31) * PRIME_1;
+			}
+		}
+
+	public:
+		Checksum& bytes(const void* data, size_t size) {
+
+			const uint8_t* p = static_cast<const uint8_t*>(data);
+			mSize += size;
+
+			if (mPendingSize > 0) {
+				const size_t count = std::min(size, BLOCK_SIZE - mPendingSize);
+				std::memcpy(mPending + mPendingSize, p, count);
+				mPendingSize += count;
+				p += count;
+				size -= count;
+
+				if (mPendingSize < BLOCK_SIZE)
+					return *this;
+
+				block(mPending);
+				mPendingSize = 0;
+			}
+
+			for (; size >= BLOCK_SIZE; p += BLOCK_SIZE, size -= BLOCK_SIZE) {
+				block(p);
+			}
+
+			std::memcpy(mPending, p, size);
+			mPendingSize = size;
+			return *this;
+		}
+
+		uint64_t result() const {
+
+			uint64_t h = mSize * PRIME_1;
+			for (size_t n = 0; n < 4; ++n) {
+				h = rotl(h ^ mLanes[n], 27) * PRIME_1 + PRIME_2;
+			}
+
+			for (size_t n = 0; n < mPendingSize; ++n) {
+				h = rotl(h ^ (mPending[n] * PRIME_1), 11) * PRIME_2;
+			}
+
+			h ^= h >> 33;
+			h *= PRIME_2;
+			h ^= h >> 29;
+			return h;
+		}
+	};
+}
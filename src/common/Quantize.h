@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+
+The encodings an f32 or f64 property can be stored with when it doesn't need full precision. The scene compiler encodes,
+the generated accessors decode. Decoding has no branches, so reading a range of quantized components vectorizes.
+*/
+
+namespace sg {
+
+	inline uint32_t FloatBits(float f) {
+		uint32_t bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+
+	inline float BitsFloat(uint32_t bits) {
+		float f;
+		std::memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	// IEEE 754 half precision, rounded to nearest even, too large becomes infinity
+	inline uint16_t EncodeHalf(float value) {
+
+		uint32_t bits = FloatBits(value);
+		const uint32_t sign = (bits >> 16) & 0x8000;
+		bits &= 0x7fffffff;
+
+		// 65536 and above, infinity and NaN
+		if (bits >= 0x47800000)
+			return uint16_t(sign | (bits > 0x7f800000 ? 0x7e00 : 0x7c00));
+
+		// smaller than the smallest normal half, adding 0.5 lines the mantissa up with a half denormal and rounds it
+		if (bits < 0x38800000)
+			return uint16_t(sign | (FloatBits(BitsFloat(bits) + 0.5f) - 0x3f000000));
+
+		// rebias the exponent and round the 13 dropped mantissa bits to even
+		const uint32_t odd = (bits >> 13) & 1;
+		bits += (uint32_t(15 - 127) << 23) + 0xfff + odd;
+		return uint16_t(sign | (bits >> 13));
+	}
+
+	inline float DecodeHalf(uint16_t half) {
+
+		// scaling by 2^112 rebiases the exponent, and turns half denormals into float normals
+		const float scaled = BitsFloat(uint32_t(half & 0x7fff) << 13) * BitsFloat(0x77800000);
+		uint32_t bits = FloatBits(scaled);
+
+		// a half exponent of 31 is infinity or NaN, which the scale leaves short of the float exponent
+		bits |= (0u - uint32_t(bits >= 0x47800000)) & 0x7f800000;
+		return BitsFloat(bits | (uint32_t(half & 0x8000) << 16));
+	}
+
+	// [0, 1] over the whole range of T, NaN becomes 0 since it would pass through the clamp
+	template<typename T>
+	T EncodeUnorm(double value) {
+		const double max = double(std::numeric_limits<T>::max());
+		return std::isnan(value) ? T(0) : T(std::lround(std::min(std::max(value, 0.0), 1.0) * max));
+	}
+
+	template<typename T>
+	float DecodeUnorm(T value) {
+		return float(value) * (1.0f / float(std::numeric_limits<T>::max()));
+	}
+
+	// [-1, 1], the smallest value of T also decodes to -1, so 0 is exact. NaN becomes 0.
+	template<typename T>
+	T EncodeSnorm(double value) {
+		const double max = double(std::numeric_limits<T>::max());
+		return std::isnan(value) ? T(0) : T(std::lround(std::min(std::max(value, -1.0), 1.0) * max));
+	}
+
+	template<typename T>
+	float DecodeSnorm(T value) {
+		return std::max(float(value) * (1.0f / float(std::numeric_limits<T>::max())), -1.0f);
+	}
+
+	// [min, max] in even steps over the whole range of T
+	template<typename T>
+	T EncodeFixed(double value, float min, float max) {
+		return EncodeUnorm<T>((value - min) / (double(max) - min));
+	}
+
+	template<typename T>
+	float DecodeFixed(T value, float min, float max) {
+		return min + float(value) * ((max - min) / float(std::numeric_limits<T>::max()));
+	}
+}
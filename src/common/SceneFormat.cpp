@@ -0,0 +1,176 @@
+#include "SceneFormat.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+namespace sg {
+
+	uint64_t SceneHeaderChecksum(const SceneFileHeader& header) {
+		return Checksum().bytes(&header, offsetof(SceneFileHeader, headerChecksum)).result();
+	}
+
+	uint64_t ScenePackHeaderChecksum(const ScenePackHeader& header) {
+		return Checksum().bytes(&header, offsetof(ScenePackHeader, headerChecksum)).result();
+	}
+
+	uint64_t SceneStringSize(size_t length) {
+		const uint64_t size = sizeof(SceneString) + length + 1;
+		return (size + SCENE_STRING_ALIGNMENT - 1) & ~(SCENE_STRING_ALIGNMENT - 1);
+	}
+
+	void WriteSceneString(const char* text, size_t length, uint32_t id, uint8_t* dest) {
+
+		SceneString header;
+		header.hash = StringHash(text, length);
+		header.length = uint32_t(length);
+		header.id = id;
+
+		std::memset(dest, 0, size_t(SceneStringSize(length)));
+		std::memcpy(dest, &header, sizeof(header));
+		std::memcpy(dest + sizeof(header), text, length);
+	}
+
+	uint64_t ScenePackNameHash(const char* name) {
+		return Hasher().bytes(name, std::strlen(name)).result();
+	}
+
+	const char* ValidateSceneHeader(const void* data, size_t size, uint64_t schema_hash) {
+
+		if (const char* reason = ValidateSceneHeader(data, size))
+			return reason;
+
+		if (static_cast<const SceneFileHeader*>(data)->schemaHash != schema_hash)
+			return "the scene was compiled for different components, the scene or the game needs rebuilding";
+
+		return nullptr;
+	}
+
+	const char* ValidateSceneHeader(const void* data, size_t size) {
+
+		if (size < sizeof(SceneFileHeader))
+			return "the file is too small to be a scene";
+
+		if (uintptr_t(data) % 16 != 0)
+			return "scene data must be aligned to 16 bytes";
+
+		const SceneFileHeader& header = *static_cast<const SceneFileHeader*>(data);
+
+		if (header.magic != SCENE_FILE_MAGIC)
+			return "the file is not a scene";
+
+		if (header.version != SCENE_FILE_VERSION)
+			return "the scene was compiled for a different version of the format";
+
+		if (header.headerChecksum != SceneHeaderChecksum(header))
+			return "the scene header is corrupt";
+
+		if (header.fileSize != size)
+			return "the scene is truncated";
+
+		for (const SceneSectionInfo& section : header.sections) {
+			if (section.offset < sizeof(SceneFileHeader) || section.offset > size || section.size > size - section.offset)
+				return "a scene section is outside of the file";
+		}
+
+		if (header.sections[SCENE_SECTION_SCENE].size != SCENE_SIZE)
+			return "the scene section has the wrong size";
+
+		if (header.sections[SCENE_SECTION_COMPONENTS].offset % COMPONENT_ALIGNMENT != 0 || header.sections[SCENE_SECTION_SPATIAL].offset % 16 != 0)
+			return "the scene components are not aligned";
+
+		if (header.sections[SCENE_SECTION_SCHEMA].offset % 8 != 0)
+			return "the scene schema is not aligned";
+
+		if (header.sections[SCENE_SECTION_NAMES].offset % 8 != 0)
+			return "the scene name table is not aligned";
+
+		return nullptr;
+	}
+
+	bool VerifySceneSection(const void* data, size_t section) {
+
+		const SceneFileHeader& header = *static_cast<const SceneFileHeader*>(data);
+		const SceneSectionInfo& info = header.sections[section];
+
+		return Checksum().bytes(static_cast<const uint8_t*>(data) + info.offset, info.size).result() == info.checksum;
+	}
+
+	bool VerifySceneSections(const void* data) {
+
+		for (size_t n = 0; n < SCENE_SECTION_COUNT; ++n) {
+			if (!VerifySceneSection(data, n))
+				return false;
+		}
+
+		return true;
+	}
+
+	const char* ValidateScenePackHeader(const void* data, size_t size, uint64_t schema_hash) {
+
+		if (const char* reason = ValidateScenePackHeader(data, size))
+			return reason;
+
+		if (static_cast<const ScenePackHeader*>(data)->schemaHash != schema_hash)
+			return "the scene pack was compiled for different components, the pack or the game needs rebuilding";
+
+		return nullptr;
+	}
+
+	const char* ValidateScenePackHeader(const void* data, size_t size) {
+
+		if (size < sizeof(ScenePackHeader))
+			return "the file is too small to be a scene pack";
+
+		if (uintptr_t(data) % 16 != 0)
+			return "scene pack data must be aligned to 16 bytes";
+
+		const ScenePackHeader& header = *static_cast<const ScenePackHeader*>(data);
+
+		if (header.magic != SCENE_PACK_MAGIC)
+			return "the file is not a scene pack";
+
+		if (header.version != SCENE_PACK_VERSION)
+			return "the scene pack was built for a different version of the format";
+
+		if (header.headerChecksum != ScenePackHeaderChecksum(header))
+			return "the scene pack header is corrupt";
+
+		if (header.fileSize != size)
+			return "the scene pack is truncated";
+
+		for (const SceneSectionInfo* section : {&header.entries, &header.names, &header.text}) {
+			if (section->offset < sizeof(ScenePackHeader) || section->offset > size || section->size > size - section->offset)
+				return "a scene pack section is outside of the file";
+		}
+
+		if (header.entries.size != header.sceneCount * sizeof(ScenePackEntry) || header.entries.offset % 8 != 0)
+			return "the scene pack table of contents is invalid";
+
+		return nullptr;
+	}
+
+	const ScenePackEntry* FindPackedScene(const void* data, const char* name) {
+
+		const uint8_t* pack = static_cast<const uint8_t*>(data);
+		const ScenePackHeader& header = *static_cast<const ScenePackHeader*>(data);
+
+		const ScenePackEntry* begin = reinterpret_cast<const ScenePackEntry*>(pack + header.entries.offset);
+		const ScenePackEntry* end = begin + header.sceneCount;
+
+		const uint64_t hash = ScenePackNameHash(name);
+
+		auto itr = std::lower_bound(begin, end, hash, [](const ScenePackEntry& entry, uint64_t h) {
+			return entry.nameHash < h;
+		});
+
+		// different names may share a hash, so check every entry with it
+		for (; itr != end && itr->nameHash == hash; ++itr) {
+			if (itr->nameOffset < header.fileSize && std::strcmp(reinterpret_cast<const char*>(pack + itr->nameOffset), name) == 0)
+				return itr;
+		}
+
+		return nullptr;
+	}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+*/
+
+namespace sg {
+
+	static const uint32_t SCENE_FILE_MAGIC = 0x43534753; // "SGSC"
+	static const uint32_t SCENE_FILE_VERSION = 6;
+
+	// sections of a compiled scene, in file order
+	static const size_t SCENE_SECTION_SCENE = 0; // the Scene structure from the generated header
+	static const size_t SCENE_SECTION_RANGES = 1; // ComponentRange[componentRangeCount]
+	static const size_t SCENE_SECTION_OFFSETS = 2; // a Ref to each component, in range order
+	static const size_t SCENE_SECTION_COMPONENTS = 3; // components in range order, aligned to 16 bytes
+	static const size_t SCENE_SECTION_SPATIAL = 4; // SceneSpatialIndex, empty when no component has a position
+	static const size_t SCENE_SECTION_NAMES = 5; // SceneNameTable, empty unless the scene was compiled with names
+	static const size_t SCENE_SECTION_SCHEMA = 6; // the layouts the scene was compiled with, see SceneSchema.h
+	static const size_t SCENE_SECTION_TEXT = 7; // SceneStrings, always last so packs can move it out
+	static const size_t SCENE_SECTION_COUNT = 8;
+
+	// sizes of the runtime structures in the generated header, pointers are always stored as 64 bit
+	static const uint64_t SCENE_SIZE = 32;
+	static const uint64_t COMPONENT_RANGE_SIZE = 8;
+	static const uint64_t COMPONENT_OFFSET_SIZE = 8;
+	static const uint64_t COMPONENT_ALIGNMENT = 16;
+
+	struct SceneSectionInfo {
+		uint64_t offset; // from the start of the file
+		uint64_t size;
+		uint64_t checksum; // Checksum of the section
+	};
+
+	// The first bytes of every compiled scene, section offsets are from the start of the file. Inside the sections,
+	// references are Refs from the generated header, offsets from the reference itself, so a scene can be used
+	// straight from a read only mapping.
+	struct SceneFileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t schemaHash; // SCHEMA_HASH of the generated code the scene was compiled for
+		uint64_t fileSize;
+		SceneSectionInfo sections[SCENE_SECTION_COUNT];
+		uint64_t headerChecksum; // Checksum of every byte before it
+		uint64_t reserved[2];
+	};
+
+	static_assert(sizeof(SceneFileHeader) == 240 && sizeof(SceneFileHeader) % 16 == 0, "SceneFileHeader must keep the sections after it aligned");
+
+	// strings in the text section start on this, so their hash can be read directly
+	static const uint64_t SCENE_STRING_ALIGNMENT = 8;
+
+	/*
+	Text is pooled, every distinct string is stored once in the text section, or once per pack, as a SceneString followed
+	by its characters and a null. Text members refer to the SceneString, so equal text has equal references, and text can
+	be looked up by its hash and length without reading it. The generated header has the same structure as String.
+	*/
+	struct SceneString {
+		uint64_t hash; // StringHash of the characters
+		uint32_t length; // without the null
+		uint32_t id; // strings are numbered from 0 in pool order, so they can index tables
+	};
+
+	static_assert(sizeof(SceneString) % SCENE_STRING_ALIGNMENT == 0, "SceneString must keep its characters aligned");
+
+	// the bytes a string takes in a pool, padding included
+	uint64_t SceneStringSize(size_t length);
+
+	// writes SceneStringSize(length) bytes to dest
+	void WriteSceneString(const char* text, size_t length, uint32_t id, uint8_t* dest);
+
+	static const uint32_t SCENE_PACK_MAGIC = 0x4b504753; // "SGPK"
+	static const uint32_t SCENE_PACK_VERSION = 3;
+
+	// scenes in a pack start on their own page, so using one scene never reads another
+	static const uint64_t SCENE_PACK_ALIGNMENT = 4096;
+
+	struct ScenePackEntry {
+		uint64_t nameHash; // ScenePackNameHash of the name, entries are sorted by it
+		uint64_t nameOffset; // null terminated, from the start of the pack
+		uint64_t offset; // of a complete scene file, from the start of the pack
+		uint64_t size;
+	};
+
+	/*
+	Many scenes in one file. Each scene is a scene file as described above, except that text is pooled once for the whole
+	pack in the text section, and the Refs to it point outside of the scene.
+	*/
+	struct ScenePackHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t schemaHash;
+		uint64_t fileSize;
+		uint64_t sceneCount;
+		SceneSectionInfo entries; // ScenePackEntry[sceneCount]
+		SceneSectionInfo names;
+		SceneSectionInfo text;
+		uint64_t headerChecksum; // Checksum of every byte before it
+		uint64_t reserved[2];
+	};
+
+	static_assert(sizeof(ScenePackHeader) % 16 == 0, "ScenePackHeader must keep the sections after it aligned");
+
+	uint64_t SceneHeaderChecksum(const SceneFileHeader& header);
+	uint64_t ScenePackHeaderChecksum(const ScenePackHeader& header);
+	uint64_t ScenePackNameHash(const char* name);
+
+	// Only looks at the header, so it is cheap enough to run on every load. Returns nullptr when the file can be used,
+	// otherwise the reason it can't.
+	const char* ValidateSceneHeader(const void* data, size_t size, uint64_t schema_hash);
+
+	// The same checks except for the schema, for scenes that will be converted with ConvertScene when it differs.
+	const char* ValidateSceneHeader(const void* data, size_t size);
+
+	// Checks the contents of a section against its checksum, the header must already be valid.
+	bool VerifySceneSection(const void* data, size_t section);
+
+	bool VerifySceneSections(const void* data);
+
+	// The pack equivalent of ValidateSceneHeader, every scene still needs to be validated before it is used.
+	const char* ValidateScenePackHeader(const void* data, size_t size, uint64_t schema_hash);
+	const char* ValidateScenePackHeader(const void* data, size_t size);
+
+	// A binary search of the entries, nullptr when the pack has no scene with that name.
+	const ScenePackEntry* FindPackedScene(const void* data, const char* name);
+}
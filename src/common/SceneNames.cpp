@@ -0,0 +1,194 @@
+#include "SceneNames.h"
+#include "SceneFormat.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sg {
+
+	// about this many entries per bucket, fewer makes building quicker and the table larger
+	static const uint64_t NAME_BUCKET_OCCUPANCY = 3;
+
+	static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static uint64_t BucketCount(uint64_t entry_count) {
+		return (entry_count + NAME_BUCKET_OCCUPANCY - 1) / NAME_BUCKET_OCCUPANCY;
+	}
+
+	static uint64_t HashesOffset() {
+		return AlignUp(sizeof(SceneNameTable), 8);
+	}
+
+	static uint64_t ComponentsOffset(uint64_t entry_count) {
+		return HashesOffset() + entry_count * sizeof(uint64_t);
+	}
+
+	static uint64_t DisplacementsOffset(uint64_t entry_count) {
+		return ComponentsOffset(entry_count) + entry_count * sizeof(uint32_t);
+	}
+
+	// StringHash is FNV-1a, which doesn't spread short paths over every bit, so it is mixed before use
+	static inline uint64_t MixHash(uint64_t h) {
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	// the high 32 bits of h scaled to [0, count), which is cheaper than a division
+	static inline uint32_t Reduce(uint64_t h, uint32_t count) {
+		return uint32_t(((h >> 32) * count) >> 32);
+	}
+
+	// the low 32 bits, so the bucket and the slot don't depend on each other
+	static inline uint32_t BucketOf(uint64_t mixed, uint32_t bucket_count) {
+		return uint32_t((uint64_t(uint32_t(mixed)) * bucket_count) >> 32);
+	}
+
+	static inline uint32_t SlotOf(uint64_t mixed, uint32_t displacement, uint32_t entry_count) {
+		return Reduce(MixHash(mixed ^ (uint64_t(displacement) * 0x9e3779b97f4a7c15ull)), entry_count);
+	}
+
+	uint64_t SceneNameTableSize(uint64_t entry_count) {
+
+		if (entry_count == 0)
+			return 0;
+
+		return AlignUp(DisplacementsOffset(entry_count) + BucketCount(entry_count) * sizeof(uint32_t), 16);
+	}
+
+	bool BuildSceneNameTable(std::vector<SceneNameEntry> entries, uint8_t* dest) {
+
+		if (entries.empty())
+			return true;
+
+		SceneNameTable table = {};
+		table.entryCount = uint32_t(entries.size());
+		table.bucketCount = uint32_t(BucketCount(entries.size()));
+
+		// the entries grouped by bucket, so placing a bucket reads its entries from one place
+		struct Placing {
+			uint64_t mixed;
+			uint32_t entry;
+		};
+
+		std::vector<uint32_t> bucket_starts(table.bucketCount + 1, 0);
+		for (const SceneNameEntry& entry : entries) {
+			++bucket_starts[BucketOf(MixHash(entry.hash), table.bucketCount) + 1];
+		}
+
+		uint32_t largest = 0;
+		for (size_t n = 1; n < bucket_starts.size(); ++n) {
+			largest = std::max(largest, bucket_starts[n]);
+			bucket_starts[n] += bucket_starts[n - 1];
+		}
+
+		std::vector<Placing> placing(entries.size());
+		{
+			std::vector<uint32_t> filled(bucket_starts.begin(), bucket_starts.end() - 1);
+			for (uint32_t n = 0; n < table.entryCount; ++n) {
+				const uint64_t mixed = MixHash(entries[n].hash);
+				placing[filled[BucketOf(mixed, table.bucketCount)]++] = {mixed, n};
+			}
+		}
+
+		// the largest buckets are placed first, while most slots are still free. Buckets of a size are kept in order, so
+		// placing them walks through placing from front to back.
+		std::vector<uint32_t> buckets;
+		buckets.reserve(table.bucketCount);
+		for (uint32_t size = largest; size > 0; --size) {
+			for (uint32_t n = 0; n < table.bucketCount; ++n) {
+				if (bucket_starts[n + 1] - bucket_starts[n] == size)
+					buckets.push_back(n);
+			}
+		}
+
+		std::vector<uint64_t> hashes(entries.size(), 0);
+		std::vector<uint32_t> components(entries.size(), NO_SCENE_NAME);
+		std::vector<uint32_t> displacements(table.bucketCount, 0);
+		std::vector<bool> taken(entries.size(), false);
+		std::vector<uint32_t> slots;
+
+		for (uint32_t bucket : buckets) {
+
+			const uint32_t begin = bucket_starts[bucket];
+			const uint32_t end = bucket_starts[bucket + 1];
+
+			// paths with the same hash always share a bucket, and no displacement could tell them apart
+			for (uint32_t n = begin; n < end; ++n) {
+				for (uint32_t other = begin; other < n; ++other) {
+					if (entries[placing[n].entry].hash == entries[placing[other].entry].hash)
+						return false;
+				}
+			}
+
+			// every bucket finds a displacement eventually, since the table has a free slot for each entry left
+			for (uint32_t displacement = 0;; ++displacement) {
+
+				slots.clear();
+				for (uint32_t n = begin; n < end; ++n) {
+					const uint32_t slot = SlotOf(placing[n].mixed, displacement, table.entryCount);
+					if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+						break;
+
+					slots.push_back(slot);
+				}
+
+				if (slots.size() != end - begin)
+					continue;
+
+				for (uint32_t n = begin; n < end; ++n) {
+					const SceneNameEntry& entry = entries[placing[n].entry];
+					const uint32_t slot = slots[n - begin];
+
+					taken[slot] = true;
+					hashes[slot] = entry.hash;
+					components[slot] = entry.component;
+				}
+
+				displacements[bucket] = displacement;
+				break;
+			}
+		}
+
+		std::memset(dest, 0, size_t(SceneNameTableSize(entries.size())));
+		std::memcpy(dest, &table, sizeof(table));
+		std::memcpy(dest + HashesOffset(), hashes.data(), hashes.size() * sizeof(uint64_t));
+		std::memcpy(dest + ComponentsOffset(entries.size()), components.data(), components.size() * sizeof(uint32_t));
+		std::memcpy(dest + DisplacementsOffset(entries.size()), displacements.data(), displacements.size() * sizeof(uint32_t));
+		return true;
+	}
+
+	const SceneNameTable* FindSceneNameTable(const void* data) {
+
+		const SceneFileHeader& header = *static_cast<const SceneFileHeader*>(data);
+		const SceneSectionInfo& section = header.sections[SCENE_SECTION_NAMES];
+
+		if (section.size < sizeof(SceneNameTable))
+			return nullptr;
+
+		const SceneNameTable* table = reinterpret_cast<const SceneNameTable*>(static_cast<const uint8_t*>(data) + section.offset);
+
+		if (table->entryCount == 0 || SceneNameTableSize(table->entryCount) != section.size || BucketCount(table->entryCount) != table->bucketCount)
+			return nullptr;
+
+		return table;
+	}
+
+	uint32_t LookupSceneName(const SceneNameTable& table, uint64_t hash) {
+
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(&table);
+		const uint64_t* hashes = reinterpret_cast<const uint64_t*>(base + HashesOffset());
+		const uint32_t* components = reinterpret_cast<const uint32_t*>(base + ComponentsOffset(table.entryCount));
+		const uint32_t* displacements = reinterpret_cast<const uint32_t*>(base + DisplacementsOffset(table.entryCount));
+
+		const uint64_t mixed = MixHash(hash);
+		const uint32_t slot = SlotOf(mixed, displacements[BucketOf(mixed, table.bucketCount)], table.entryCount);
+
+		return hashes[slot] == hash ? components[slot] : NO_SCENE_NAME;
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+*/
+
+namespace sg {
+
+	struct SceneNameEntry {
+		uint64_t hash; // StringHash of the path of a component, "Child/Grandchild/Component"
+		uint32_t component; // index into Scene::components
+	};
+
+	/*
+	The start of the names section, a minimal perfect hash table from the path of a component to its index. The hash of
+	a path picks a bucket, the bucket's displacement picks the one slot the path can be in, so a lookup reads a
+	displacement and a slot and never probes. Followed by:
+		uint64_t hashes[entryCount], the path hash in each slot, to tell paths that aren't in the table apart
+		uint32_t components[entryCount]
+		uint32_t displacements[bucketCount]
+	*/
+	struct SceneNameTable {
+		uint32_t entryCount;
+		uint32_t bucketCount;
+	};
+
+	static_assert(sizeof(SceneNameTable) == 8, "SceneNameTable is part of the scene format");
+
+	static const uint32_t NO_SCENE_NAME = ~0u;
+
+	// The size of the names section for a number of entries, only depends on the count so the section can be laid out
+	// before any path is known. 0 entries need no section at all.
+	uint64_t SceneNameTableSize(uint64_t entry_count);
+
+	// Writes the section for the entries to dest, which must be SceneNameTableSize(entries.size()) bytes. Returns false
+	// when two entries have the same hash, they could never be told apart.
+	bool BuildSceneNameTable(std::vector<SceneNameEntry> entries, uint8_t* dest);
+
+	// The name table of a scene file that passed ValidateSceneHeader, nullptr if the scene was compiled without one.
+	const SceneNameTable* FindSceneNameTable(const void* data);
+
+	// The index into Scene::components of the component with a path, NO_SCENE_NAME when there is none. Take the hash
+	// with StringHash, which is constexpr, so paths known up front cost nothing to hash.
+	uint32_t LookupSceneName(const SceneNameTable& table, uint64_t hash);
+}
@@ -0,0 +1,356 @@
+#include "SceneSchema.h"
+#include "SceneFormat.h"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace sg {
+
+	// deeper than any schema the editor produces, it only stops a malformed one from recursing forever
+	static const uint32_t MAX_NESTING = 32;
+
+	static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static uint64_t SchemaSize(uint64_t type_count, uint64_t member_count) {
+		return sizeof(SceneSchemaHeader) + type_count * sizeof(SceneSchemaType) + member_count * sizeof(SceneSchemaMember);
+	}
+
+	uint64_t SceneSchemaSize(const SceneSchema& schema) {
+		return SchemaSize(schema.typeCount, schema.memberCount);
+	}
+
+	void WriteSceneSchema(const SceneSchema& schema, uint8_t* dest) {
+
+		const SceneSchemaHeader header = {schema.hash, schema.typeCount, schema.memberCount};
+		std::memcpy(dest, &header, sizeof(header));
+		dest += sizeof(header);
+
+		std::memcpy(dest, schema.types, schema.typeCount * sizeof(SceneSchemaType));
+		dest += schema.typeCount * sizeof(SceneSchemaType);
+
+		std::memcpy(dest, schema.members, schema.memberCount * sizeof(SceneSchemaMember));
+	}
+
+	bool FindSceneSchema(const void* data, SceneSchema& schema) {
+
+		const SceneFileHeader& file_header = *static_cast<const SceneFileHeader*>(data);
+		const SceneSectionInfo& section = file_header.sections[SCENE_SECTION_SCHEMA];
+
+		if (section.size < sizeof(SceneSchemaHeader))
+			return false;
+
+		const uint8_t* base = static_cast<const uint8_t*>(data) + section.offset;
+
+		SceneSchemaHeader header;
+		std::memcpy(&header, base, sizeof(header));
+
+		if (SchemaSize(header.typeCount, header.memberCount) != section.size)
+			return false;
+
+		schema.hash = header.hash;
+		schema.typeCount = header.typeCount;
+		schema.types = reinterpret_cast<const SceneSchemaType*>(base + sizeof(SceneSchemaHeader));
+		schema.memberCount = header.memberCount;
+		schema.members = reinterpret_cast<const SceneSchemaMember*>(schema.types + header.typeCount);
+
+		for (uint32_t n = 0; n < schema.typeCount; ++n) {
+			const SceneSchemaType& type = schema.types[n];
+
+			if (type.firstMember > schema.memberCount || schema.memberCount - type.firstMember < type.memberCount)
+				return false;
+
+			for (uint32_t m = type.firstMember; m < type.firstMember + type.memberCount; ++m) {
+				if (type.size != 0 && (schema.members[m].offset > type.size || schema.members[m].size > type.size - schema.members[m].offset))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	enum class CopyKind : uint32_t {
+		Bytes,
+		Text, // a Ref to the text, which stays in the file
+		ComponentRef, // a Ref to a component, which moves
+	};
+
+	struct CopyStep {
+		uint32_t dest; // offset in the target component
+		uint32_t source; // offset in the source component
+		uint32_t size;
+		CopyKind kind;
+	};
+
+	static const SceneSchemaType* FindType(const SceneSchema& schema, uint64_t name_hash, uint32_t& index) {
+
+		for (index = 0; index < schema.typeCount; ++index) {
+			if (schema.types[index].nameHash == name_hash)
+				return &schema.types[index];
+		}
+
+		return nullptr;
+	}
+
+	static const SceneSchemaMember* FindMember(const SceneSchema& schema, const SceneSchemaType& type, uint64_t name_hash) {
+
+		for (uint32_t n = type.firstMember; n < type.firstMember + type.memberCount; ++n) {
+			if (schema.members[n].nameHash == name_hash)
+				return &schema.members[n];
+		}
+
+		return nullptr;
+	}
+
+	// appends the steps that fill a target component, or a component nested in one, from a source component
+	static void PlanType(const SceneSchema& target, const SceneSchemaType& target_type, uint32_t dest_base,
+		const SceneSchema& source, const SceneSchemaType& source_type, uint32_t source_base, uint32_t depth, std::vector<CopyStep>& steps) {
+
+		if (depth > MAX_NESTING)
+			return;
+
+		for (uint32_t n = target_type.firstMember; n < target_type.firstMember + target_type.memberCount; ++n) {
+
+			const SceneSchemaMember& tm = target.members[n];
+			const SceneSchemaMember* sm = FindMember(source, source_type, tm.nameHash);
+
+			// a member that was added, or changed type, keeps its zero
+			if (!sm || sm->typeHash != tm.typeHash || sm->targetHash != tm.targetHash)
+				continue;
+
+			const uint32_t dest = dest_base + tm.offset;
+			const uint32_t from = source_base + sm->offset;
+
+			if (tm.typeHash == SCHEMA_TYPE_COMPONENT) {
+
+				// the nested component may have changed too, so it is matched member by member
+				uint32_t index;
+				const SceneSchemaType* target_nested = FindType(target, tm.targetHash, index);
+				const SceneSchemaType* source_nested = FindType(source, sm->targetHash, index);
+
+				if (target_nested && source_nested && target_nested->size <= tm.size && source_nested->size <= sm->size)
+					PlanType(target, *target_nested, dest, source, *source_nested, from, depth + 1, steps);
+
+				continue;
+			}
+
+			if (sm->size != tm.size)
+				continue;
+
+			CopyKind kind = CopyKind::Bytes;
+			if (tm.typeHash == SCHEMA_TYPE_TEXT)
+				kind = CopyKind::Text;
+			else if (tm.typeHash == SCHEMA_TYPE_COMPONENT_REF)
+				kind = CopyKind::ComponentRef;
+
+			// members that were next to each other still are unless one was inserted between them, one copy does both
+			if (kind == CopyKind::Bytes && !steps.empty()) {
+				CopyStep& last = steps.back();
+
+				if (last.kind == CopyKind::Bytes && last.dest + last.size == dest && last.source + last.size == from) {
+					last.size += tm.size;
+					continue;
+				}
+			}
+
+			steps.push_back({dest, from, tm.size, kind});
+		}
+	}
+
+	struct CopyPlan {
+		bool kept = false;
+		uint32_t targetTypeId = 0;
+		uint32_t targetSize = 0;
+		const void* defaults = nullptr; // the target's Default, which the steps are copied over
+		std::vector<CopyStep> steps;
+	};
+
+	static int64_t LoadRef(const uint8_t* p) {
+		int64_t ref;
+		std::memcpy(&ref, p, sizeof(ref));
+		return ref;
+	}
+
+	const char* ConvertScene(const void* data, const SceneSchema& target, std::vector<SceneBlock>& result, bool& kept_all) {
+
+		SceneSchema source;
+		if (!FindSceneSchema(data, source))
+			return "the scene was compiled for different components and has no usable schema to convert it with";
+
+		const uint8_t* file = static_cast<const uint8_t*>(data);
+		const SceneFileHeader& header = *static_cast<const SceneFileHeader*>(data);
+		const SceneSectionInfo& ranges = header.sections[SCENE_SECTION_RANGES];
+		const SceneSectionInfo& offsets = header.sections[SCENE_SECTION_OFFSETS];
+		const SceneSectionInfo& components = header.sections[SCENE_SECTION_COMPONENTS];
+
+		const uint64_t range_count = ranges.size / COMPONENT_RANGE_SIZE;
+		const uint64_t component_count = offsets.size / COMPONENT_OFFSET_SIZE;
+
+		// a plan per source type, made the first time a range of it is seen
+		std::vector<CopyPlan> plans(source.typeCount);
+		std::vector<bool> planned(source.typeCount, false);
+		bool has_component_refs = false;
+
+		uint64_t kept_ranges = 0;
+		uint64_t kept_components = 0;
+		uint64_t component_bytes = 0;
+		uint64_t total = 0;
+
+		kept_all = true;
+
+		for (uint64_t r = 0; r < range_count; ++r) {
+
+			uint32_t range[2]; // typeId, count
+			std::memcpy(range, file + ranges.offset + r * COMPONENT_RANGE_SIZE, sizeof(range));
+
+			if (range[0] >= source.typeCount)
+				return "the scene has a component type its schema doesn't describe";
+
+			total += range[1];
+
+			CopyPlan& plan = plans[range[0]];
+
+			if (!planned[range[0]]) {
+				planned[range[0]] = true;
+
+				const SceneSchemaType& source_type = source.types[range[0]];
+				const SceneSchemaType* target_type = FindType(target, source_type.nameHash, plan.targetTypeId);
+
+				if (target_type && target_type->size != 0 && target_type->size % COMPONENT_ALIGNMENT == 0 && source_type.size != 0) {
+					plan.kept = true;
+					plan.targetSize = target_type->size;
+					plan.defaults = target.defaults ? target.defaults[plan.targetTypeId] : nullptr;
+					PlanType(target, *target_type, 0, source, source_type, 0, 0, plan.steps);
+
+					for (const CopyStep& step : plan.steps) {
+						has_component_refs = has_component_refs || step.kind == CopyKind::ComponentRef;
+					}
+				}
+			}
+
+			if (!plan.kept) {
+				kept_all = false;
+				continue;
+			}
+
+			kept_ranges++;
+			kept_components += range[1];
+			component_bytes += uint64_t(range[1]) * plan.targetSize;
+		}
+
+		if (total != component_count || ranges.size % COMPONENT_RANGE_SIZE != 0)
+			return "the scene ranges don't match its components";
+
+		// the same layout as a compiled scene, without the file header
+		const uint64_t ranges_offset = SCENE_SIZE;
+		const uint64_t offsets_offset = ranges_offset + kept_ranges * COMPONENT_RANGE_SIZE;
+		const uint64_t components_offset = AlignUp(offsets_offset + kept_components * COMPONENT_OFFSET_SIZE, COMPONENT_ALIGNMENT);
+		const uint64_t size = components_offset + component_bytes;
+
+		result.assign(size_t(size / sizeof(SceneBlock) + 1), SceneBlock{});
+		uint8_t* out = result.front().bytes;
+
+		// finds each source component, and records where it goes when something can refer to it
+		std::unordered_map<uint64_t, uint64_t> moved;
+		auto source_component = [&](uint64_t index, uint32_t source_size, uint64_t& offset) {
+			const uint64_t entry = offsets.offset + index * COMPONENT_OFFSET_SIZE;
+			offset = entry + uint64_t(LoadRef(file + entry));
+			return offset >= components.offset && offset <= components.offset + components.size && source_size <= components.offset + components.size - offset;
+		};
+
+		if (has_component_refs) {
+			uint64_t index = 0;
+			uint64_t dest = components_offset;
+
+			for (uint64_t r = 0; r < range_count; ++r) {
+				uint32_t range[2];
+				std::memcpy(range, file + ranges.offset + r * COMPONENT_RANGE_SIZE, sizeof(range));
+
+				const CopyPlan& plan = plans[range[0]];
+				for (uint32_t n = 0; n < range[1]; ++n, ++index) {
+					uint64_t offset;
+					if (plan.kept && source_component(index, source.types[range[0]].size, offset)) {
+						moved[offset] = dest;
+						dest += plan.targetSize;
+					}
+				}
+			}
+		}
+
+		uint64_t index = 0;
+		uint64_t range_out = ranges_offset;
+		uint64_t offset_out = offsets_offset;
+		uint64_t dest = components_offset;
+
+		for (uint64_t r = 0; r < range_count; ++r) {
+
+			uint32_t range[2];
+			std::memcpy(range, file + ranges.offset + r * COMPONENT_RANGE_SIZE, sizeof(range));
+
+			const CopyPlan& plan = plans[range[0]];
+			const uint32_t source_size = source.types[range[0]].size;
+
+			if (!plan.kept) {
+				index += range[1];
+				continue;
+			}
+
+			const uint32_t out_range[2] = {plan.targetTypeId, range[1]};
+			std::memcpy(out + range_out, out_range, sizeof(out_range));
+			range_out += COMPONENT_RANGE_SIZE;
+
+			for (uint32_t n = 0; n < range[1]; ++n, ++index) {
+
+				uint64_t from;
+				if (!source_component(index, source_size, from))
+					return "a component is outside of the scene";
+
+				// the offset table holds Refs, which are relative to themselves
+				const int64_t entry = int64_t(dest - offset_out);
+				std::memcpy(out + offset_out, &entry, sizeof(entry));
+				offset_out += COMPONENT_OFFSET_SIZE;
+
+				// members the steps don't fill keep their default
+				if (plan.defaults)
+					std::memcpy(out + dest, plan.defaults, plan.targetSize);
+
+				for (const CopyStep& step : plan.steps) {
+
+					uint8_t* to = out + dest + step.dest;
+					const uint8_t* at = file + from + step.source;
+
+					if (step.kind == CopyKind::Bytes) {
+						std::memcpy(to, at, step.size);
+						continue;
+					}
+
+					const int64_t ref = LoadRef(at);
+					if (ref == 0)
+						continue;
+
+					int64_t rebased = 0;
+
+					if (step.kind == CopyKind::Text) {
+						// text stays where it is, which for packed scenes is outside of the scene
+						rebased = int64_t(intptr_t(at) + ref - intptr_t(to));
+					} else {
+						auto target_itr = moved.find(from + step.source + uint64_t(ref));
+						if (target_itr != moved.end())
+							rebased = int64_t(target_itr->second - (dest + step.dest));
+					}
+
+					std::memcpy(to, &rebased, sizeof(rebased));
+				}
+
+				dest += plan.targetSize;
+			}
+		}
+
+		// components, componentCount, componentRanges, componentRangeCount, the Refs are relative to their own field
+		const uint64_t scene[] = {offsets_offset, kept_components, ranges_offset - 16, kept_ranges};
+		std::memcpy(out, scene, sizeof(scene));
+
+		return nullptr;
+	}
+}
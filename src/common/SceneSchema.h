@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+*/
+
+namespace sg {
+
+	// the SG Edit property types a converted scene treats specially, every other type is copied as bytes
+	static const uint64_t SCHEMA_TYPE_TEXT = StringHash("text", 4);
+	static const uint64_t SCHEMA_TYPE_COMPONENT = StringHash("component", 9);
+	static const uint64_t SCHEMA_TYPE_COMPONENT_REF = StringHash("component_ref", 13);
+
+	struct SceneSchemaType {
+		uint64_t nameHash; // StringHash of the component name
+		uint32_t size; // 0 when the component can't be compiled into a scene
+		uint32_t firstMember;
+		uint32_t memberCount;
+		uint32_t reserved;
+	};
+
+	struct SceneSchemaMember {
+		uint64_t nameHash; // StringHash of the property name
+		uint64_t typeHash; // StringHash of the SG Edit type, e.g. "f32"
+		uint64_t targetHash; // StringHash of the component a component or component_ref refers to, for an enum a hash of its name and values, otherwise 0
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	/*
+	The start of the schema section, the layouts of every component a scene was compiled for, in TypeId order. Followed
+	by:
+		SceneSchemaType types[typeCount]
+		SceneSchemaMember members[memberCount], the members of each type are together and in declaration order
+	*/
+	struct SceneSchemaHeader {
+		uint64_t hash; // the SCHEMA_HASH of the generated code
+		uint32_t typeCount;
+		uint32_t memberCount;
+	};
+
+	static_assert(sizeof(SceneSchemaType) == 24 && sizeof(SceneSchemaMember) == 32 && sizeof(SceneSchemaHeader) == 16, "The schema is part of the scene format");
+
+	// A schema read from a scene, or the one the generated code was built with.
+	struct SceneSchema {
+		uint64_t hash = 0;
+		const SceneSchemaType* types = nullptr;
+		uint32_t typeCount = 0;
+		const SceneSchemaMember* members = nullptr;
+		uint32_t memberCount = 0;
+
+		// the generated Default of each type, nullptr for types without one. Only the schema a scene is converted to has
+		// them, scene files don't.
+		const void* const* defaults = nullptr;
+	};
+
+	uint64_t SceneSchemaSize(const SceneSchema& schema);
+
+	// writes SceneSchemaSize(schema) bytes to dest
+	void WriteSceneSchema(const SceneSchema& schema, uint8_t* dest);
+
+	// The schema of a scene file that passed ValidateSceneHeader, false if the section is malformed.
+	bool FindSceneSchema(const void* data, SceneSchema& schema);
+
+	// 16 bytes at a time, so a converted scene has the alignment of a mapped one
+	struct alignas(16) SceneBlock {
+		uint8_t bytes[16];
+	};
+
+	/*
+	Rebuilds the Scene of a file compiled for other components with the layouts of target. Components are matched by
+	name, members by name and type. Members that are new or whose type changed are left at the target's default, or
+	zeroed when it has none, and components the target doesn't have are dropped along with references to them. Each component type gets a copy plan once, so the cost per
+	component is a few copies. The result starts with the Scene, text is still read from the file, so it must stay
+	mapped. kept_all is false when components were dropped, so indices into Scene::components have changed. Returns
+	nullptr on success, otherwise the reason the scene can't be converted.
+	*/
+	const char* ConvertScene(const void* data, const SceneSchema& target, std::vector<SceneBlock>& result, bool& kept_all);
+}
@@ -0,0 +1,191 @@
+#include "SceneSpatial.h"
+#include "SceneFormat.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace sg {
+
+	// about this many components per cell
+	static const uint64_t SPATIAL_CELL_OCCUPANCY = 4;
+	static const uint64_t SPATIAL_MAX_CELLS = uint64_t(1) << 22;
+
+	static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static uint64_t CellCapacity(uint64_t entry_count) {
+
+		uint64_t cells = 1;
+		while (cells * SPATIAL_CELL_OCCUPANCY < entry_count && cells < SPATIAL_MAX_CELLS) {
+			cells *= 2;
+		}
+
+		return cells;
+	}
+
+	static uint64_t EntriesOffset(uint64_t cell_capacity) {
+		return AlignUp(sizeof(SceneSpatialIndex) + (cell_capacity + 2) * sizeof(uint32_t), 16);
+	}
+
+	uint64_t SceneSpatialIndexSize(uint64_t entry_count) {
+
+		if (entry_count == 0)
+			return 0;
+
+		return AlignUp(EntriesOffset(CellCapacity(entry_count)) + entry_count * sizeof(SceneSpatialEntry), 16);
+	}
+
+	void BuildSceneSpatialIndex(std::vector<SceneSpatialEntry> entries, uint8_t* dest) {
+
+		if (entries.empty())
+			return;
+
+		SceneSpatialIndex index = {};
+		index.cellCapacity = uint32_t(CellCapacity(entries.size()));
+		index.entryCount = uint32_t(entries.size());
+
+		SceneBounds world = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+		std::vector<float> extents;
+		extents.reserve(entries.size());
+
+		for (const SceneSpatialEntry& e : entries) {
+			const float extent = std::max(e.bounds.maxX - e.bounds.minX, e.bounds.maxY - e.bounds.minY);
+
+			// components that cover everything are always large, they would only stretch the grid
+			if (!std::isfinite(extent))
+				continue;
+
+			world.minX = std::min(world.minX, e.bounds.minX);
+			world.minY = std::min(world.minY, e.bounds.minY);
+			world.maxX = std::max(world.maxX, e.bounds.maxX);
+			world.maxY = std::max(world.maxY, e.bounds.maxY);
+			extents.push_back(extent);
+		}
+
+		if (extents.empty()) {
+			world = {0.0f, 0.0f, 0.0f, 0.0f};
+			extents.push_back(0.0f);
+		}
+
+		const float width = std::max(world.maxX - world.minX, 1.0f);
+		const float height = std::max(world.maxY - world.minY, 1.0f);
+
+		// square cells covering the world with the cells available, but no smaller than most components so only a few
+		// end up in the list of large ones
+		std::nth_element(extents.begin(), extents.begin() + extents.size() * 95 / 100, extents.end());
+		const float common_extent = extents[extents.size() * 95 / 100];
+
+		index.cellSize = std::max(std::sqrt(width * height / float(index.cellCapacity)), common_extent);
+		index.cellSize = std::max(index.cellSize, 1e-3f);
+
+		// the grid may need an extra column or row when the cell size was rounded, never more cells than reserved
+		while (true) {
+			const float columns = std::floor(width / index.cellSize) + 1.0f;
+			const float rows = std::floor(height / index.cellSize) + 1.0f;
+
+			if (columns * rows <= float(index.cellCapacity)) {
+				index.columns = uint32_t(columns);
+				index.rows = uint32_t(rows);
+				break;
+			}
+
+			index.cellSize *= 1.25f;
+		}
+
+		index.minX = world.minX;
+		index.minY = world.minY;
+
+		// the large components go in the cell after the last one
+		const uint32_t large_cell = index.cellCapacity;
+
+		// negated, so bounds that aren't numbers are large as well, rather than cast to a cell
+		auto cell_of = [&](const SceneSpatialEntry& e) -> uint32_t {
+			if (!(e.bounds.maxX - e.bounds.minX <= index.cellSize) || !(e.bounds.maxY - e.bounds.minY <= index.cellSize))
+				return large_cell;
+
+			const uint32_t column = std::min(uint32_t((e.bounds.minX - index.minX) / index.cellSize), index.columns - 1);
+			const uint32_t row = std::min(uint32_t((e.bounds.minY - index.minY) / index.cellSize), index.rows - 1);
+			return row * index.columns + column;
+		};
+
+		std::vector<uint32_t> cell_starts(index.cellCapacity + 2, 0);
+		for (const SceneSpatialEntry& e : entries) {
+			++cell_starts[cell_of(e) + 1];
+		}
+
+		for (size_t n = 1; n < cell_starts.size(); ++n) {
+			cell_starts[n] += cell_starts[n - 1];
+		}
+
+		std::stable_sort(entries.begin(), entries.end(), [&](const SceneSpatialEntry& a, const SceneSpatialEntry& b) {
+			const uint32_t cell_a = cell_of(a);
+			const uint32_t cell_b = cell_of(b);
+			return cell_a != cell_b ? cell_a < cell_b : a.component < b.component;
+		});
+
+		const uint64_t entries_offset = EntriesOffset(index.cellCapacity);
+
+		std::memset(dest, 0, size_t(SceneSpatialIndexSize(entries.size())));
+		std::memcpy(dest, &index, sizeof(index));
+		std::memcpy(dest + sizeof(index), cell_starts.data(), cell_starts.size() * sizeof(uint32_t));
+		std::memcpy(dest + entries_offset, entries.data(), entries.size() * sizeof(SceneSpatialEntry));
+	}
+
+	const SceneSpatialIndex* FindSceneSpatialIndex(const void* data) {
+
+		const SceneFileHeader& header = *static_cast<const SceneFileHeader*>(data);
+		const SceneSectionInfo& section = header.sections[SCENE_SECTION_SPATIAL];
+
+		if (section.size < sizeof(SceneSpatialIndex))
+			return nullptr;
+
+		const SceneSpatialIndex* index = reinterpret_cast<const SceneSpatialIndex*>(static_cast<const uint8_t*>(data) + section.offset);
+
+		if (index->entryCount == 0 || SceneSpatialIndexSize(index->entryCount) != section.size || CellCapacity(index->entryCount) != index->cellCapacity ||
+			uint64_t(index->columns) * index->rows > index->cellCapacity || !(index->cellSize > 0.0f))
+			return nullptr;
+
+		return index;
+	}
+
+	void QuerySceneSpatialIndex(const SceneSpatialIndex& index, const SceneBounds& area, std::vector<uint32_t>& result) {
+
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(&index);
+		const uint32_t* cell_starts = reinterpret_cast<const uint32_t*>(base + sizeof(SceneSpatialIndex));
+		const SceneSpatialEntry* entries = reinterpret_cast<const SceneSpatialEntry*>(base + EntriesOffset(index.cellCapacity));
+
+		auto visit = [&](uint32_t cell) {
+			for (uint32_t n = cell_starts[cell]; n < cell_starts[cell + 1]; ++n) {
+				if (entries[n].bounds.overlaps(area))
+					result.push_back(entries[n].component);
+			}
+		};
+
+		visit(index.cellCapacity);
+
+		// a component reaches up to one cell past the cell of its minimum corner, so start a cell early
+		const float first_column = std::floor((area.minX - index.minX) / index.cellSize) - 1.0f;
+		const float last_column = std::floor((area.maxX - index.minX) / index.cellSize);
+		const float first_row = std::floor((area.minY - index.minY) / index.cellSize) - 1.0f;
+		const float last_row = std::floor((area.maxY - index.minY) / index.cellSize);
+
+		// an area that isn't a number overlaps nothing, negated so it never reaches the casts
+		if (!(last_column >= 0.0f && last_row >= 0.0f && first_column < float(index.columns) && first_row < float(index.rows)))
+			return;
+
+		// components past the edge of the grid were clamped into the last column or row
+		const uint32_t column_begin = uint32_t(std::max(first_column, 0.0f));
+		const uint32_t column_end = uint32_t(std::min(last_column, float(index.columns - 1))) + 1;
+		const uint32_t row_begin = uint32_t(std::max(first_row, 0.0f));
+		const uint32_t row_end = uint32_t(std::min(last_row, float(index.rows - 1))) + 1;
+
+		for (uint32_t row = row_begin; row < row_end; ++row) {
+			for (uint32_t column = column_begin; column < column_end; ++column) {
+				visit(row * index.columns + column);
+			}
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+*/
+
+namespace sg {
+
+	struct SceneBounds {
+		float minX;
+		float minY;
+		float maxX;
+		float maxY;
+
+		bool overlaps(const SceneBounds& other) const {
+			return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+		}
+	};
+
+	struct SceneSpatialEntry {
+		uint32_t component; // index into Scene::components
+		SceneBounds bounds;
+	};
+
+	/*
+	The start of the spatial section, a uniform grid over every component with a position. A component is stored in
+	the cell its minimum corner is in, so a component reaches at most one cell past its own. Components larger than a
+	cell are kept in a separate list that every query checks. Followed by:
+		uint32_t cellStarts[cellCapacity + 2], the first entry of every cell, then of the large components, then the end
+		SceneSpatialEntry entries[entryCount], aligned to 16 bytes, by cell and in component order within a cell
+	*/
+	struct SceneSpatialIndex {
+		float minX; // of the grid
+		float minY;
+		float cellSize;
+		uint32_t columns;
+		uint32_t rows;
+		uint32_t cellCapacity; // columns * rows is at most this, the rest of the cells are empty
+		uint32_t entryCount;
+		uint32_t reserved;
+	};
+
+	static_assert(sizeof(SceneSpatialEntry) == 20, "SceneSpatialEntry is part of the scene format");
+	static_assert(sizeof(SceneSpatialIndex) == 32, "SceneSpatialIndex is part of the scene format");
+
+	// The size of the spatial section for a number of entries, only depends on the count so the section can be laid out
+	// before any bounds are known. 0 entries need no section at all.
+	uint64_t SceneSpatialIndexSize(uint64_t entry_count);
+
+	// Writes the section for the entries to dest, which must be SceneSpatialIndexSize(entries.size()) bytes.
+	void BuildSceneSpatialIndex(std::vector<SceneSpatialEntry> entries, uint8_t* dest);
+
+	// The spatial index of a scene file that passed ValidateSceneHeader, nullptr if the scene has nothing positioned.
+	const SceneSpatialIndex* FindSceneSpatialIndex(const void* data);
+
+	// Appends the component index of every entry overlapping area to result, in no particular order. Only the cells
+	// that overlap area are visited.
+	void QuerySceneSpatialIndex(const SceneSpatialIndex& index, const SceneBounds& area, std::vector<uint32_t>& result);
+}
@@ -0,0 +1,337 @@
+#include "SceneWriter.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sg {
+
+	static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static bool Seek(FILE* fp, uint64_t offset) {
+#ifdef _WIN32
+		return _fseeki64(fp, int64_t(offset), SEEK_SET) == 0;
+#else
+		return fseeko(fp, off_t(offset), SEEK_SET) == 0;
+#endif
+	}
+
+	bool ReplaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+		// rename doesn't replace existing files on Windows
+		std::remove(to.c_str());
+#endif
+		return std::rename(from.c_str(), to.c_str()) == 0;
+	}
+
+	void SceneWriter::ChunkedStream::reset(uint64_t offset) {
+		mOffset = offset;
+		mBuffer.clear();
+	}
+
+	bool SceneWriter::ChunkedStream::write(SceneWriter& writer, const void* data, size_t size) {
+
+		const uint8_t* src = static_cast<const uint8_t*>(data);
+
+		while (size > 0) {
+
+			if (mBuffer.capacity() < CHUNK_SIZE)
+				mBuffer.reserve(CHUNK_SIZE);
+
+			const size_t count = std::min(size, CHUNK_SIZE - mBuffer.size());
+			mBuffer.insert(mBuffer.end(), src, src + count);
+			src += count;
+			size -= count;
+
+			if (mBuffer.size() == CHUNK_SIZE && !flush(writer))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool SceneWriter::ChunkedStream::flush(SceneWriter& writer) {
+
+		if (mBuffer.empty())
+			return true;
+
+		if (!writer.writeAt(mOffset, mBuffer.data(), mBuffer.size()))
+			return false;
+
+		mOffset += mBuffer.size();
+		mBuffer.clear();
+		return true;
+	}
+
+	SceneWriter::~SceneWriter() {
+		// the scene was never finished, don't leave the partial file behind
+		if (mFile) {
+			std::fclose(mFile);
+			std::remove(mTempPath.c_str());
+		}
+	}
+
+	bool SceneWriter::fail(std::string error) {
+		if (mError.empty())
+			mError = std::move(error);
+
+		return false;
+	}
+
+	bool SceneWriter::writeAt(uint64_t offset, const void* data, size_t size) {
+
+		if (!mError.empty())
+			return false;
+
+		// streams mostly follow each other, so avoid seeking when we can
+		if (offset != mFilePosition && !Seek(mFile, offset))
+			return fail("Unable to seek in scene output");
+
+		if (std::fwrite(data, 1, size, mFile) != size)
+			return fail("Unable to write scene output");
+
+		mFilePosition = offset + size;
+		mFileEnd = std::max(mFileEnd, mFilePosition);
+		return true;
+	}
+
+	bool SceneWriter::checksumAt(uint64_t offset, uint64_t size, uint64_t& result) {
+
+		if (!mError.empty())
+			return false;
+
+		// switching from writing to reading needs a seek, even to the current position
+		if (std::fflush(mFile) != 0 || !Seek(mFile, offset))
+			return fail("Unable to read back scene output");
+
+		std::vector<uint8_t> buffer(std::min(size, uint64_t(CHUNK_SIZE)));
+		Checksum checksum;
+
+		for (uint64_t remaining = size; remaining > 0;) {
+			const size_t count = size_t(std::min<uint64_t>(remaining, buffer.size()));
+			if (std::fread(buffer.data(), 1, count, mFile) != count)
+				return fail("Unable to read back scene output");
+
+			checksum.bytes(buffer.data(), count);
+			remaining -= count;
+		}
+
+		// reading moved the file position, make the next write seek as well
+		mFilePosition = ~uint64_t(0);
+
+		result = checksum.result();
+		return true;
+	}
+
+	bool SceneWriter::open(const std::string& path, const std::vector<SceneRangeInfo>& ranges, const SceneSchema& schema, uint64_t spatial_count, uint64_t name_count) {
+
+		// read back by finish() to checksum each section
+		mPath = path;
+		mTempPath = path + ".tmp";
+
+		mFile = std::fopen(mTempPath.c_str(), "w+b");
+		if (!mFile)
+			return fail("Unable to open " + mTempPath + " for writing");
+
+		mRanges.resize(ranges.size());
+
+		mComponentCount = 0;
+		for (const SceneRangeInfo& r : ranges) {
+			mComponentCount += r.count;
+		}
+
+		mSchemaHash = schema.hash;
+		mRangesOffset = sizeof(SceneFileHeader) + SCENE_SIZE;
+		mOffsetsOffset = AlignUp(mRangesOffset + ranges.size() * COMPONENT_RANGE_SIZE, COMPONENT_OFFSET_SIZE);
+		mComponentsOffset = AlignUp(mOffsetsOffset + mComponentCount * COMPONENT_OFFSET_SIZE, COMPONENT_ALIGNMENT);
+
+		uint64_t offsets_offset = mOffsetsOffset;
+		uint64_t data_offset = mComponentsOffset;
+
+		std::vector<uint8_t> range_table;
+
+		for (size_t n = 0; n < ranges.size(); ++n) {
+
+			Range& r = mRanges[n];
+			r.info = ranges[n];
+			r.dataOffset = data_offset;
+			r.offsets.reset(offsets_offset);
+			r.data.reset(data_offset);
+
+			if (r.info.componentSize % COMPONENT_ALIGNMENT != 0)
+				return fail("Component size " + std::to_string(r.info.componentSize) + " is not a multiple of 16");
+
+			offsets_offset += r.info.count * COMPONENT_OFFSET_SIZE;
+			data_offset += uint64_t(r.info.count) * r.info.componentSize;
+
+			const uint32_t entry[] = {r.info.typeId, r.info.count};
+			range_table.insert(range_table.end(), reinterpret_cast<const uint8_t*>(entry), reinterpret_cast<const uint8_t*>(entry) + sizeof(entry));
+		}
+
+		mSpatialOffset = AlignUp(data_offset, 16);
+		mSpatialCount = spatial_count;
+		mSpatialWritten = spatial_count == 0;
+
+		mNamesOffset = mSpatialOffset + SceneSpatialIndexSize(spatial_count);
+		mNameCount = name_count;
+		mNamesWritten = name_count == 0;
+
+		mSchemaOffset = mNamesOffset + SceneNameTableSize(name_count);
+		mTextOffset = mSchemaOffset + SceneSchemaSize(schema);
+		mText.reset(mTextOffset);
+		mStrings.clear();
+
+		std::vector<uint8_t> schema_section(size_t(SceneSchemaSize(schema)));
+		WriteSceneSchema(schema, schema_section.data());
+
+		if (!writeAt(mSchemaOffset, schema_section.data(), schema_section.size()))
+			return false;
+
+		if (range_table.empty())
+			return true;
+
+		return writeAt(mRangesOffset, range_table.data(), range_table.size());
+	}
+
+	uint64_t SceneWriter::componentOffset(size_t range, uint32_t index) const {
+		const Range& r = mRanges[range];
+		return r.dataOffset + uint64_t(index) * r.info.componentSize;
+	}
+
+	uint64_t SceneWriter::nextComponentOffset(size_t range) const {
+		return componentOffset(range, mRanges[range].written);
+	}
+
+	uint64_t SceneWriter::writeText(const char* text, size_t length) {
+
+		auto inserted = mStrings.emplace(std::string(text, length), mText.position());
+		if (!inserted.second)
+			return inserted.first->second;
+
+		mStringBuffer.resize(size_t(SceneStringSize(length)));
+		WriteSceneString(text, length, uint32_t(mStrings.size() - 1), mStringBuffer.data());
+		mText.write(*this, mStringBuffer.data(), mStringBuffer.size());
+
+		return inserted.first->second;
+	}
+
+	bool SceneWriter::writeComponent(size_t range, const void* data) {
+
+		Range& r = mRanges[range];
+
+		if (r.written == r.info.count)
+			return fail("Too many components written to range " + std::to_string(range));
+
+		// the offset table holds Refs, which are relative to themselves
+		const int64_t offset = int64_t(componentOffset(range, r.written++) - r.offsets.position());
+
+		return r.offsets.write(*this, &offset, sizeof(offset)) &&
+			r.data.write(*this, data, r.info.componentSize);
+	}
+
+	bool SceneWriter::writeSpatialIndex(const std::vector<SceneSpatialEntry>& entries) {
+
+		if (entries.size() != mSpatialCount)
+			return fail("The spatial index has " + std::to_string(entries.size()) + " of " + std::to_string(mSpatialCount) + " entries");
+
+		std::vector<uint8_t> section(size_t(SceneSpatialIndexSize(entries.size())));
+		BuildSceneSpatialIndex(entries, section.data());
+
+		mSpatialWritten = true;
+		return section.empty() || writeAt(mSpatialOffset, section.data(), section.size());
+	}
+
+	bool SceneWriter::writeNameTable(const std::vector<SceneNameEntry>& entries) {
+
+		if (entries.size() != mNameCount)
+			return fail("The name table has " + std::to_string(entries.size()) + " of " + std::to_string(mNameCount) + " entries");
+
+		std::vector<uint8_t> section(size_t(SceneNameTableSize(entries.size())));
+		if (!BuildSceneNameTable(entries, section.data()))
+			return fail("Two components have the same path, or paths with the same hash, so the name table can't tell them apart");
+
+		mNamesWritten = true;
+		return section.empty() || writeAt(mNamesOffset, section.data(), section.size());
+	}
+
+	bool SceneWriter::finish() {
+
+		if (!mSpatialWritten)
+			return fail("The spatial index was never written");
+
+		if (!mNamesWritten)
+			return fail("The name table was never written");
+
+		for (size_t n = 0; n < mRanges.size(); ++n) {
+			Range& r = mRanges[n];
+
+			if (r.written != r.info.count)
+				return fail("Range " + std::to_string(n) + " has " + std::to_string(r.written) + " of " + std::to_string(r.info.count) + " components");
+
+			if (!r.offsets.flush(*this) || !r.data.flush(*this))
+				return false;
+		}
+
+		mByteSize = mText.position();
+
+		if (!mText.flush(*this))
+			return false;
+
+		// components, componentCount, componentRanges, componentRangeCount, the Refs are relative to their own field
+		const uint64_t scene_offset = sizeof(SceneFileHeader);
+		const uint64_t scene[] = {mOffsetsOffset - scene_offset, mComponentCount, mRangesOffset - (scene_offset + 16), mRanges.size()};
+		if (!writeAt(scene_offset, scene, sizeof(scene)))
+			return false;
+
+		// when there is no text the last bytes of the file may be alignment padding that was never written
+		if (mFileEnd < mByteSize) {
+			const uint8_t zero = 0;
+			if (!writeAt(mByteSize - 1, &zero, 1))
+				return false;
+		}
+
+		SceneFileHeader header = {};
+		header.magic = SCENE_FILE_MAGIC;
+		header.version = SCENE_FILE_VERSION;
+		header.schemaHash = mSchemaHash;
+		header.fileSize = mByteSize;
+
+		const uint64_t section_offsets[SCENE_SECTION_COUNT + 1] = {
+			sizeof(SceneFileHeader),
+			mRangesOffset,
+			mOffsetsOffset,
+			mComponentsOffset,
+			mSpatialOffset,
+			mNamesOffset,
+			mSchemaOffset,
+			mTextOffset,
+			mByteSize
+		};
+
+		for (size_t n = 0; n < SCENE_SECTION_COUNT; ++n) {
+			SceneSectionInfo& section = header.sections[n];
+			section.offset = section_offsets[n];
+			section.size = section_offsets[n + 1] - section_offsets[n];
+
+			if (!checksumAt(section.offset, section.size, section.checksum))
+				return false;
+		}
+
+		header.headerChecksum = SceneHeaderChecksum(header);
+
+		if (!writeAt(0, &header, sizeof(header)))
+			return false;
+
+		const bool closed = std::fclose(mFile) == 0;
+		mFile = nullptr;
+
+		if (!closed || !ReplaceFile(mTempPath, mPath)) {
+			std::remove(mTempPath.c_str());
+			return fail("Unable to write " + mPath);
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "SceneFormat.h"
+#include "SceneNames.h"
+#include "SceneSchema.h"
+#include "SceneSpatial.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+*/
+
+namespace sg {
+
+	// Moves a finished file over another. A game that has the old file mapped keeps reading the old contents instead
+	// of faulting on a file truncated underneath it, and never sees a half written one.
+	bool ReplaceFile(const std::string& from, const std::string& to);
+
+	struct SceneRangeInfo {
+		uint32_t typeId;
+		uint32_t count;
+		uint32_t componentSize; // a multiple of 16
+	};
+
+	/*
+	Streams a compiled scene to disk. The layout is calculated from the ranges when the file is opened, every section
+	is then written through a fixed size chunk buffer as components arrive, in any order across ranges. The Scene
+	header is patched in by finish(). The scene is written next to the output and only replaces it once it is complete.
+
+	The layout is described in SceneFormat.h, all offsets are from the start of the file:
+		SceneFileHeader, written last since it holds the checksum of every section
+		Scene
+		ComponentRange[rangeCount]
+		Ref<void>[componentCount], a self relative offset to each component, in range order
+		components, in range order, aligned to 16 bytes
+		SceneSpatialIndex over the components with a position, see SceneSpatial.h
+		SceneNameTable over the paths of the components, see SceneNames.h
+		the schema of the components, see SceneSchema.h
+		text, a SceneString for every distinct string
+	*/
+	class SceneWriter {
+
+		class ChunkedStream {
+			uint64_t mOffset = 0; // file offset of the start of mBuffer
+			std::vector<uint8_t> mBuffer;
+
+		public:
+			void reset(uint64_t offset);
+			bool write(SceneWriter& writer, const void* data, size_t size);
+			bool flush(SceneWriter& writer);
+			uint64_t position() const { return mOffset + mBuffer.size(); }
+		};
+
+		struct Range {
+			SceneRangeInfo info;
+			uint32_t written = 0;
+			uint64_t dataOffset = 0;
+			ChunkedStream offsets;
+			ChunkedStream data;
+		};
+
+		FILE* mFile = nullptr;
+		std::string mPath;
+		std::string mTempPath;
+		uint64_t mFilePosition = 0;
+		uint64_t mFileEnd = 0;
+		std::string mError;
+
+		std::vector<Range> mRanges;
+		ChunkedStream mText;
+		std::unordered_map<std::string, uint64_t> mStrings; // the offset of every string written to mText
+		std::vector<uint8_t> mStringBuffer;
+
+		uint64_t mSchemaHash = 0;
+		uint64_t mComponentCount = 0;
+		uint64_t mRangesOffset = 0;
+		uint64_t mOffsetsOffset = 0;
+		uint64_t mComponentsOffset = 0;
+		uint64_t mSpatialOffset = 0;
+		uint64_t mSchemaOffset = 0;
+		uint64_t mSpatialCount = 0;
+		bool mSpatialWritten = false;
+		uint64_t mNamesOffset = 0;
+		uint64_t mNameCount = 0;
+		bool mNamesWritten = false;
+		uint64_t mTextOffset = 0;
+		uint64_t mByteSize = 0;
+
+		bool writeAt(uint64_t offset, const void* data, size_t size);
+		bool checksumAt(uint64_t offset, uint64_t size, uint64_t& result);
+		bool fail(std::string error);
+
+	public:
+		static const size_t CHUNK_SIZE = 64 * 1024;
+
+		SceneWriter() {}
+		~SceneWriter();
+
+		SceneWriter(const SceneWriter&) = delete;
+		SceneWriter& operator=(const SceneWriter&) = delete;
+
+		// ranges are written in the order given, every range must receive exactly count components. schema describes the
+		// components the range typeIds refer to. spatial_count and name_count are the number of entries writeSpatialIndex
+		// and writeNameTable will be given.
+		bool open(const std::string& path, const std::vector<SceneRangeInfo>& ranges, const SceneSchema& schema, uint64_t spatial_count = 0, uint64_t name_count = 0);
+
+		// the offset the index'th component of a range will be written at, so references can be resolved up front
+		uint64_t componentOffset(size_t range, uint32_t index) const;
+
+		// where the next component written to a range will go, so it can refer to data relative to itself
+		uint64_t nextComponentOffset(size_t range) const;
+
+		// returns the offset of the SceneString for text, which is only appended to the text section the first time
+		uint64_t writeText(const char* text, size_t length);
+
+		// appends a component to a range, data must be componentSize bytes
+		bool writeComponent(size_t range, const void* data);
+
+		// builds the spatial index from the bounds of every positioned component, must be called before finish() when
+		// spatial_count isn't 0
+		bool writeSpatialIndex(const std::vector<SceneSpatialEntry>& entries);
+
+		// builds the name table from the path of every named component, must be called before finish() when name_count
+		// isn't 0
+		bool writeNameTable(const std::vector<SceneNameEntry>& entries);
+
+		// flushes everything that is buffered, then writes the Scene and the file header and replaces the output
+		bool finish();
+
+		uint64_t byteSize() const { return mByteSize; }
+		size_t stringCount() const { return mStrings.size(); }
+		const std::string& error() const { return mError; }
+	};
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SG_MATH_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SG_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*
+This is shared between the editor and the game, so it must not depend on Qt or SDL.
+
+The types the point, scale and rotation properties are generated as, their layout is part of the scene format. Vec3
+and Quat are a full 16 byte register so they load with one instruction. Functions that take arrays work on many values
+per call with SSE2 or NEON where available, and plain C++ everywhere else.
+*/
+
+namespace sg {
+
+	// point2d and scale2d
+	struct alignas(8) Vec2 {
+		float x;
+		float y;
+	};
+
+	// point3d and scale3d
+	struct alignas(16) Vec3 {
+		float x;
+		float y;
+		float z;
+		float w; // unused, keeps a Vec3 one register
+	};
+
+	// rotation2d, counter clockwise
+	struct Rotation2 {
+		float radians;
+	};
+
+	// rotation3d, a unit quaternion
+	struct alignas(16) Quat {
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+
+	static_assert(sizeof(Vec2) == 8 && sizeof(Vec3) == 16 && sizeof(Rotation2) == 4 && sizeof(Quat) == 16, "The math types are part of the scene format");
+
+	inline Vec2 operator+(Vec2 a, Vec2 b) { return {a.x + b.x, a.y + b.y}; }
+	inline Vec2 operator-(Vec2 a, Vec2 b) { return {a.x - b.x, a.y - b.y}; }
+	inline Vec2 operator*(Vec2 a, Vec2 b) { return {a.x * b.x, a.y * b.y}; }
+	inline Vec2 operator*(Vec2 a, float s) { return {a.x * s, a.y * s}; }
+
+	inline float Dot(Vec2 a, Vec2 b) { return a.x * b.x + a.y * b.y; }
+
+	inline Vec2 Rotate(Vec2 v, Rotation2 r) {
+		const float c = std::cos(r.radians);
+		const float s = std::sin(r.radians);
+		return {c * v.x - s * v.y, s * v.x + c * v.y};
+	}
+
+#if SG_MATH_SSE2
+	inline __m128 Load(const Vec3& v) { return _mm_load_ps(&v.x); }
+	inline __m128 Load(const Quat& q) { return _mm_load_ps(&q.x); }
+	inline Vec3 ToVec3(__m128 v) { Vec3 r; _mm_store_ps(&r.x, v); return r; }
+
+	// the cross product of the xyz lanes, w ends up 0 when both w are 0
+	inline __m128 Cross(__m128 a, __m128 b) {
+		const __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+		return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+	}
+
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return ToVec3(_mm_add_ps(Load(a), Load(b))); }
+	inline Vec3 operator-(const Vec3& a, const Vec3& b) { return ToVec3(_mm_sub_ps(Load(a), Load(b))); }
+	inline Vec3 operator*(const Vec3& a, const Vec3& b) { return ToVec3(_mm_mul_ps(Load(a), Load(b))); }
+	inline Vec3 operator*(const Vec3& a, float s) { return ToVec3(_mm_mul_ps(Load(a), _mm_set1_ps(s))); }
+#elif SG_MATH_NEON
+	inline float32x4_t Load(const Vec3& v) { return vld1q_f32(&v.x); }
+	inline float32x4_t Load(const Quat& q) { return vld1q_f32(&q.x); }
+	inline Vec3 ToVec3(float32x4_t v) { Vec3 r; vst1q_f32(&r.x, v); return r; }
+
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return ToVec3(vaddq_f32(Load(a), Load(b))); }
+	inline Vec3 operator-(const Vec3& a, const Vec3& b) { return ToVec3(vsubq_f32(Load(a), Load(b))); }
+	inline Vec3 operator*(const Vec3& a, const Vec3& b) { return ToVec3(vmulq_f32(Load(a), Load(b))); }
+	inline Vec3 operator*(const Vec3& a, float s) { return ToVec3(vmulq_n_f32(Load(a), s)); }
+#else
+	inline Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z, 0.0f}; }
+	inline Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z, 0.0f}; }
+	inline Vec3 operator*(const Vec3& a, const Vec3& b) { return {a.x * b.x, a.y * b.y, a.z * b.z, 0.0f}; }
+	inline Vec3 operator*(const Vec3& a, float s) { return {a.x * s, a.y * s, a.z * s, 0.0f}; }
+#endif
+
+	inline float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	inline Vec3 Cross(const Vec3& a, const Vec3& b) {
+		return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0.0f};
+	}
+
+	inline Quat operator*(const Quat& a, const Quat& b) {
+		return {
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+		};
+	}
+
+	inline Quat Conjugate(const Quat& q) { return {-q.x, -q.y, -q.z, q.w}; }
+
+	// rotates about x, then y, then z, in radians
+	inline Quat QuatFromEuler(float x, float y, float z) {
+		const float cx = std::cos(x * 0.5f), sx = std::sin(x * 0.5f);
+		const float cy = std::cos(y * 0.5f), sy = std::sin(y * 0.5f);
+		const float cz = std::cos(z * 0.5f), sz = std::sin(z * 0.5f);
+
+		return {
+			sx * cy * cz - cx * sy * sz,
+			cx * sy * cz + sx * cy * sz,
+			cx * cy * sz - sx * sy * cz,
+			cx * cy * cz + sx * sy * sz
+		};
+	}
+
+	// v + 2w(q x v) + 2(q x (q x v)), cheaper than q v q* for a single vector
+	inline Vec3 Rotate(const Vec3& v, const Quat& q) {
+#if SG_MATH_SSE2
+		const __m128 qv = _mm_and_ps(Load(q), _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+		const __m128 vv = Load(v);
+		const __m128 t = _mm_add_ps(Cross(qv, vv), Cross(qv, vv));
+		return ToVec3(_mm_add_ps(_mm_add_ps(vv, _mm_mul_ps(_mm_set1_ps(q.w), t)), Cross(qv, t)));
+#else
+		const Vec3 qv = {q.x, q.y, q.z, 0.0f};
+		const Vec3 t = Cross(qv, v) * 2.0f;
+		return v + t * q.w + Cross(qv, t);
+#endif
+	}
+
+	/*
+	Scales, rotates and then translates every point, the way a position, rotation and scale property place an object.
+	points and out may be the same array.
+	*/
+	inline void TransformPoints(const Vec2* points, size_t count, Vec2 translation, Rotation2 rotation, Vec2 scale, Vec2* out) {
+
+		const float c = std::cos(rotation.radians);
+		const float s = std::sin(rotation.radians);
+		size_t n = 0;
+
+#if SG_MATH_SSE2
+		// two points per register, x0 y0 x1 y1
+		const __m128 scale4 = _mm_setr_ps(scale.x, scale.y, scale.x, scale.y);
+		const __m128 cos4 = _mm_set1_ps(c);
+		const __m128 sin4 = _mm_setr_ps(-s, s, -s, s);
+		const __m128 translation4 = _mm_setr_ps(translation.x, translation.y, translation.x, translation.y);
+
+		for (; n + 2 <= count; n += 2) {
+			const __m128 p = _mm_mul_ps(_mm_loadu_ps(&points[n].x), scale4);
+			const __m128 swapped = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1));
+			_mm_storeu_ps(&out[n].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, cos4), _mm_mul_ps(swapped, sin4)), translation4));
+		}
+#elif SG_MATH_NEON
+		const float32x4_t scale4 = {scale.x, scale.y, scale.x, scale.y};
+		const float32x4_t sin4 = {-s, s, -s, s};
+		const float32x4_t translation4 = {translation.x, translation.y, translation.x, translation.y};
+
+		for (; n + 2 <= count; n += 2) {
+			const float32x4_t p = vmulq_f32(vld1q_f32(&points[n].x), scale4);
+			const float32x4_t swapped = vrev64q_f32(p);
+			vst1q_f32(&out[n].x, vaddq_f32(vmlaq_f32(vmulq_n_f32(p, c), swapped, sin4), translation4));
+		}
+#endif
+
+		for (; n < count; ++n) {
+			const Vec2 p = points[n] * scale;
+			out[n] = {c * p.x - s * p.y + translation.x, s * p.x + c * p.y + translation.y};
+		}
+	}
+
+	// TransformPoints for points kept as separate x and y arrays, which fills every lane with no shuffling
+	inline void TransformPointLanes(const float* xs, const float* ys, size_t count, Vec2 translation, Rotation2 rotation, Vec2 scale, float* out_xs, float* out_ys) {
+
+		const float c = std::cos(rotation.radians);
+		const float s = std::sin(rotation.radians);
+
+		// the scale folded into the rotation
+		const float xx = c * scale.x, xy = -s * scale.y;
+		const float yx = s * scale.x, yy = c * scale.y;
+		size_t n = 0;
+
+#if SG_MATH_SSE2
+		for (; n + 4 <= count; n += 4) {
+			const __m128 x = _mm_loadu_ps(xs + n);
+			const __m128 y = _mm_loadu_ps(ys + n);
+			_mm_storeu_ps(out_xs + n, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(xx)), _mm_mul_ps(y, _mm_set1_ps(xy))), _mm_set1_ps(translation.x)));
+			_mm_storeu_ps(out_ys + n, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(yx)), _mm_mul_ps(y, _mm_set1_ps(yy))), _mm_set1_ps(translation.y)));
+		}
+#elif SG_MATH_NEON
+		for (; n + 4 <= count; n += 4) {
+			const float32x4_t x = vld1q_f32(xs + n);
+			const float32x4_t y = vld1q_f32(ys + n);
+			vst1q_f32(out_xs + n, vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(translation.x), x, xx), y, xy));
+			vst1q_f32(out_ys + n, vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(translation.y), x, yx), y, yy));
+		}
+#endif
+
+		for (; n < count; ++n) {
+			const float x = xs[n];
+			const float y = ys[n];
+			out_xs[n] = xx * x + xy * y + translation.x;
+			out_ys[n] = yx * x + yy * y + translation.y;
+		}
+	}
+
+	// rotates every point by q, points and out may be the same array
+	inline void RotatePoints(const Vec3* points, size_t count, const Quat& q, Vec3* out) {
+		for (size_t n = 0; n < count; ++n) {
+			out[n] = Rotate(points[n], q);
+		}
+	}
+}
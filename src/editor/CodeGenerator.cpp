@@ -1,7 +1,15 @@
 #include "CodeGenerator.h"
 #include "Controller.h"
 #include "FormatString.h"
-
+#include "Hash.h"
+#include "SceneCompiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
 #include <vector>
 #include <map>
 #include <string>
@@ -15,18 +23,15 @@
 
 namespace sg {
 
-	struct CppMember {
-		std::string typeName;
-		std::string name;
-		std::string defaultValue;
-	};
-
-	struct CppStructure {
-		std::string name;
-		std::vector<CppMember> members;
-	};
+	// the runtime format stores references as 64 bit self relative offsets, see Ref in the generated header
+	static const size_t POINTER_SIZE = 8;
 
+	// every generated structure is declared alignas(16)
+	static const size_t STRUCTURE_ALIGNMENT = 16;
 
+	static inline size_t AlignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
 
 	static inline const std::string TranslateTypeName(const CppMember& m) {
 
@@ -40,13 +45,438 @@ namespace sg {
 		if (m.typeName == "u64") return "uint64_t";
 		if (m.typeName == "f32") return "float";
 		if (m.typeName == "f64") return "double";
-		if (m.typeName == "text") return "const char *";
-		if (m.typeName == "component_ref") return ("const struct %s*"_sb + m.defaultValue).take();
+		if (m.typeName == "text") return "Ref<String>";
+		if (m.typeName == "point2d" || m.typeName == "scale2d") return "Vec2";
+		if (m.typeName == "point3d" || m.typeName == "scale3d") return "Vec3";
+		if (m.typeName == "rotation2d") return "Rotation2";
+		if (m.typeName == "rotation3d") return "Quat";
+		if (m.typeName == "component_ref") return ("Ref<struct "_sb + m.defaultValue + ">").take();
 		if (m.typeName == "component") return m.defaultValue;
+		if (m.typeName == "enum" && m.enumeration.id != -1) return m.enumeration.name;
 		return "unknown";
 	}
 
-	static Result<> WriteHeader(const std::vector<CppStructure>& structures, const std::string& path) {
+	// returns the size of a member, alignment is always the same as size for non structure members.
+	// 0 means the type has no runtime representation.
+	static size_t CalcMemberSize(const CppMember& m) {
+
+		if (m.quantization.kind != CppEncoding::Kind::None) return m.quantization.size;
+
+		if (m.typeName == "i8" || m.typeName == "u8") return 1;
+		if (m.typeName == "i16" || m.typeName == "u16") return 2;
+		if (m.typeName == "i32" || m.typeName == "u32" || m.typeName == "f32" || m.typeName == "rotation2d") return 4;
+		if (m.typeName == "i64" || m.typeName == "u64" || m.typeName == "f64") return 8;
+		if (m.typeName == "point2d" || m.typeName == "scale2d") return 8;
+		if (m.typeName == "point3d" || m.typeName == "scale3d" || m.typeName == "rotation3d") return 16;
+		if (m.typeName == "text" || m.typeName == "component_ref") return POINTER_SIZE;
+		if (m.typeName == "enum" && m.enumeration.id != -1) return m.enumeration.size;
+		return 0;
+	}
+
+	Result<CppEncoding> ParseEncoding(const std::string& encoding) {
+
+		CppEncoding result;
+
+		if (encoding.empty())
+			return Ok(result);
+
+		if (encoding == "f16") {
+			result.kind = CppEncoding::Kind::Half;
+			result.size = 2;
+			return Ok(result);
+		}
+
+		static const struct {
+			const char* name;
+			CppEncoding::Kind kind;
+			size_t size;
+		} NORMALIZED[] = {
+			{"unorm8", CppEncoding::Kind::Unorm, 1},
+			{"unorm16", CppEncoding::Kind::Unorm, 2},
+			{"snorm8", CppEncoding::Kind::Snorm, 1},
+			{"snorm16", CppEncoding::Kind::Snorm, 2},
+		};
+
+		for (const auto& n : NORMALIZED) {
+			if (encoding == n.name) {
+				result.kind = n.kind;
+				result.size = n.size;
+				return Ok(result);
+			}
+		}
+
+		// fixed8(min, max) and fixed16(min, max)
+		int bits = 0;
+		int length = 0;
+		if (std::sscanf(encoding.c_str(), "fixed%d ( %f , %f )%n", &bits, &result.min, &result.max, &length) == 3 &&
+			size_t(length) == encoding.size() && (bits == 8 || bits == 16)) {
+
+			if (!(result.min < result.max) || !std::isfinite(result.min) || !std::isfinite(result.max))
+				return Error("'"_sb + encoding + "' needs a minimum smaller than its maximum");
+
+			result.kind = CppEncoding::Kind::Fixed;
+			result.size = size_t(bits / 8);
+			return Ok(result);
+		}
+
+		return Error("Unknown encoding '"_sb + encoding + "', expected f16, unorm8, unorm16, snorm8, snorm16, fixed8(min, max) or fixed16(min, max)");
+	}
+
+	// the integer an encoded property is stored as
+	static const char* EncodedTypeName(const CppEncoding& e) {
+
+		switch (e.kind) {
+			case CppEncoding::Kind::Snorm: return e.size == 1 ? "int8_t" : "int16_t";
+			case CppEncoding::Kind::Half: return "uint16_t";
+			default: return e.size == 1 ? "uint8_t" : "uint16_t";
+		}
+	}
+
+	// infinity and NaN have no literal
+	static std::string FormatNonFinite(double value, const char* type) {
+
+		if (std::isnan(value))
+			return std::string("std::numeric_limits<") + type + ">::quiet_NaN()";
+
+		return std::string(value < 0 ? "-" : "") + "std::numeric_limits<" + type + ">::infinity()";
+	}
+
+	// a float literal that reads back as exactly value
+	static std::string FormatFloat(float value) {
+
+		if (!std::isfinite(value))
+			return FormatNonFinite(value, "float");
+
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.9g", value);
+
+		std::string result = buf;
+		if (result.find_first_of(".e") == std::string::npos)
+			result += ".0";
+
+		return result + "f";
+	}
+
+	static std::string FormatDouble(double value) {
+
+		if (!std::isfinite(value))
+			return FormatNonFinite(value, "double");
+
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.17g", value);
+
+		std::string result = buf;
+		if (result.find_first_of(".e") == std::string::npos)
+			result += ".0";
+
+		return result;
+	}
+
+	// a size byte integer from an encoded component, sign extended when is_signed
+	static uint64_t LoadInteger(const uint8_t* src, size_t size, bool is_signed) {
+
+		switch (size) {
+			case 1: { int8_t s; uint8_t u; std::memcpy(&s, src, 1); std::memcpy(&u, src, 1); return is_signed ? uint64_t(int64_t(s)) : u; }
+			case 2: { int16_t s; uint16_t u; std::memcpy(&s, src, 2); std::memcpy(&u, src, 2); return is_signed ? uint64_t(int64_t(s)) : u; }
+			case 4: { int32_t s; uint32_t u; std::memcpy(&s, src, 4); std::memcpy(&u, src, 4); return is_signed ? uint64_t(int64_t(s)) : u; }
+			default: { uint64_t u; std::memcpy(&u, src, 8); return u; }
+		}
+	}
+
+	static std::string FormatInteger(uint64_t value, size_t size, bool is_signed) {
+
+		if (!is_signed)
+			return std::to_string(value) + (size == 8 ? "ull" : "u");
+
+		// the literal would be the positive value negated, which doesn't fit
+		if (int64_t(value) == INT64_MIN)
+			return "INT64_MIN";
+
+		return std::to_string(int64_t(value)) + (size == 8 ? "ll" : "");
+	}
+
+	static std::string DecodeExpression(const CppMember& m) {
+
+		const std::string field = m.name + "Encoded";
+
+		switch (m.quantization.kind) {
+			case CppEncoding::Kind::Half: return "DecodeHalf(" + field + ")";
+			case CppEncoding::Kind::Unorm: return "DecodeUnorm(" + field + ")";
+			case CppEncoding::Kind::Snorm: return "DecodeSnorm(" + field + ")";
+			default: return "DecodeFixed(" + field + ", " + FormatFloat(m.quantization.min) + ", " + FormatFloat(m.quantization.max) + ")";
+		}
+	}
+
+	// The initializer of a member of a generated struct, from the component the scene compiler encodes with every
+	// property at its default, so both agree. Empty for nested components, which have initializers of their own.
+	static std::string DefaultInitializer(const CppMember& m, const uint8_t* component) {
+
+		const uint8_t* src = component + m.offset;
+
+		if (m.quantization.kind != CppEncoding::Kind::None)
+			return FormatInteger(LoadInteger(src, m.size, m.quantization.kind == CppEncoding::Kind::Snorm), m.size, m.quantization.kind == CppEncoding::Kind::Snorm);
+
+		if (m.typeName == "component")
+			return "";
+
+		if (m.typeName == "text" || m.typeName == "component_ref")
+			return "{}";
+
+		if (m.typeName == "f64") {
+			double v;
+			std::memcpy(&v, src, sizeof(v));
+			return FormatDouble(v);
+		}
+
+		if (m.typeName == "f32") {
+			float v;
+			std::memcpy(&v, src, sizeof(v));
+			return FormatFloat(v);
+		}
+
+		// points, scales and rotations are all floats
+		if (m.typeName == "point2d" || m.typeName == "scale2d" || m.typeName == "point3d" || m.typeName == "scale3d" || m.typeName == "rotation2d" || m.typeName == "rotation3d") {
+			std::string lanes;
+			for (size_t n = 0; n < m.size / sizeof(float); ++n) {
+				float v;
+				std::memcpy(&v, src + n * sizeof(float), sizeof(v));
+				lanes += (n ? ", " : "") + FormatFloat(v);
+			}
+
+			return TranslateTypeName(m) + "{" + lanes + "}";
+		}
+
+		if (m.typeName == "enum") {
+			const CppEnum& e = m.enumeration;
+			const uint64_t value = LoadInteger(src, m.size, e.isSigned);
+
+			for (const CppEnumerator& v : e.enumerators) {
+				if (uint64_t(v.value) == value)
+					return e.name + "::" + v.name;
+			}
+
+			return e.name + "(" + FormatInteger(value, m.size, e.isSigned) + ")";
+		}
+
+		const bool is_signed = m.typeName[0] == 'i';
+		return FormatInteger(LoadInteger(src, m.size, is_signed), m.size, is_signed);
+	}
+
+	static const char* EnumUnderlyingType(const CppEnum& e) {
+
+		switch (e.size) {
+			case 1: return e.isSigned ? "int8_t" : "uint8_t";
+			case 2: return e.isSigned ? "int16_t" : "uint16_t";
+			case 4: return e.isSigned ? "int32_t" : "uint32_t";
+			default: return e.isSigned ? "int64_t" : "uint64_t";
+		}
+	}
+
+	void CalcEnumLayout(CppEnum& e) {
+
+		int64_t min_value = 0;
+		int64_t max_value = 0;
+
+		for (const CppEnumerator& v : e.enumerators) {
+			min_value = std::min(min_value, v.value);
+			max_value = std::max(max_value, v.value);
+		}
+
+		e.isSigned = min_value < 0;
+
+		if (e.isSigned) {
+			if (min_value >= INT8_MIN && max_value <= INT8_MAX) e.size = 1;
+			else if (min_value >= INT16_MIN && max_value <= INT16_MAX) e.size = 2;
+			else if (min_value >= INT32_MIN && max_value <= INT32_MAX) e.size = 4;
+			else e.size = 8;
+		} else {
+			if (max_value <= UINT8_MAX) e.size = 1;
+			else if (max_value <= UINT16_MAX) e.size = 2;
+			else if (max_value <= UINT32_MAX) e.size = 4;
+			else e.size = 8;
+		}
+	}
+
+	Result<> SplitColdStructures(std::vector<CppStructure>& structures) {
+
+		const size_t component_count = structures.size();
+
+		for (size_t n = 0; n < component_count; ++n) {
+
+			CppStructure cold;
+			cold.name = structures[n].name + "Cold";
+			cold.hotStructure = n;
+
+			for (const CppMember& m : structures[n].members) {
+				if (!m.cold)
+					continue;
+
+				CppMember copy = m;
+				copy.cold = false;
+				cold.members.push_back(std::move(copy));
+			}
+
+			if (cold.members.empty())
+				continue;
+
+			for (const CppStructure& s : structures) {
+				if (s.name == cold.name)
+					return Error("'"_sb + cold.name + "' holds the cold properties of '" + structures[n].name + "', but a component already has that name");
+			}
+
+			structures[n].coldStructure = structures.size();
+			structures.push_back(std::move(cold));
+		}
+
+		for (const CppStructure& s : structures) {
+			for (const CppMember& m : s.members) {
+				// inline copies only take the hot part of their target
+				if (m.typeName != "component" || m.inlineOf != CppMember::NO_MEMBER)
+					continue;
+
+				for (const CppStructure& nested : structures) {
+					if (nested.name == m.defaultValue && nested.coldStructure != CppStructure::NO_STRUCTURE)
+						return Error("'"_sb + nested.name + "' has cold properties, so it can't be nested in '" + s.name + "'");
+				}
+			}
+		}
+
+		return Ok();
+	}
+
+	void CalcLayouts(std::vector<CppStructure>& structures) {
+
+		std::map<std::string, const CppStructure*> laid_out;
+
+		for (CppStructure& s : structures) {
+
+			bool valid = true;
+
+			s.alignment = STRUCTURE_ALIGNMENT;
+
+			for (CppMember& m : s.members) {
+
+				// laid out in the cold structure instead
+				if (m.cold)
+					continue;
+
+				if (m.typeName == "component") {
+					auto itr = laid_out.find(m.defaultValue);
+					if (itr != laid_out.end()) {
+						m.size = itr->second->size;
+						m.alignment = itr->second->alignment;
+					}
+				} else {
+					m.size = CalcMemberSize(m);
+					m.alignment = m.size;
+				}
+
+				if (m.size == 0) {
+					valid = false;
+					break;
+				}
+
+				s.alignment = std::max(s.alignment, m.alignment);
+			}
+
+			// largest alignment first leaves no padding between members, ties stay in declaration order
+			std::vector<CppMember*> placement;
+			for (CppMember& m : s.members) {
+				if (!m.cold)
+					placement.push_back(&m);
+			}
+
+			std::stable_sort(placement.begin(), placement.end(), [](const CppMember* a, const CppMember* b) {
+				return a->alignment > b->alignment;
+			});
+
+			size_t offset = 0;
+
+			for (CppMember* m : placement) {
+				offset = AlignUp(offset, m->alignment);
+				m->offset = offset;
+				offset += m->size;
+			}
+
+			// an empty structure still has a size of 1, before alignment
+			s.size = valid ? AlignUp(std::max<size_t>(offset, 1), s.alignment) : 0;
+
+			laid_out[s.name] = &s;
+		}
+	}
+
+	static std::string FormatHash(uint64_t hash) {
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "0x%016llxull", (unsigned long long)hash);
+		return buf;
+	}
+
+	// a component that refers to no other component, directly or through nested components, can be processed without
+	// touching any other component, so ranges of it can be split across threads
+	static bool IsParallelSafe(const std::vector<CppStructure>& structures, const CppStructure& s) {
+
+		for (const CppMember& m : s.members) {
+			if (m.cold)
+				continue;
+
+			if (m.typeName == "component_ref")
+				return false;
+
+			if (m.typeName == "component") {
+				for (const CppStructure& nested : structures) {
+					if (nested.name == m.defaultValue && !IsParallelSafe(structures, nested))
+						return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// a component with no text or references, directly or through nested components, is the same bytes wherever it is
+	// copied to, cold members aside
+	static bool IsPlainData(const std::vector<CppStructure>& structures, const CppStructure& s) {
+
+		for (const CppMember& m : s.members) {
+			if (m.cold)
+				continue;
+
+			if (m.typeName == "text" || m.typeName == "component_ref")
+				return false;
+
+			if (m.typeName == "component") {
+				for (const CppStructure& nested : structures) {
+					if (nested.name == m.defaultValue && !IsPlainData(structures, nested))
+						return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// whether a component holds inline copies, directly or through nested components, see CppMember::inlineTarget
+	static bool HasInlineCopies(const std::vector<CppStructure>& structures, const CppStructure& s) {
+
+		for (const CppMember& m : s.members) {
+			if (m.cold)
+				continue;
+
+			if (m.inlineOf != CppMember::NO_MEMBER)
+				return true;
+
+			if (m.typeName == "component") {
+				for (const CppStructure& nested : structures) {
+					if (nested.name == m.defaultValue && HasInlineCopies(structures, nested))
+						return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	static Result<> WriteHeader(const std::vector<CppEnum>& enums, const std::vector<CppStructure>& structures, const std::vector<std::vector<uint8_t>>& defaults, const std::string& path) {
 
 		std::cout << path.c_str() << std::endl;
 
@@ -54,12 +484,36 @@ namespace sg {
 
 		out += "/* This code is all generated from SG Edit. Any edits to it may be lost.*/\n\n";
 		out += "#pragma once\n\n";
-		out += "#include <cstdint>\n\n";
-		out += "#ifdef SG_BUILDER\n";
-		out += "#include <vector>\n";
-		out += "#endif\n";
+		out += "#include <cstddef>\n";
+		out += "#include <cstdint>\n";
+		out += "#include <cstring>\n";
+		out += "#include <limits>\n\n";
+		out += "#include \"Quantize.h\"\n";
+		out += "#include \"VectorMath.h\"\n\n";
 		out += "namespace sg {\n\n";
 
+		out += "\t// an offset from the Ref itself, 0 is nullptr. Scenes use these instead of pointers so they can be used straight\n";
+		out += "\t// from a read only mapping of the file, with no fixups.\n";
+		out += "\ttemplate<typename T>\n";
+		out += "\tstruct Ref {\n";
+		out += "\t\tint64_t offset;\n\n";
+		out += "\t\tconst T* get() const {\n";
+		out += "\t\t\treturn offset ? reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + offset) : nullptr;\n";
+		out += "\t\t}\n\n";
+		out += "\t\tconst T* operator->() const { return get(); }\n";
+		out += "\t\texplicit operator bool() const { return offset != 0; }\n";
+		out += "\t};\n\n";
+
+		out += "\t// Text is pooled by the scene compiler, the same text is stored once per scene or pack, so equal text is the same\n";
+		out += "\t// String. hash is sg::StringHash of the characters, so a name known up front is found by comparing integers.\n";
+		out += "\tstruct String {\n";
+		out += "\t\tuint64_t hash;\n";
+		out += "\t\tuint32_t length; // without the null\n";
+		out += "\t\tuint32_t id; // numbered from 0, so it can index tables\n\n";
+		out += "\t\t// the characters follow, null terminated\n";
+		out += "\t\tconst char* c_str() const { return reinterpret_cast<const char*>(this + 1); }\n";
+		out += "\t};\n\n";
+
 		out += "\tenum class TypeId {\n";
 		for (const auto& s : structures) {
 			out += "\t\t" + s.name + ",\n";
@@ -70,21 +524,138 @@ namespace sg {
 
 		out += "\t#define SG_COMPONENTS";
 		for (const auto& s : structures) {
-			out += "\\\n\t\tX(" + s.name + ")";
+			if (s.hotStructure == CppStructure::NO_STRUCTURE)
+				out += "\\\n\t\tX(" + s.name + ")";
 		}
 
 		out += "\n\n";
 
+		// the cold parts of components, they are only reached through FindColdComponents
+		out += "\t#define SG_COLD_COMPONENTS";
 		for (const auto& s : structures) {
+			if (s.hotStructure != CppStructure::NO_STRUCTURE)
+				out += "\\\n\t\tX(" + s.name + ")";
+		}
+
+		out += "\n\n";
+
+		for (const CppEnum& e : enums) {
+			out += "\n";
+			out += "\tenum class " + e.name + " : " + EnumUnderlyingType(e) + " {\n";
+			for (const CppEnumerator& v : e.enumerators) {
+				out += "\t\t" + v.name + " = " + std::to_string(v.value) + ",\n";
+			}
+			out += "\t};\n";
+		}
+
+		for (size_t structure = 0; structure < structures.size(); ++structure) {
+			const CppStructure& s = structures[structure];
+			const std::vector<uint8_t>& component = defaults[structure];
+
 			out += "\n";
 			out += "\tstruct alignas(16) " + s.name + " {\n";
-			out += "\t\tstatic const TypeId StaticTypeId = TypeId::" + s.name + ";\n\n";
+			out += "\t\tstatic const TypeId StaticTypeId = TypeId::" + s.name + ";\n";
+			out += "\t\tstatic const bool ParallelSafe = ";
+			out += IsParallelSafe(structures, s) ? "true" : "false";
+			out += "; // true when it refers to no other component\n";
+
+			if (s.coldStructure != CppStructure::NO_STRUCTURE)
+				out += "\t\tusing Cold = struct " + structures[s.coldStructure].name + "; // see FindColdComponents\n";
+
+			if (!component.empty())
+				out += "\t\tstatic const " + s.name + " Default; // every property at its default value, the same as " + s.name + "{}\n";
 
+			out += "\n";
+
+			// declared in the order CalcLayouts placed them
+			std::vector<const CppMember*> placed;
 			for (const auto& m : s.members) {
-				out += "\t\t" + TranslateTypeName(m) + " " + m.name + ";\n";
+				if (!m.cold)
+					placed.push_back(&m);
+			}
+
+			if (s.size != 0) {
+				std::stable_sort(placed.begin(), placed.end(), [](const CppMember* a, const CppMember* b) {
+					return a->offset < b->offset;
+				});
+			}
+
+			for (const CppMember* m : placed) {
+				const std::string initializer = component.empty() ? "" : DefaultInitializer(*m, component.data());
+				const std::string assignment = initializer.empty() ? "" : " = " + initializer;
+
+				if (m->quantization.kind != CppEncoding::Kind::None)
+					out += "\t\t" + std::string(EncodedTypeName(m->quantization)) + " " + m->name + "Encoded" + assignment + "; // " + m->encoding + "\n";
+				else if (m->inlineOf != CppMember::NO_MEMBER)
+					out += "\t\t" + TranslateTypeName(*m) + " " + m->name + "; // a copy of *" + s.members[m->inlineOf].name + "\n";
+				else
+					out += "\t\t" + TranslateTypeName(*m) + " " + m->name + assignment + ";\n";
+			}
+
+			bool first_accessor = true;
+			for (const CppMember& m : s.members) {
+				if (m.quantization.kind == CppEncoding::Kind::None || m.cold)
+					continue;
+
+				if (first_accessor)
+					out += "\n";
+
+				out += "\t\t" + TranslateTypeName(m) + " " + m.name + "() const { return " + DecodeExpression(m) + "; }\n";
+				first_accessor = false;
+			}
+
+			// called by InlineCopiesMatch for every component of the type, nested components check their own copies
+			if (HasInlineCopies(structures, s)) {
+				std::vector<std::string> checks;
+				for (const CppMember& m : s.members) {
+					if (m.cold)
+						continue;
+
+					if (m.inlineOf != CppMember::NO_MEMBER) {
+						const std::string& ref = s.members[m.inlineOf].name;
+						checks.push_back("!" + ref + " || std::memcmp(&" + m.name + ", " + ref + ".get(), sizeof(" + m.name + ")) == 0");
+						continue;
+					}
+
+					if (m.typeName != "component")
+						continue;
+
+					for (const CppStructure& nested : structures) {
+						if (nested.name == m.defaultValue && HasInlineCopies(structures, nested))
+							checks.push_back(m.name + ".inlineCopiesMatch()");
+					}
+				}
+
+				std::string all_checks;
+				for (const std::string& check : checks) {
+					const bool grouped = checks.size() > 1 && check.find("||") != std::string::npos;
+					all_checks += (all_checks.empty() ? "" : " &&\n\t\t\t\t") + (grouped ? "(" + check + ")" : check);
+				}
+
+				out += "\n\t\t// whether every inline copy still matches the component it was copied from, see InlineCopiesMatch\n";
+				out += "\t\tbool inlineCopiesMatch() const {\n";
+				out += "\t\t\treturn " + all_checks + ";\n";
+				out += "\t\t}\n";
 			}
 
 			out += "\t};\n";
+
+			// the scene compiler writes components using this layout, make sure the C++ compiler agrees
+			if (s.size != 0) {
+				out += "\n";
+				out += "\tstatic_assert(sizeof(" + s.name + ") == " + std::to_string(s.size) + ", \"" + s.name + " does not match the SG Edit layout\");\n";
+
+				for (const auto& m : s.members) {
+					if (m.cold)
+						continue;
+
+					const std::string field = m.quantization.kind != CppEncoding::Kind::None ? m.name + "Encoded" : m.name;
+					out += "\tstatic_assert(offsetof(" + s.name + ", " + field + ") == " + std::to_string(m.offset) + ", \"" + s.name + "::" + m.name + " does not match the SG Edit layout\");\n";
+				}
+			}
+
+			if (!component.empty())
+				out += "\n\tconstexpr " + s.name + " " + s.name + "::Default = {};\n";
 		}
 
 		out += "\n";
@@ -94,16 +665,28 @@ namespace sg {
 		out += "\t};\n\n";
 
 		out += "\tstruct Scene {\n";
-		out += "\t\tconst void **components;\n";
-		out += "\t\tuintptr_t componentCount;\n\n";
-		out += "\t\tconst ComponentRange *componentRanges;\n";
-		out += "\t\tuintptr_t componentRangeCount;\n";
+		out += "\t\tRef<Ref<void>> components;\n";
+		out += "\t\tuint64_t componentCount;\n\n";
+		out += "\t\tRef<ComponentRange> componentRanges;\n";
+		out += "\t\tuint64_t componentRangeCount;\n";
 		out += "\t};\n";
 
-		out += "\n\tconst Scene* ToScene(void *data);\n\n";
-		out += "#ifdef SG_BUILDER\n";
-		out += "\tconst std::vector<uint8_t> ToBytes(const Scene* scene);\n";
-		out += "#endif\n";
+		out += "\n\t// scenes compiled for different components than these have to be converted with ConvertScene\n";
+		out += "\tstatic const uint64_t SCHEMA_HASH = " + FormatHash(SchemaHash(structures)) + ";\n";
+
+		out += "\n\t// The Refs to the cold parts of the components of a range, in the same order as the range, nullptr when its\n";
+		out += "\t// components have no cold part. The range's type has a Cold member type for them.\n";
+		out += "\tconst Ref<void>* FindColdComponents(const Scene* scene, uint64_t range_index);\n";
+
+		out += "\n\t// Whether every copy the scene compiler made of the target of an inline component_ref still matches its target. It\n";
+		out += "\t// reads every component holding a copy, so it is meant for debug builds.\n";
+		out += "\tbool InlineCopiesMatch(const Scene* scene);\n";
+
+		out += "\n\t// the layouts above the way scene files store them, see SceneSchema.h\n";
+		out += "\tconst struct SceneSchema& GeneratedSchema();\n";
+
+		out += "\n\t// the scene in a file produced by the SG Edit scene compiler, the file must pass ValidateSceneHeader first\n";
+		out += "\tconst Scene* ToScene(const void *data);\n";
 
 		out += "}\n";
 
@@ -113,11 +696,12 @@ namespace sg {
 		}
 
 		fwrite(out.c_str(), out.length(), 1, fp);
+		fclose(fp);
 
 		return Ok();
 	}
 
-	static Result<> WriteSource(const std::vector<CppStructure>& structures, const std::string& cpp_path, const std::string& header_path) {
+	static Result<> WriteSource(const std::vector<CppStructure>& structures, const std::vector<std::vector<uint8_t>>& defaults, const std::string& cpp_path, const std::string& header_path) {
 
 		std::cout << "Writing" << cpp_path << std::endl;
 
@@ -134,117 +718,131 @@ namespace sg {
 			QFileInfo cpp_path_info(cpp_path.c_str());
 			QFileInfo header_path_info(header_path.c_str());
 
-			out += "#include \"" + cpp_path_info.absoluteDir().relativeFilePath(header_path_info.absoluteFilePath()).toStdString() + "\"\n\n";
+			out += "#include \"" + cpp_path_info.absoluteDir().relativeFilePath(header_path_info.absoluteFilePath()).toStdString() + "\"\n";
+			out += "#include \"SceneFormat.h\"\n";
+			out += "#include \"SceneSchema.h\"\n\n";
 		}
 
 		out += "namespace sg {\n\n";
-		out += "const Scene* ToScene(void *data) {\n\n";
-		out += "#if SG_IMPL\n";
-		out += "\tconst uintptr_t data_start = uintptr_t(data);\n\n";
-		out += "\tScene *result = reinterpret_cast<Scene*>(data);\n";
-		out += "\tresult->components = reinterpret_cast<const void**>(data_start + reinterpret_cast<uintptr_t>(result->components));\n";
-		out += "\tresult->componentRanges = reinterpret_cast<const ComponentRange*>(data_start + reinterpret_cast<uintptr_t>(result->componentRanges));\n";
-		out += "\tconst ComponentRange* r = result->componentRanges;\n";
-		out += "\tconst ComponentRange* r_end = result->componentRanges + result->componentRangeCount;\n";
-		out += "\tconst void** c = result->components;\n";
 
-		for (const CppStructure& s: structures) {
-			out += "\n\tif (r->typeId == TypeId::" + s.name + ") {\n";
-
-			bool needs_fixup = false;
-
-			for (const CppMember& m : s.members) {
-				if (m.typeName == "component_ref") {
+		out += "\tstatic_assert(sizeof(String) == sizeof(SceneString) && offsetof(String, hash) == offsetof(SceneString, hash) &&\n";
+		out += "\t\toffsetof(String, length) == offsetof(SceneString, length) && offsetof(String, id) == offsetof(SceneString, id), \"String does not match SceneString\");\n\n";
 
-					if (!needs_fixup) {
+		out += "\tconst Scene* ToScene(const void *data) {\n";
+		out += "\t\tconst SceneFileHeader *header = reinterpret_cast<const SceneFileHeader*>(data);\n";
+		out += "\t\treturn reinterpret_cast<const Scene*>(reinterpret_cast<const char*>(data) + header->sections[SCENE_SECTION_SCENE].offset);\n";
+		out += "\t}\n";
 
-						out += "\t\tfor (const void* c_end = c + r->count; c < c_end; ++c) {\n";
+		const SceneSchemaTables tables = BuildSceneSchema(structures);
 
-						out += "\t\t\t" + s.name + " *v = reinterpret_cast<" + s.name + "*>(c);\n";
-						needs_fixup = true;
-					}
+		// name, size, first member, member count
+		if (!tables.types.empty()) {
+			out += "\n\tstatic const SceneSchemaType SCHEMA_TYPES[] = {\n";
+			for (size_t n = 0; n < tables.types.size(); ++n) {
+				const SceneSchemaType& type = tables.types[n];
+				out += "\t\t{" + FormatHash(type.nameHash) + ", " + std::to_string(type.size) + ", " + std::to_string(type.firstMember) + ", ";
+				out += std::to_string(type.memberCount) + ", 0}, // " + structures[n].name + "\n";
+			}
+			out += "\t};\n";
+		}
 
-					out += "\t\t\tv->" + m.name + " = reinterpret_cast<" + m.defaultValue + "*>(data_start + uintptr_t(v->" + m.name + "));\n";
+		// name, type, nested or referenced component, offset, size
+		if (!tables.members.empty()) {
+			out += "\n\tstatic const SceneSchemaMember SCHEMA_MEMBERS[] = {\n";
+			size_t member_index = 0;
+			for (const CppStructure& s : structures) {
+				for (const CppMember& m : s.members) {
+					if (m.cold)
+						continue;
+
+					const SceneSchemaMember& member = tables.members[member_index++];
+					out += "\t\t{" + FormatHash(member.nameHash) + ", " + FormatHash(member.typeHash) + ", " + FormatHash(member.targetHash) + ", ";
+					out += std::to_string(member.offset) + ", " + std::to_string(member.size) + "}, // " + s.name + "::" + m.name + "\n";
 				}
 			}
+			out += "\t};\n";
+		}
 
-			if (needs_fixup) {
-				out += "\t\t}\n";
-			} else {
-				out += "\t\tc += r->count;\n";
+		// what a converted scene starts each component from, the same structures the header declares Default for
+		if (!structures.empty()) {
+			out += "\n\tstatic const void* const SCHEMA_DEFAULTS[] = {";
+			for (size_t n = 0; n < structures.size(); ++n) {
+				out += n == 0 ? "" : ", ";
+				out += defaults[n].empty() ? "nullptr" : "&" + structures[n].name + "::Default";
 			}
-
-			out += "\t\tif (++r == r_end)\n";
-			out += "\t\t\treturn result;\n";
-			out += "\t}\n";
-
+			out += "};\n";
 		}
-		out += "\treturn result;\n";
-		out += "#endif\nreturn nullptr;\n";
 
-		out += "}\n";
+		const std::string types = tables.types.empty() ? "nullptr" : "SCHEMA_TYPES";
+		const std::string members = tables.members.empty() ? "nullptr" : "SCHEMA_MEMBERS";
+		const std::string schema_defaults = structures.empty() ? "nullptr" : "SCHEMA_DEFAULTS";
 
-		out += "\n#ifdef SG_BUILDER\n";
-		out += "struct SceneSizes {\n";
-		out += "\tsize_t scene_size;\n";
-		out += "\tsize_t component_array_size;\n";
-		out += "\tsize_t component_size;\n";
-		out += "\tsize_t text_size;\n";
-		out += "}\n";
-		out += "SceneSizes CalcByteSize(const Scene *scene) {\n\n";
-		out += "\tSceneSizes result;\n";
-		out += "\tresult.scene_size = sizeof(Scene);\n";
-		out += "\tresult.component_array_size + sizeof(DeferredPtr) * scene->component_count;\n";
-		out += "\tresult.component_size = 0;\n";
-		out += "\tresult.text_size = 0;\n\n";
-
-		out += "\tfor (const DeferredPtr& p : *scene) {\n\n";
-		out += "\t\tswitch (p.typeId) {\n";
+		// the TypeId of the cold part of each TypeId
+		std::string cold_types;
 		for (const CppStructure& s : structures) {
-			out += "\n\t\t\tcase TypeId::" + s.name + " {\n";
-			out += "\t\t\t\tresult.component_size += sizeof(" + s.name + ");\n";
-
-			bool first = true;
-			for (const CppMember& m : s.members) {
-				if (m.typeName == "text") {
-
-					if (first) {
-						out += "\t\t\t\tconst " + s.name + " *c = reinterpret_cast<const " + s.name + "*>(p.ptr);\n";
-					}
+			cold_types += cold_types.empty() ? "" : ", ";
+			cold_types += s.coldStructure == CppStructure::NO_STRUCTURE ? "NO_COLD" : std::to_string(s.coldStructure);
+		}
 
+		out += "\n\tconst Ref<void>* FindColdComponents(const Scene* scene, uint64_t range_index) {\n";
+		out += "\t\tstatic const uint32_t NO_COLD = ~0u;\n";
+		out += "\t\tstatic const uint32_t COLD_TYPES[] = {" + cold_types + "};\n\n";
+		out += "\t\tconst ComponentRange* ranges = scene->componentRanges.get();\n";
+		out += "\t\tconst uint32_t cold_type = range_index < scene->componentRangeCount && uint32_t(ranges[range_index].typeId) < " + std::to_string(structures.size()) + " ? COLD_TYPES[uint32_t(ranges[range_index].typeId)] : NO_COLD;\n\n";
+		out += "\t\t// the components of a range start after those of every range before it\n";
+		out += "\t\tuint64_t first = 0;\n";
+		out += "\t\tfor (uint64_t r = 0; r < scene->componentRangeCount && cold_type != NO_COLD; ++r) {\n";
+		out += "\t\t\tif (uint32_t(ranges[r].typeId) == cold_type)\n";
+		out += "\t\t\t\treturn ranges[r].count == ranges[range_index].count ? scene->components.get() + first : nullptr;\n\n";
+		out += "\t\t\tfirst += ranges[r].count;\n";
+		out += "\t\t}\n\n";
+		out += "\t\treturn nullptr;\n";
+		out += "\t}\n";
 
-					out += "\t\t\t\tresult.text_size += strlen(c->" + m.name + ");\n";
-				}
-			}
+		std::string copy_checks;
+		for (const CppStructure& s : structures) {
+			if (HasInlineCopies(structures, s))
+				copy_checks += "\t\t\t\tcase TypeId::" + s.name + ": if (!RangeCopiesMatch<" + s.name + ">(components, ranges[r].count)) return false; break;\n";
+		}
 
-			out += "\t\t\t} break;\n";
+		if (!copy_checks.empty()) {
+			out += "\n\ttemplate<typename T>\n";
+			out += "\tstatic bool RangeCopiesMatch(const Ref<void>* components, uint32_t count) {\n";
+			out += "\t\tfor (uint32_t n = 0; n < count; ++n) {\n";
+			out += "\t\t\tif (!static_cast<const T*>(components[n].get())->inlineCopiesMatch())\n";
+			out += "\t\t\t\treturn false;\n";
+			out += "\t\t}\n\n";
+			out += "\t\treturn true;\n";
+			out += "\t}\n";
 		}
 
-		out += "\t\t}\n";
+		out += "\n\tbool InlineCopiesMatch(const Scene* scene) {\n";
+		if (copy_checks.empty()) {
+			out += "\t\t// no component holds inline copies\n";
+			out += "\t\t(void)scene;\n";
+		} else {
+			out += "\t\tconst Ref<void>* components = scene->components.get();\n";
+			out += "\t\tconst ComponentRange* ranges = scene->componentRanges.get();\n\n";
+			out += "\t\t// the components of a range start after those of every range before it\n";
+			out += "\t\tfor (uint64_t r = 0; r < scene->componentRangeCount; components += ranges[r++].count) {\n";
+			out += "\t\t\tswitch (ranges[r].typeId) {\n";
+			out += copy_checks;
+			out += "\t\t\t\tdefault: break;\n";
+			out += "\t\t\t}\n";
+			out += "\t\t}\n\n";
+		}
+		out += "\t\treturn true;\n";
 		out += "\t}\n";
 
-		out += "\treturn result;\n";
-		out += "}\n\n"; 
-
-		out += "std::vector<uint8_t> ToBytes(const Scene *scene) {\n\n";
-		out += "\tconst SceneSizes sizes = CalcByteSize(scene);\n";
-		out += "\tstd::vector<uint8_t> result(sizes.scene_size + sizes.component_size + sizes.text_size);\n";
-		out += "\tScene* scene_start = reinterpret_cast<Scene*>(result.data());\n";
-		out += "\tDeferredPtr *out_p = reinterpret_cast<DeferredPtr*>(result.data() + sizes.scene_size);\n";
-		out += "\tuint8_t* component_start = result.data() + sizes.scene_size + sizes.component_array_size;\n";
-		out += "\tuint8_t* text_start = result.data() + sizes.text_size;\n";
-		out += "\treinterpret_cast<uintptr_t&>(scene_start->components) = sizeof(Scene);\n";
-		out += "\tscene_start->component_count = scene->component_count;\n";
-
-		out += "\tfor (const DeferredPtr& in_p : scene) {\n";
-		out += "\t\tDeferredPtr& out_p = ";
+		out += "\n\tconst SceneSchema& GeneratedSchema() {\n";
+		out += "\t\tstatic const SceneSchema schema = {SCHEMA_HASH, " + types + ", " + std::to_string(tables.types.size()) + ", ";
+		out += members + ", " + std::to_string(tables.members.size()) + ", " + schema_defaults + "};\n";
+		out += "\t\treturn schema;\n";
 		out += "\t}\n";
 
 		out += "}\n";
 
-		out += "#endif\n";
-
-		out += "}\n";
+		f.write(out.c_str(), out.length());
 
 		return Ok();
 	}
@@ -268,9 +866,50 @@ namespace sg {
 		return 0;
 	}
 
-	Result<> GenerateComponentFiles(const class Transaction& t, const std::string& header_path, const std::string& cpp_path) {
+	Result<std::vector<CppEnum>> QueryEnums(const Transaction& t) {
 
-		std::cout << "Generating" << header_path << cpp_path << std::endl;
+		QSqlQueryModel enum_values;
+		std::string statement = std::string("SELECT e.id, e.name, v.name, v.value FROM enum e LEFT JOIN enum_value v ON v.enum_id = e.id ORDER BY e.name, v.value, v.id");
+		enum_values.setQuery(statement.c_str(), *t.connection());
+		if (enum_values.lastError().isValid())
+			return Error(enum_values.lastError().text(), statement);
+
+		std::vector<CppEnum> enums;
+
+		for (int row = 0; row < enum_values.rowCount(); ++row) {
+
+			const id_t id = enum_values.data(enum_values.index(row, 0)).toLongLong();
+
+			if (enums.empty() || enums.back().id != id) {
+				CppEnum e;
+				e.id = id;
+				e.name = enum_values.data(enum_values.index(row, 1)).toString().toStdString();
+				enums.push_back(std::move(e));
+			}
+
+			// an enum with no values still has a row, with nulls from the join
+			const QVariant value_name = enum_values.data(enum_values.index(row, 2));
+			if (value_name.isNull())
+				continue;
+
+			CppEnumerator v;
+			v.name = value_name.toString().toStdString();
+			v.value = enum_values.data(enum_values.index(row, 3)).toLongLong();
+			enums.back().enumerators.push_back(std::move(v));
+		}
+
+		for (CppEnum& e : enums) {
+			CalcEnumLayout(e);
+		}
+
+		return Ok(std::move(enums));
+	}
+
+	Result<std::vector<CppStructure>> QueryComponentStructures(const Transaction& t) {
+
+		auto enums = QueryEnums(t);
+		if (enums.failed())
+			return enums.error();
 
 		QSqlQueryModel components;
 		std::string component_statement = std::string("SELECT name, id FROM component ORDER BY id");
@@ -278,8 +917,9 @@ namespace sg {
 		if (components.lastError().isValid())
 			return Error(components.lastError().text(), component_statement);
 
+		// ordered by id as well, so the member order (and therefore the layout) is stable between runs
 		QSqlQueryModel component_props;
-		std::string component_prop_statement = std::string("SELECT name, type, default_value, component_id, id FROM component_prop ORDER BY component_id");
+		std::string component_prop_statement = std::string("SELECT name, type, default_value, component_id, id, encoding, cold, sort_key, inline_target FROM component_prop ORDER BY component_id, id");
 		component_props.setQuery(component_prop_statement.c_str(), *t.connection());
 		if (component_props.lastError().isValid())
 			return Error(component_props.lastError().text(), component_prop_statement);
@@ -300,27 +940,126 @@ namespace sg {
 			const int id = components.data(components.index(row, 1)).toInt();
 
 			CppStructure s;
+			s.id = id;
 			s.name = components.data(components.index(row, 0)).toString().toStdString();
 
+			bool has_sort_key = false;
+
 			while (component_props.data(component_props.index(prop_row, 3)).toInt() == id) {
 
 				CppMember m;
 				m.name = component_props.data(component_props.index(prop_row, 0)).toString().toStdString();
 				m.typeName = component_props.data(component_props.index(prop_row, 1)).toString().toStdString();
 				m.defaultValue = component_props.data(component_props.index(prop_row, 2)).toString().toStdString();
+				m.id = component_props.data(component_props.index(prop_row, 4)).toLongLong();
+				m.encoding = component_props.data(component_props.index(prop_row, 5)).toString().trimmed().toStdString();
+				m.cold = component_props.data(component_props.index(prop_row, 6)).toBool();
+				m.sortKey = component_props.data(component_props.index(prop_row, 7)).toBool();
+				m.inlineTarget = component_props.data(component_props.index(prop_row, 8)).toBool();
+
+				if (!m.encoding.empty()) {
+					if (m.typeName != "f32" && m.typeName != "f64")
+						return Error(s.name + "::" + m.name + " has encoding '" + m.encoding + "', only f32 and f64 properties can be encoded");
+
+					auto encoding = ParseEncoding(m.encoding);
+					if (encoding.failed())
+						return Error(s.name + "::" + m.name + ": " + encoding.errorMessage(), encoding.errorInfo());
+
+					m.quantization = *encoding;
+				}
+
+				if (m.sortKey) {
+					static const char* SORTABLE_TYPES[] = {"i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64", "enum"};
+
+					if (std::find(std::begin(SORTABLE_TYPES), std::end(SORTABLE_TYPES), m.typeName) == std::end(SORTABLE_TYPES) || !m.encoding.empty())
+						return Error(s.name + "::" + m.name + " can't be a sort key, only numbers and enums stored at full precision can");
+
+					if (m.cold)
+						return Error(s.name + "::" + m.name + " can't be a sort key, it is cold");
+
+					if (has_sort_key)
+						return Error(s.name + " has more than one sort key, " + m.name + " is the second");
+
+					has_sort_key = true;
+				}
 
 				if (m.typeName == "component") {
 					dependencies[m.defaultValue].push_back(s.name);
 				}
 
+				// renaming an enum or one of its values doesn't update the default values that name it, without this the
+				// component would quietly lose its runtime representation
+				if (m.typeName == "enum") {
+					const size_t separator = m.defaultValue.find("::");
+					const std::string enum_name = m.defaultValue.substr(0, separator);
+
+					for (const CppEnum& e : *enums) {
+						if (e.name == enum_name)
+							m.enumeration = e;
+					}
+
+					if (m.enumeration.id == -1)
+						return Error(s.name + "::" + m.name + " uses unknown enum '" + enum_name + "'");
+
+					if (separator != std::string::npos) {
+						const std::string value_name = m.defaultValue.substr(separator + 2);
+						const auto& values = m.enumeration.enumerators;
+
+						if (std::none_of(values.begin(), values.end(), [&](const CppEnumerator& v) { return v.name == value_name; }))
+							return Error(s.name + "::" + m.name + " defaults to '" + value_name + "', which is not a value of " + enum_name);
+					}
+				}
+
+				if (m.inlineTarget) {
+					if (m.typeName != "component_ref")
+						return Error(s.name + "::" + m.name + " can't be inline, only component_ref properties can");
+
+					if (m.cold)
+						return Error(s.name + "::" + m.name + " can't be inline, it is cold");
+				}
+
+				const bool inline_target = m.inlineTarget;
 				s.members.push_back(std::move(m));
 
+				// laid out like a nested component, so the target has to be laid out first
+				if (inline_target) {
+					CppMember copy;
+					copy.typeName = "component";
+					copy.name = s.members.back().name + "Inline";
+					copy.defaultValue = s.members.back().defaultValue;
+					copy.inlineOf = s.members.size() - 1;
+
+					dependencies[copy.defaultValue].push_back(s.name);
+					s.members.push_back(std::move(copy));
+				}
+
 				++prop_row;
 			}
 
 			structures.push_back(std::move(s));
 		}
 
+		for (const CppStructure& s : structures) {
+			for (const CppMember& m : s.members) {
+				if (m.inlineOf == CppMember::NO_MEMBER)
+					continue;
+
+				const std::string& ref_name = s.members[m.inlineOf].name;
+
+				for (const CppMember& other : s.members) {
+					if (&other != &m && other.name == m.name)
+						return Error(s.name + "::" + m.name + " holds the copy of " + ref_name + ", but " + s.name + " already has a property with that name");
+				}
+
+				auto target = std::find_if(structures.begin(), structures.end(), [&](const CppStructure& t) { return t.name == m.defaultValue; });
+				if (target == structures.end())
+					return Error(s.name + "::" + ref_name + " can't be inline, there is no component '" + m.defaultValue + "'");
+
+				if (!IsPlainData(structures, *target))
+					return Error(s.name + "::" + ref_name + " can't be inline, " + target->name + " has text or references, which only mean something where they are written");
+			}
+		}
+
 		std::map<std::string, int> dependency_depth;
 		for (const CppStructure& s : structures) {
 			int depth = CalcDepth(dependencies, s.name);
@@ -343,13 +1082,144 @@ namespace sg {
 		});
 
 		{
-			auto res = WriteHeader(structures, header_path);
+			auto res = SplitColdStructures(structures);
+			if (res.failed())
+				return res.error();
+		}
+
+		CalcLayouts(structures);
+
+		return Ok(std::move(structures));
+	}
+
+	uint64_t SchemaHash(const std::vector<CppStructure>& structures) {
+
+		Hasher h;
+		h.value(structures.size());
+
+		for (const CppStructure& s : structures) {
+			h.text(s.name).value(s.size).value(s.members.size());
+
+			for (const CppMember& m : s.members) {
+				h.text(m.typeName).text(m.name).value(m.offset).value(m.size);
+
+				// the type of a nested component or reference is kept in the default value
+				if (m.typeName == "component" || m.typeName == "component_ref")
+					h.text(m.defaultValue);
+
+				// cold moves the member to another range
+				h.text(m.encoding).value(m.cold);
+
+				// renumbering an enum changes what the stored values mean
+				if (m.typeName == "enum") {
+					h.text(m.enumeration.name).value(m.enumeration.enumerators.size());
+
+					for (const CppEnumerator& v : m.enumeration.enumerators) {
+						h.text(v.name).value(v.value);
+					}
+				}
+			}
+		}
+
+		return h.result();
+	}
+
+	SceneSchema SceneSchemaTables::schema() const {
+
+		SceneSchema result;
+		result.hash = hash;
+		result.types = types.data();
+		result.typeCount = uint32_t(types.size());
+		result.members = members.data();
+		result.memberCount = uint32_t(members.size());
+		return result;
+	}
+
+	// the values are part of it, so a scene converted after the enum was renumbered resets the member instead of reading
+	// the old numbers as other values
+	static uint64_t EnumSchemaHash(const CppEnum& e) {
+
+		Hasher h;
+		h.text(e.name).value(e.enumerators.size());
+
+		for (const CppEnumerator& v : e.enumerators) {
+			h.text(v.name).value(v.value);
+		}
+
+		return h.result();
+	}
+
+	SceneSchemaTables BuildSceneSchema(const std::vector<CppStructure>& structures) {
+
+		SceneSchemaTables tables;
+		tables.hash = SchemaHash(structures);
+
+		for (const CppStructure& s : structures) {
+
+			SceneSchemaType type = {};
+			type.nameHash = StringHash(s.name.data(), s.name.size());
+			type.size = uint32_t(s.size);
+			type.firstMember = uint32_t(tables.members.size());
+
+			for (const CppMember& m : s.members) {
+
+				// part of the cold structure instead
+				if (m.cold)
+					continue;
+
+				SceneSchemaMember member = {};
+				member.nameHash = StringHash(m.name.data(), m.name.size());
+				member.typeHash = StringHash(m.typeName.data(), m.typeName.size());
+
+				// encoded values only convert to the same encoding
+				if (!m.encoding.empty()) {
+					const std::string encoded_type = m.typeName + ":" + m.encoding;
+					member.typeHash = StringHash(encoded_type.data(), encoded_type.size());
+				}
+				member.offset = uint32_t(m.offset);
+				member.size = uint32_t(m.size);
+
+				// the type of a nested component or reference is kept in the default value
+				if (m.typeName == "component" || m.typeName == "component_ref")
+					member.targetHash = StringHash(m.defaultValue.data(), m.defaultValue.size());
+				else if (m.typeName == "enum")
+					member.targetHash = EnumSchemaHash(m.enumeration);
+
+				tables.members.push_back(member);
+			}
+
+			type.memberCount = uint32_t(tables.members.size()) - type.firstMember;
+			tables.types.push_back(type);
+		}
+
+		return tables;
+	}
+
+	Result<> GenerateComponentFiles(const class Transaction& t, const std::string& header_path, const std::string& cpp_path) {
+
+		std::cout << "Generating" << header_path << cpp_path << std::endl;
+
+		auto enums = QueryEnums(t);
+		if (enums.failed())
+			return enums.error();
+
+		auto structures = QueryComponentStructures(t);
+		if (structures.failed())
+			return structures.error();
+
+		// the initializers of the generated members are the defaults the scene compiler writes
+		auto defaults = EncodeDefaultComponents(*structures);
+		if (defaults.failed())
+			return defaults.error();
+
+		{
+			auto res = WriteHeader(*enums, *structures, *defaults, header_path);
 			if (res.failed())
 				return res.error();
 		}
 
 		{
-			auto res = WriteSource(structures, cpp_path, header_path);
+			auto res = WriteSource(*structures, *defaults, cpp_path, header_path);
 			if (res.failed())
 				return res.error();
 		}
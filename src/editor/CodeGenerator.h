@@ -1,9 +1,132 @@
 #pragma once
 
 #include "Result.h"
+#include "SceneSchema.h"
+#include "Types.h"
 #include <string>
+#include <vector>
 
 namespace sg {
 
-	Result<> GenerateComponentFiles(const class Transaction& t, const std::string& header_path, const std::string& source_path);	
+	struct CppEnumerator {
+		std::string name;
+		int64_t value = 0;
+	};
+
+	struct CppEnum {
+		id_t id = -1;
+		std::string name;
+		std::vector<CppEnumerator> enumerators; // ordered by value
+
+		// the smallest integer that holds every value, see CalcEnumLayout
+		size_t size = 0;
+		bool isSigned = false;
+	};
+
+	// How an f32 or f64 property is stored when it doesn't need full precision, read from the encoding column of
+	// component_prop: f16, unorm8, unorm16, snorm8, snorm16, fixed8(min, max) or fixed16(min, max). See Quantize.h.
+	struct CppEncoding {
+		enum class Kind {
+			None,
+			Half,
+			Unorm,
+			Snorm,
+			Fixed
+		};
+
+		Kind kind = Kind::None;
+		size_t size = 0; // bytes stored, 0 when the property is stored at full precision
+		float min = 0.0f; // the range of fixed
+		float max = 1.0f;
+	};
+
+	Result<CppEncoding> ParseEncoding(const std::string& encoding);
+
+	struct CppMember {
+		static const size_t NO_MEMBER = ~size_t(0);
+
+		id_t id = -1; // -1 for members the code generator adds, which have no property
+		std::string typeName;
+		std::string name;
+		std::string defaultValue;
+
+		// enum members name their enum in defaultValue, "Enum" or "Enum::Default", this is that enum.
+		// QueryComponentStructures fails when it or the default value doesn't exist.
+		CppEnum enumeration;
+
+		// "" for full precision, otherwise the generated struct stores the encoded value as <name>Encoded and decodes it
+		// through an accessor named after the property
+		std::string encoding;
+		CppEncoding quantization;
+
+		// stored in the cold part of the component, see CppStructure::coldStructure
+		bool cold = false;
+
+		// compiled scenes order the component's range by this member instead of by position, at most one per component
+		bool sortKey = false;
+
+		// A component_ref whose target is copied next to it, so reading the target doesn't follow the reference. The copy is
+		// a member of its own, <name>Inline, that comes straight after it and has this member's index as inlineOf. Only
+		// components with no text or references of their own can be copied, and a copy is never written to.
+		bool inlineTarget = false;
+		size_t inlineOf = NO_MEMBER;
+
+		// where this member lives inside the generated struct, see CalcLayouts
+		size_t offset = 0;
+		size_t size = 0;
+		size_t alignment = 0;
+	};
+
+	struct CppStructure {
+		static const size_t NO_STRUCTURE = ~size_t(0);
+
+		id_t id = -1; // -1 for the cold part of a component
+		std::string name;
+		std::vector<CppMember> members;
+
+		size_t size = 0;
+		size_t alignment = 0;
+
+		// A component with cold properties is split in two. Its cold members are left out of its own layout, and are laid
+		// out again in a structure of their own, <name>Cold, that comes after every component. Scenes write the cold parts
+		// to a range of their own in the same order, so the cold part of the n'th component of a range is the n'th of the
+		// cold range, and code that only reads the rest of the component never brings the cold part into cache.
+		size_t coldStructure = NO_STRUCTURE;
+		size_t hotStructure = NO_STRUCTURE; // set on <name>Cold, the component it is the cold part of
+	};
+
+	// Reads every enum and its values, ordered by name, with their layouts calculated.
+	Result<std::vector<CppEnum>> QueryEnums(const class Transaction& t);
+
+	// Picks the smallest integer type that holds every value of e, an empty enum still takes a byte.
+	void CalcEnumLayout(CppEnum& e);
+
+	// Reads every component and its properties. The result is in TypeId order, and the layout of every structure
+	// matches what the C++ compiler produces for the generated header.
+	Result<std::vector<CppStructure>> QueryComponentStructures(const class Transaction& t);
+
+	// Appends the cold part of every component with cold members, see CppStructure::coldStructure. A component with cold
+	// members can't be nested in another, there would be nowhere to put the cold part.
+	Result<> SplitColdStructures(std::vector<CppStructure>& structures);
+
+	// Structures must be in dependency order, so nested components are laid out before they are used. Members are placed
+	// largest alignment first rather than in declaration order, so small members such as enums pack into what would
+	// otherwise be padding. Structures with a member that can't be represented at runtime are left with a size of 0.
+	void CalcLayouts(std::vector<CppStructure>& structures);
+
+	// Identifies the generated code for a set of structures, it changes whenever a compiled scene would be read differently.
+	uint64_t SchemaHash(const std::vector<CppStructure>& structures);
+
+	// The layouts of the structures the way scene files store them, so scenes can be converted when components change.
+	struct SceneSchemaTables {
+		uint64_t hash = 0;
+		std::vector<SceneSchemaType> types;
+		std::vector<SceneSchemaMember> members;
+
+		SceneSchema schema() const;
+	};
+
+	SceneSchemaTables BuildSceneSchema(const std::vector<CppStructure>& structures);
+
+	Result<> GenerateComponentFiles(const class Transaction& t, const std::string& header_path, const std::string& source_path);
 }
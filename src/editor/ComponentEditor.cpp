@@ -13,6 +13,7 @@
 #include <QComboBox>
 #include <QDebug>
 
+#include "CodeGenerator.h"
 #include "MessageBox.h"
 #include "Controller.h"
 #include <QTreeView>
@@ -70,7 +71,11 @@ namespace sg {
 		static const int NAME_COL = 0;
 		static const int TYPE_COL = 1;
 		static const int DEFAULT_VALUE_COL = 2;
-		static const int ID_COL = 3;
+		static const int ENCODING_COL = 3;
+		static const int COLD_COL = 4;
+		static const int SORT_KEY_COL = 5;
+		static const int INLINE_COL = 6;
+		static const int ID_COL = 7;
 
 		ComponentPropModel(Controller& controller, QObject* parent, id_t component_id)
 		: QSqlQueryModel(parent)
@@ -82,7 +87,7 @@ namespace sg {
 		}
 
 		void refresh() {
-			setQuery(QString("SELECT name AS \"Name\", type AS \"Type\", default_value AS \"Default Value\", id FROM component_prop WHERE component_id = %1").arg(qlonglong(mComponentId)));
+			setQuery(QString("SELECT name AS \"Name\", type AS \"Type\", default_value AS \"Default Value\", encoding AS \"Encoding\", cold AS \"Cold\", sort_key AS \"Sort Key\", inline_target AS \"Inline\", id FROM component_prop WHERE component_id = %1").arg(qlonglong(mComponentId)));
 		}
 
 		bool containsName(const QString& name) const {
@@ -168,6 +173,51 @@ namespace sg {
 				}
 				break;
 
+				case ENCODING_COL: {
+					// checked here so a typo is reported now rather than at the next code generation
+					auto encoding = ParseEncoding(value.toString().trimmed().toStdString());
+					auto res = encoding.failed() ? Result<>(encoding.error()) : perform("encoding", false);
+
+					if (res.failed()) {
+						MessageBoxCritical(ComponentEditor::tr("Unable to change encoding"), res.errorMessage(), res.errorInfo());
+						return false;
+					}
+				}
+				break;
+
+				case COLD_COL: {
+					const QString cold = value.toString().trimmed().toLower();
+					auto res = cold != "true" && cold != "false" ? Result<>(Error("Cold is true or false, not '"_sb + value.toString() + "'")) : perform("cold", false);
+
+					if (res.failed()) {
+						MessageBoxCritical(ComponentEditor::tr("Unable to change cold"), res.errorMessage(), res.errorInfo());
+						return false;
+					}
+				}
+				break;
+
+				case SORT_KEY_COL: {
+					const QString sort_key = value.toString().trimmed().toLower();
+					auto res = sort_key != "true" && sort_key != "false" ? Result<>(Error("Sort Key is true or false, not '"_sb + value.toString() + "'")) : perform("sort_key", false);
+
+					if (res.failed()) {
+						MessageBoxCritical(ComponentEditor::tr("Unable to change sort key"), res.errorMessage(), res.errorInfo());
+						return false;
+					}
+				}
+				break;
+
+				case INLINE_COL: {
+					const QString inline_target = value.toString().trimmed().toLower();
+					auto res = inline_target != "true" && inline_target != "false" ? Result<>(Error("Inline is true or false, not '"_sb + value.toString() + "'")) : perform("inline_target", false);
+
+					if (res.failed()) {
+						MessageBoxCritical(ComponentEditor::tr("Unable to change inline"), res.errorMessage(), res.errorInfo());
+						return false;
+					}
+				}
+				break;
+
 				default:
 					return false;
 			}
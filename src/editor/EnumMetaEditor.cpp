@@ -0,0 +1,447 @@
+#include "EnumMetaEditor.h"
+#include "Controller.h"
+#include "MessageBox.h"
+#include "FormatString.h"
+
+#include <QListView>
+#include <QTreeView>
+#include <QSqlQueryModel>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QAction>
+#include <QSortFilterProxyModel>
+
+#include <algorithm>
+
+namespace sg {
+
+	class EnumModel : public QSqlQueryModel {
+		Controller& mController;
+	public:
+
+		static const int NAME_COL = 0;
+		static const int ID_COL = 1;
+
+		EnumModel(Controller& controller, QObject* parent)
+		: QSqlQueryModel(parent)
+		, mController(controller)
+		{}
+
+		void refresh() {
+			static const QString select_query = QString("SELECT name, id FROM enum");
+			setQuery(select_query);
+		}
+
+		Qt::ItemFlags flags(const QModelIndex& index) const override {
+			return QSqlQueryModel::flags(index) | Qt::ItemIsEditable;
+		};
+
+		bool containsName(const QString& name) const {
+
+			for (int row = 0; row < rowCount(); ++row) {
+				if (data(index(row, NAME_COL)).toString() == name)
+					return true;
+			}
+
+			return false;
+		}
+
+		bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) {
+			if (role != Qt::EditRole) {
+				return QSqlQueryModel::setData(index, value, role);
+			}
+
+			auto perform = [&]() -> Result<> {
+
+				QString current_name = data(index).toString();
+				QString new_name = value.toString();
+
+				if (current_name == new_name)
+					return Ok(); // ignore rename
+
+				if (containsName(new_name)) {
+					return Error("Enum named '"_sb + new_name + "' already exists");
+				}
+
+				auto t = mController.createTransaction("Rename Enum");
+
+				{
+					auto res = t.update(
+						"enum",
+						{{"name", new_name}},
+						{{"name", current_name}},
+						"id",
+						this->data(this->index(index.row(), ID_COL, index.parent()))
+					);
+
+					if (res.failed())
+						return res.error();
+				}
+
+				return t.commit();
+			};
+
+			auto res = perform();
+			if (res.failed()) {
+				MessageBoxCritical(EnumMetaEditor::tr("Unable to rename enum"), res.errorMessage(), res.errorInfo());
+				return false;
+			}
+
+			return true;
+		}
+	};
+
+	class EnumValueModel : public QSqlQueryModel {
+
+		Controller& mController;
+		QVariant mEnumId;
+	public:
+
+		static const int NAME_COL = 0;
+		static const int VALUE_COL = 1;
+		static const int ID_COL = 2;
+
+		EnumValueModel(Controller& controller, QObject* parent)
+		: QSqlQueryModel(parent)
+		, mController(controller)
+		{}
+
+		const QVariant& enumId() const {
+			return mEnumId;
+		}
+
+		void setEnumId(const QVariant& enum_id) {
+			mEnumId = enum_id;
+			refresh();
+		}
+
+		void refresh() {
+			if (mEnumId.isNull()) {
+				clear();
+				return;
+			}
+
+			setQuery(QString("SELECT name AS \"Name\", value AS \"Value\", id FROM enum_value WHERE enum_id = %1 ORDER BY value").arg(ToSqlLiteral(mEnumId)));
+		}
+
+		bool containsName(const QString& name) const {
+
+			for (int row = 0; row < rowCount(); ++row) {
+				if (data(index(row, NAME_COL)).toString() == name)
+					return true;
+			}
+
+			return false;
+		}
+
+		// one past the largest value, so new values don't collide
+		qlonglong nextValue() const {
+
+			qlonglong next = 0;
+			for (int row = 0; row < rowCount(); ++row) {
+				next = std::max(next, data(index(row, VALUE_COL)).toLongLong() + 1);
+			}
+
+			return next;
+		}
+
+		Qt::ItemFlags flags(const QModelIndex& index) const override {
+			return QSqlQueryModel::flags(index) | Qt::ItemIsEditable;
+		};
+
+		bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) {
+			if (role != Qt::EditRole) {
+				return QSqlQueryModel::setData(index, value, role);
+			}
+
+			auto perform = [&](const QString& column_name, const QVariant& new_value) -> Result<> {
+
+				const QVariant current_value = data(index);
+
+				if (current_value.toString() == new_value.toString())
+					return Ok(); // ignore value change
+
+				auto t = mController.createTransaction("Edit Enum Value");
+
+				{
+					auto res = t.update(
+						"enum_value",
+						{{column_name, new_value}},
+						{{column_name, current_value}},
+						"id",
+						data(this->index(index.row(), ID_COL))
+					);
+
+					if (res.failed())
+						return res.error();
+				}
+
+				return t.commit();
+			};
+
+			switch (index.column()) {
+
+				case NAME_COL: {
+					const QString new_name = value.toString().trimmed();
+
+					Result<> res = Ok();
+					if (new_name.isEmpty() || new_name.contains(' ')) {
+						res = Error("'"_sb + new_name + "' is not a valid name, it can't be empty or contain spaces");
+					} else if (new_name != data(index).toString() && containsName(new_name)) {
+						res = Error("Value '"_sb + new_name + "' already exists");
+					} else {
+						res = perform("name", new_name);
+					}
+
+					if (res.failed()) {
+						MessageBoxCritical(EnumMetaEditor::tr("Unable to rename value"), res.errorMessage(), res.errorInfo());
+						return false;
+					}
+				}
+				break;
+
+				case VALUE_COL: {
+					bool ok = false;
+					const qlonglong new_value = value.toString().toLongLong(&ok);
+
+					auto res = ok ? perform("value", new_value) : Result<>(Error("'"_sb + value.toString() + "' is not an integer"));
+
+					if (res.failed()) {
+						MessageBoxCritical(EnumMetaEditor::tr("Unable to change value"), res.errorMessage(), res.errorInfo());
+						return false;
+					}
+				}
+				break;
+
+				default:
+					return false;
+			}
+
+			refresh();
+
+			return true;
+		}
+	};
+
+	EnumMetaEditor::EnumMetaEditor(Controller& controller, QWidget* parent)
+	: QWidget(parent) {
+
+		auto layout = new QVBoxLayout(this);
+		auto input_layout = new QHBoxLayout();
+
+		layout->addLayout(input_layout);
+
+		auto filter = new QLineEdit(this);
+		filter->setPlaceholderText(tr("Search filter..."));
+		input_layout->addWidget(filter);
+
+		auto list_view = new QListView(this);
+		list_view->setEditTriggers(QAbstractItemView::EditKeyPressed | QAbstractItemView::DoubleClicked);
+		layout->addWidget(list_view);
+
+		auto model = new EnumModel(controller, this);
+		auto proxy_model = new QSortFilterProxyModel(this);
+		proxy_model->setSourceModel(model);
+		proxy_model->setDynamicSortFilter(true);
+		proxy_model->sort(EnumModel::NAME_COL);
+		proxy_model->setFilterKeyColumn(EnumModel::NAME_COL);
+		proxy_model->setFilterCaseSensitivity(Qt::CaseInsensitive);
+		list_view->setModel(proxy_model);
+		model->refresh();
+
+		connect(filter, &QLineEdit::textChanged, this, [proxy_model](const QString& value){
+			proxy_model->setFilterFixedString(value);
+		});
+
+		auto new_button = new QPushButton(tr("New"), this);
+		connect(new_button, &QPushButton::clicked, this, [model, &controller](){
+
+			auto perform = [model, &controller]() -> Result<> {
+
+				auto t = controller.createTransaction("New Enum");
+				auto lock_res = t.lockTable("enum");
+				if (lock_res.failed())
+					return lock_res.error();
+
+				QString enum_name;
+
+				for (int index = 0; ; ++index) {
+					enum_name = QString("NewEnum%1").arg(index);
+					if (!model->containsName(enum_name))
+						break;
+				}
+
+				auto res = t.insert("enum", {{"name", enum_name}}, "id");
+				if (res.failed())
+					return res.error();
+
+				return t.commit();
+			};
+
+			auto res = perform();
+			if (res.failed()) {
+				MessageBoxCritical(EnumMetaEditor::tr("Error creating enum"), res.errorMessage(), res.errorInfo());
+			}
+		});
+
+		input_layout->addWidget(new_button);
+
+		auto value_model = new EnumValueModel(controller, this);
+		auto value_view = new QTreeView(this);
+		value_view->setModel(value_model);
+		value_view->setRootIsDecorated(false);
+		layout->addWidget(value_view);
+
+		auto new_value_button = new QPushButton(tr("New Value"), this);
+		new_value_button->setEnabled(false);
+		layout->addWidget(new_value_button);
+
+		auto show_values = [list_view, proxy_model, value_model, value_view, new_value_button]() {
+
+			const QModelIndex current = list_view->currentIndex();
+			const QVariant enum_id = current.isValid() ? proxy_model->data(proxy_model->index(current.row(), EnumModel::ID_COL)) : QVariant();
+
+			value_model->setEnumId(enum_id);
+			value_view->hideColumn(EnumValueModel::ID_COL);
+			new_value_button->setEnabled(!enum_id.isNull());
+		};
+
+		connect(list_view->selectionModel(), &QItemSelectionModel::currentChanged, this, show_values);
+
+		// the selection is lost when the enums are queried again, select the enum that was being edited
+		connect(model, &QAbstractItemModel::modelReset, this, [list_view, proxy_model, value_model, show_values]() {
+
+			for (int row = 0; row < proxy_model->rowCount(); ++row) {
+				if (proxy_model->data(proxy_model->index(row, EnumModel::ID_COL)) == value_model->enumId()) {
+					list_view->setCurrentIndex(proxy_model->index(row, EnumModel::NAME_COL));
+					return;
+				}
+			}
+
+			show_values();
+		});
+
+		connect(&controller, &Controller::dataChanged, this, [model, value_model](const QSet<QString>& tables){
+			if (tables.contains("enum")) {
+				model->refresh();
+			}
+
+			if (tables.contains("enum_value")) {
+				value_model->refresh();
+			}
+		});
+
+		connect(new_value_button, &QPushButton::clicked, this, [value_model, &controller](){
+
+			auto perform = [value_model, &controller]() -> Result<> {
+
+				auto t = controller.createTransaction("New Enum Value");
+
+				QString value_name;
+
+				for (int index = 0; ; ++index) {
+					value_name = QString("Value%1").arg(index);
+					if (!value_model->containsName(value_name))
+						break;
+				}
+
+				auto res = t.insert(
+					"enum_value",
+					{
+						{"enum_id", value_model->enumId()},
+						{"name", value_name},
+						{"value", value_model->nextValue()}
+					},
+					"id"
+				);
+
+				if (res.failed())
+					return res.error();
+
+				return t.commit();
+			};
+
+			auto res = perform();
+			if (res.failed()) {
+				MessageBoxCritical(EnumMetaEditor::tr("Error creating enum value"), res.errorMessage(), res.errorInfo());
+			}
+		});
+
+		auto rename_row = new QAction(tr("Rename"), list_view);
+		list_view->addAction(rename_row);
+		rename_row->setShortcut(Qt::Key_F2);
+		rename_row->setShortcutContext(Qt::WidgetShortcut);
+		connect(rename_row, &QAction::triggered, this, [list_view](bool){
+			list_view->edit(list_view->currentIndex());
+		});
+
+		auto delete_row = new QAction(tr("Delete"), list_view);
+		list_view->addAction(delete_row);
+		delete_row->setShortcut(Qt::Key_Delete);
+		delete_row->setShortcutContext(Qt::WidgetShortcut);
+		connect(delete_row, &QAction::triggered, this, [list_view, proxy_model, value_model, &controller](bool) {
+
+			auto perform = [&]() -> Result<> {
+
+				const QModelIndex current = list_view->currentIndex();
+				if (!current.isValid())
+					return Ok();
+
+				auto t = controller.createTransaction("Delete Enum");
+
+				// the values go first, they refer to the enum, one row at a time so undo restores each of them
+				for (int row = 0; row < value_model->rowCount(); ++row) {
+					auto res = t.deleteRow("enum_value", "id", value_model->data(value_model->index(row, EnumValueModel::ID_COL)));
+					if (res.failed())
+						return res.error();
+				}
+
+				auto res = t.deleteRow("enum", "id", proxy_model->data(proxy_model->index(current.row(), EnumModel::ID_COL)));
+				if (res.failed())
+					return res.error();
+
+				return t.commit();
+			};
+
+			auto res = perform();
+			if (res.failed()) {
+				MessageBoxCritical(tr("Error deleting enum"), res.errorMessage(), res.errorInfo());
+			}
+		});
+
+		list_view->setContextMenuPolicy(Qt::ActionsContextMenu);
+
+		auto delete_value = new QAction(tr("Delete"), value_view);
+		value_view->addAction(delete_value);
+		delete_value->setShortcut(Qt::Key_Delete);
+		delete_value->setShortcutContext(Qt::WidgetShortcut);
+		connect(delete_value, &QAction::triggered, this, [value_view, value_model, &controller](bool){
+
+			auto perform = [&]() -> Result<> {
+				auto t = controller.createTransaction("Delete Enum Value");
+
+				for (auto index : value_view->selectionModel()->selectedRows()) {
+					auto res = t.deleteRow("enum_value", "id", value_model->data(value_model->index(index.row(), EnumValueModel::ID_COL)));
+					if (res.failed())
+						return res.error();
+				}
+
+				return t.commit();
+			};
+
+			auto res = perform();
+			if (res.failed()) {
+				MessageBoxCritical(tr("Error deleting enum value"), res.errorMessage(), res.errorInfo());
+			}
+		});
+
+		value_view->setContextMenuPolicy(Qt::ActionsContextMenu);
+
+		setLayout(layout);
+	}
+
+	EnumMetaEditor::~EnumMetaEditor() {
+	}
+}
@@ -3,14 +3,16 @@
 #include <QWidget>
 
 namespace sg {
+
+	/*
+	Lists every enum, and edits the values of the selected one. A component property of type enum names its enum in the
+	default value, "Enum" or "Enum::Default".
+	*/
 	class EnumMetaEditor : public QWidget {
 		Q_OBJECT
 
 	public:
 		EnumMetaEditor(class Controller& controller, QWidget* parent);
 		~EnumMetaEditor();
-
-	signals:
-		void opened(const QString& component);
 	};
-}
\ No newline at end of file
+}
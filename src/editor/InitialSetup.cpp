@@ -14,7 +14,7 @@ namespace sg {
 		QStringList columns;
 	};
 
-	static const char* DEFAULT_TYPES[] = {"i8","u8","i16","u16","i32","u32","f32","f64","text","component", "point2d", "point3d", "scale2d", "scale3d", "rotation2d", "rotation3d"};
+	static const char* DEFAULT_TYPES[] = {"i8","u8","i16","u16","i32","u32","f32","f64","text","component", "point2d", "point3d", "scale2d", "scale3d", "rotation2d", "rotation3d", "enum"};
 
 	const RequiredTable REQURIED_TABLES[] = {
 		{
@@ -35,6 +35,21 @@ namespace sg {
 				"type VARCHAR(32) NOT NULL REFERENCES prop_type(name)",
 				"UNIQUE(name, type)"
 			}
+		}, {
+			"enum",
+			{
+				"id SERIAL PRIMARY KEY",
+				"name VARCHAR(64) NOT NULL UNIQUE CONSTRAINT name_cannot_contain_whitespace CHECK (strpos(name, ' ') = 0)"
+			}
+		}, {
+			"enum_value",
+			{
+				"id SERIAL PRIMARY KEY",
+				"enum_id INTEGER REFERENCES enum(id)",
+				"name VARCHAR(64) NOT NULL CONSTRAINT name_cannot_contain_whitespace CHECK (strpos(name, ' ') = 0)",
+				"value BIGINT NOT NULL",
+				"UNIQUE(enum_id, name)"
+			}
 		}, {
 			"component",
 			{
@@ -49,6 +64,10 @@ namespace sg {
 				"name VARCHAR(128) NOT NULL CONSTRAINT name_cannot_contain_whitespace CHECK (strpos(name, ' ') = 0)",
 				"type VARCHAR(32) NOT NULL REFERENCES prop_type(name)",
 				"default_value TEXT",
+				"encoding VARCHAR(64)",
+				"cold BOOLEAN NOT NULL DEFAULT FALSE",
+				"sort_key BOOLEAN NOT NULL DEFAULT FALSE",
+				"inline_target BOOLEAN NOT NULL DEFAULT FALSE",
 				"UNIQUE(component_id, name)",
 			}
 		}, {
@@ -17,6 +17,7 @@
 #include "ComponentEditor.h"
 #include "EntityList.h"
 #include "EntityEditor.h"
+#include "EnumMetaEditor.h"
 #include "Controller.h"
 #include "MessageBox.h"
 
@@ -64,6 +65,7 @@ namespace sg {
 	: mController(controller)
 	, mComponentList(new ComponentList(controller, this))
 	, mEntityList(new EntityList(controller, this))
+	, mEnumMetaEditor(new EnumMetaEditor(controller, this))
 	, mMdiArea(new QMdiArea(this))
 	{
 		setWindowTitle(tr("SG Edit"));
@@ -110,6 +112,12 @@ namespace sg {
 			mEntityList
 		);
 
+		new_dock_widget(
+			"Enum",
+			Qt::LeftDockWidgetArea,
+			mEnumMetaEditor
+		);
+
 		auto undo_act = new QAction(tr("&Undo"), this);
 		undo_act->setShortcut(QKeySequence::Undo);
 		edit_menu->addAction(undo_act);
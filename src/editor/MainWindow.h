@@ -39,6 +39,7 @@ namespace sg {
 
 		class ComponentList *mComponentList;
 		class EntityList *mEntityList;
+		class EnumMetaEditor *mEnumMetaEditor;
 
 		class Controller& mController;
 
@@ -0,0 +1,3103 @@
+#include "SceneCompiler.h"
+#include "CodeGenerator.h"
+#include "Controller.h"
+#include "FormatString.h"
+#include "Hash.h"
+#include "Quantize.h"
+#include "SceneNames.h"
+#include "ScenePacker.h"
+#include "SceneSpatial.h"
+#include "SceneWriter.h"
+#include "VectorMath.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream> // for std::cout
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <QSqlQuery>
+#include <QSqlError>
+
+namespace sg {
+
+	template<typename T>
+	static inline void Store(uint8_t* dest, T value) {
+		std::memcpy(dest, &value, sizeof(T));
+	}
+
+	template<typename T>
+	static inline T Load(const uint8_t* src) {
+		T value;
+		std::memcpy(&value, src, sizeof(T));
+		return value;
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	static double SecondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// everything the scene compiler reads from the database, queried in bulk and indexed in memory
+	struct SceneSource {
+
+		struct Override {
+			id_t componentPropId;
+			std::string value;
+		};
+
+		struct PropLink {
+			id_t entityPropId;
+			id_t componentPropId;
+			std::string operation;
+		};
+
+		struct EntityComponent {
+			id_t id;
+			std::string name;
+			size_t structure; // index into structures, which is also the TypeId
+			std::vector<Override> overrides;
+			std::vector<PropLink> links;
+		};
+
+		struct EntityChild {
+			id_t id;
+			std::string name;
+			id_t childId;
+			std::vector<Override> overrides;
+		};
+
+		struct Entity {
+			std::string name;
+			std::vector<EntityComponent> components;
+			std::vector<EntityChild> children;
+		};
+
+		struct PropLocation {
+			size_t structure;
+			size_t member;
+		};
+
+		std::vector<CppStructure> structures;
+
+		std::unordered_map<id_t, size_t> structureIds; // component.id to structure index
+		std::unordered_map<std::string, size_t> structureNames;
+		std::unordered_map<id_t, PropLocation> props; // component_prop.id to structure member
+
+		std::unordered_map<id_t, Entity> entities;
+		std::unordered_map<id_t, std::string> entityPropValues;
+
+		void indexStructures() {
+			for (size_t s = 0; s < structures.size(); ++s) {
+
+				// the cold part of a component shares its properties, they are found through the component
+				if (structures[s].hotStructure != CppStructure::NO_STRUCTURE)
+					continue;
+
+				structureIds[structures[s].id] = s;
+				structureNames[structures[s].name] = s;
+
+				for (size_t m = 0; m < structures[s].members.size(); ++m) {
+					// members added by the code generator, such as inline copies, can't be overridden
+					if (structures[s].members[m].id != -1)
+						props[structures[s].members[m].id] = {s, m};
+				}
+			}
+		}
+	};
+
+	static Result<> ExecQuery(QSqlQuery& q, const char* statement) {
+
+		q.setForwardOnly(true);
+		if (!q.exec(statement))
+			return Error(q.lastError().text(), statement);
+
+		return Ok();
+	}
+
+	static Result<> QuerySceneSource(const Transaction& t, SceneSource& source) {
+
+		{
+			auto structures = QueryComponentStructures(t);
+			if (structures.failed())
+				return structures.error();
+
+			source.structures = std::move(*structures);
+			source.indexStructures();
+		}
+
+		QSqlQuery q(*t.connection());
+
+		{
+			auto res = ExecQuery(q, "SELECT id, name FROM entity");
+			if (res.failed())
+				return res.error();
+
+			while (q.next()) {
+				source.entities[q.value(0).toLongLong()].name = q.value(1).toString().toStdString();
+			}
+		}
+
+		{
+			auto res = ExecQuery(q, "SELECT id, name, entity_id, component_id FROM entity_component ORDER BY id");
+			if (res.failed())
+				return res.error();
+
+			while (q.next()) {
+				auto entity = source.entities.find(q.value(2).toLongLong());
+				if (entity == source.entities.end())
+					continue;
+
+				SceneSource::EntityComponent ec;
+				ec.id = q.value(0).toLongLong();
+				ec.name = q.value(1).toString().toStdString();
+
+				auto structure = source.structureIds.find(q.value(3).toLongLong());
+				if (structure == source.structureIds.end())
+					return Error("'"_sb + entity->second.name + "' component '" + ec.name + "' does not have a valid component type");
+
+				ec.structure = structure->second;
+				entity->second.components.push_back(std::move(ec));
+			}
+		}
+
+		{
+			auto res = ExecQuery(q, "SELECT id, name, entity_id, child_id FROM entity_child ORDER BY id");
+			if (res.failed())
+				return res.error();
+
+			while (q.next()) {
+				auto entity = source.entities.find(q.value(2).toLongLong());
+				if (entity == source.entities.end() || q.value(3).isNull())
+					continue;
+
+				SceneSource::EntityChild ec;
+				ec.id = q.value(0).toLongLong();
+				ec.name = q.value(1).toString().toStdString();
+				ec.childId = q.value(3).toLongLong();
+				entity->second.children.push_back(std::move(ec));
+			}
+		}
+
+		// every entity row has been read, so these pointers stay valid
+		std::unordered_map<id_t, SceneSource::EntityComponent*> entity_components;
+		std::unordered_map<id_t, SceneSource::EntityChild*> entity_children;
+
+		for (auto& kv : source.entities) {
+			for (auto& ec : kv.second.components) {
+				entity_components[ec.id] = &ec;
+			}
+
+			for (auto& ec : kv.second.children) {
+				entity_children[ec.id] = &ec;
+			}
+		}
+
+		{
+			auto res = ExecQuery(q, "SELECT entity_component_id, component_prop_id, value FROM entity_component_override ORDER BY id");
+			if (res.failed())
+				return res.error();
+
+			while (q.next()) {
+				auto ec = entity_components.find(q.value(0).toLongLong());
+				if (ec == entity_components.end() || q.value(2).isNull())
+					continue;
+
+				ec->second->overrides.push_back({q.value(1).toLongLong(), q.value(2).toString().toStdString()});
+			}
+		}
+
+		{
+			auto res = ExecQuery(q, "SELECT entity_child_id, component_prop_id, value FROM entity_child_override ORDER BY id");
+			if (res.failed())
+				return res.error();
+
+			while (q.next()) {
+				auto ec = entity_children.find(q.value(0).toLongLong());
+				if (ec == entity_children.end() || q.value(2).isNull())
+					continue;
+
+				ec->second->overrides.push_back({q.value(1).toLongLong(), q.value(2).toString().toStdString()});
+			}
+		}
+
+		{
+			auto res = ExecQuery(q, "SELECT id, default_value FROM entity_prop");
+			if (res.failed())
+				return res.error();
+
+			while (q.next()) {
+				source.entityPropValues[q.value(0).toLongLong()] = q.value(1).toString().toStdString();
+			}
+		}
+
+		{
+			auto res = ExecQuery(q, "SELECT entity_prop_id, entity_component_id, component_prop_id, operation FROM entity_prop_link ORDER BY id");
+			if (res.failed())
+				return res.error();
+
+			while (q.next()) {
+				auto ec = entity_components.find(q.value(1).toLongLong());
+				if (ec == entity_components.end())
+					continue;
+
+				ec->second->links.push_back({q.value(0).toLongLong(), q.value(2).toLongLong(), q.value(3).toString().toStdString()});
+			}
+		}
+
+		return Ok();
+	}
+
+	// a component produced by the flattener, everything it points to is only valid during the callback
+	struct FlatComponent {
+		uint32_t structure;
+		const std::string* instancePath; // "" for the scene itself, "Child/Grandchild/" for instanced entities
+		const std::string* name;
+		const std::string* const* values; // one per structure member
+	};
+
+	static const std::string EMPTY_VALUE;
+
+	// component, component_ref and enum properties keep their type name in default_value, they default to nothing, which
+	// for an enum is the value named in default_value or its first value
+	static const std::string* DefaultValue(const CppMember& m) {
+
+		if (m.typeName == "component" || m.typeName == "component_ref" || m.typeName == "enum")
+			return &EMPTY_VALUE;
+
+		return &m.defaultValue;
+	}
+
+	static bool IsSignedInteger(const std::string& type_name) {
+		return type_name == "i8" || type_name == "i16" || type_name == "i32" || type_name == "i64";
+	}
+
+	static bool IsUnsignedInteger(const std::string& type_name) {
+		return type_name == "u8" || type_name == "u16" || type_name == "u32" || type_name == "u64";
+	}
+
+	static bool IsFloat(const std::string& type_name) {
+		return type_name == "f32" || type_name == "f64";
+	}
+
+	// the number of values a point, scale or rotation is written with, 0 for every other type
+	static size_t MathLanes(const std::string& type_name) {
+
+		if (type_name == "rotation2d") return 1;
+		if (type_name == "point2d" || type_name == "scale2d") return 2;
+		if (type_name == "point3d" || type_name == "scale3d") return 3;
+		if (type_name == "rotation3d") return 4;
+		return 0;
+	}
+
+	// a value left out of a compound value leaves a scale or a rotation unchanged
+	static float MathDefault(const std::string& type_name, size_t lane) {
+		if (type_name == "scale2d" || type_name == "scale3d")
+			return 1.0f;
+
+		return type_name == "rotation3d" && lane == 3 ? 1.0f : 0.0f;
+	}
+
+	// "(1, 2, (3, 4))" becomes "1", "2", "(3, 4)"
+	static std::vector<std::string> SplitCompoundValue(const std::string& value) {
+
+		auto trim = [](const std::string& s) {
+			const size_t first = s.find_first_not_of(" \t\n");
+			if (first == std::string::npos)
+				return std::string();
+
+			return s.substr(first, s.find_last_not_of(" \t\n") - first + 1);
+		};
+
+		std::string v = trim(value);
+		if (v.size() >= 2 && v.front() == '(' && v.back() == ')')
+			v = v.substr(1, v.size() - 2);
+
+		std::vector<std::string> result;
+		if (trim(v).empty())
+			return result;
+
+		int depth = 0;
+		size_t start = 0;
+		for (size_t n = 0; n < v.size(); ++n) {
+			if (v[n] == '(') {
+				++depth;
+			} else if (v[n] == ')') {
+				--depth;
+			} else if (v[n] == ',' && depth == 0) {
+				result.push_back(trim(v.substr(start, n - start)));
+				start = n + 1;
+			}
+		}
+
+		result.push_back(trim(v.substr(start)));
+		return result;
+	}
+
+
+	/*
+	Applies an entity property to a component property.
+		copy: always uses the entity property value
+		preset: uses the entity property value unless the component has overridden the default
+		add/subtract: combines the entity property with the component value, numeric properties only
+	*/
+	static Result<> ApplyPropLink(const CppMember& m, const std::string& operation, const std::string& prop_value, const std::string*& value, std::deque<std::string>& computed_values) {
+
+		if (operation == "copy") {
+			value = &prop_value;
+			return Ok();
+		}
+
+		if (operation == "preset") {
+			if (value == DefaultValue(m))
+				value = &prop_value;
+
+			return Ok();
+		}
+
+		const bool add = operation == "add";
+		if (!add && operation != "subtract")
+			return Error("Unknown property link operation '"_sb + operation + "'");
+
+		if (IsSignedInteger(m.typeName) || IsUnsignedInteger(m.typeName)) {
+			const long long a = std::strtoll(value->c_str(), nullptr, 10);
+			const long long b = std::strtoll(prop_value.c_str(), nullptr, 10);
+			computed_values.push_back(std::to_string(add ? a + b : a - b));
+		} else if (IsFloat(m.typeName)) {
+			const double a = std::strtod(value->c_str(), nullptr);
+			const double b = std::strtod(prop_value.c_str(), nullptr);
+
+			char buf[32];
+			std::snprintf(buf, sizeof(buf), "%.17g", add ? a + b : a - b);
+			computed_values.push_back(buf);
+		} else if (MathLanes(m.typeName) != 0 && m.typeName != "rotation3d") {
+
+			// points and scales combine value by value, 2d rotations by adding the angles
+			const std::vector<std::string> a = SplitCompoundValue(*value);
+			const std::vector<std::string> b = SplitCompoundValue(prop_value);
+
+			std::string result = "(";
+			for (size_t n = 0; n < MathLanes(m.typeName); ++n) {
+				const double va = n < a.size() && !a[n].empty() ? std::strtod(a[n].c_str(), nullptr) : MathDefault(m.typeName, n);
+				const double vb = n < b.size() && !b[n].empty() ? std::strtod(b[n].c_str(), nullptr) : 0.0;
+
+				char buf[32];
+				std::snprintf(buf, sizeof(buf), "%s%.9g", n == 0 ? "" : ", ", add ? va + vb : va - vb);
+				result += buf;
+			}
+
+			computed_values.push_back(result + ")");
+		} else {
+			return Error("'"_sb + operation + "' can not be used on '" + m.name + "', it is not a numeric property");
+		}
+
+		value = &computed_values.back();
+		return Ok();
+	}
+
+	/*
+	Walks the entity graph below a scene, instancing every child entity, and hands each component to a callback with
+	its overrides applied. Nothing is kept between components, so the scene is never held in memory as a whole.
+	*/
+	class SceneFlattener {
+
+		using Callback = std::function<Result<>(const FlatComponent&)>;
+
+		const SceneSource& mSource;
+		const Callback& mCallback;
+
+		// overrides of the entity_child rows leading to the current instance, outermost first
+		std::vector<const std::vector<SceneSource::Override>*> mChildOverrides;
+		std::vector<id_t> mEntityStack;
+
+		// scratch space for the component being flattened
+		std::vector<const std::string*> mValues;
+		std::deque<std::string> mComputedValues;
+
+	public:
+		SceneFlattener(const SceneSource& source, const Callback& callback)
+		: mSource(source)
+		, mCallback(callback)
+		{}
+
+		Result<> flatten(id_t entity_id, const std::string& path) {
+
+			auto entity_itr = mSource.entities.find(entity_id);
+			if (entity_itr == mSource.entities.end())
+				return Error("Unknown entity id "_sb + std::to_string(entity_id) + " at '" + path + "'");
+
+			const SceneSource::Entity& entity = entity_itr->second;
+
+			if (std::find(mEntityStack.begin(), mEntityStack.end(), entity_id) != mEntityStack.end())
+				return Error("Entity '"_sb + entity.name + "' contains itself at '" + path + "'");
+
+			mEntityStack.push_back(entity_id);
+
+			for (const SceneSource::EntityComponent& ec : entity.components) {
+
+				const CppStructure& s = mSource.structures[ec.structure];
+
+				mValues.clear();
+				mComputedValues.clear();
+
+				for (const CppMember& m : s.members) {
+					mValues.push_back(DefaultValue(m));
+				}
+
+				for (const SceneSource::Override& o : ec.overrides) {
+					auto prop = mSource.props.find(o.componentPropId);
+					if (prop == mSource.props.end() || prop->second.structure != ec.structure)
+						return Error("'"_sb + path + ec.name + "' overrides a property that " + s.name + " does not have");
+
+					mValues[prop->second.member] = &o.value;
+				}
+
+				for (const SceneSource::PropLink& link : ec.links) {
+					auto prop = mSource.props.find(link.componentPropId);
+					if (prop == mSource.props.end() || prop->second.structure != ec.structure)
+						return Error("'"_sb + path + ec.name + "' links a property that " + s.name + " does not have");
+
+					auto prop_value = mSource.entityPropValues.find(link.entityPropId);
+					if (prop_value == mSource.entityPropValues.end())
+						return Error("'"_sb + path + ec.name + "' links to an entity property that does not exist");
+
+					auto res = ApplyPropLink(s.members[prop->second.member], link.operation, prop_value->second, mValues[prop->second.member], mComputedValues);
+					if (res.failed())
+						return res.error();
+				}
+
+				// the outermost entity has the final say, so apply from the innermost out
+				for (auto itr = mChildOverrides.rbegin(); itr != mChildOverrides.rend(); ++itr) {
+					for (const SceneSource::Override& o : **itr) {
+						auto prop = mSource.props.find(o.componentPropId);
+						if (prop != mSource.props.end() && prop->second.structure == ec.structure)
+							mValues[prop->second.member] = &o.value;
+					}
+				}
+
+				auto res = mCallback({uint32_t(ec.structure), &path, &ec.name, mValues.data()});
+				if (res.failed())
+					return res.error();
+			}
+
+			for (const SceneSource::EntityChild& child : entity.children) {
+
+				mChildOverrides.push_back(&child.overrides);
+				auto res = flatten(child.childId, path + child.name + "/");
+				mChildOverrides.pop_back();
+
+				if (res.failed())
+					return res.error();
+			}
+
+			mEntityStack.pop_back();
+
+			return Ok();
+		}
+	};
+
+	// where a component ends up in the scene
+	struct ComponentLocation {
+		uint32_t structure;
+		uint32_t range;
+		uint32_t index;
+		uint32_t flattenIndex; // the index before the range was reordered, see RangeOrder
+	};
+
+	// a component with every property at its default value, see EncodeDefaults
+	struct DefaultComponent {
+		std::vector<uint8_t> bytes; // empty when a default can't be encoded, every member is then encoded
+		std::vector<bool> copied; // the members whose default is in bytes, text is written to each scene instead
+	};
+
+	struct EncodeContext {
+		const SceneSource& source;
+
+		// nullptr while only sort keys are read, text and references are then left 0
+		SceneWriter* writer;
+
+		// range each structure is written to
+		const std::vector<size_t>& structureRanges;
+
+		// full path of every component, only filled in when the scene has component_ref properties
+		const std::unordered_map<std::string, ComponentLocation>& paths;
+
+		// one per structure, nullptr while the defaults themselves are being encoded
+		const std::vector<DefaultComponent>* defaults;
+
+		// the components kept in memory, by structure in flatten order, that inline copies are taken from. nullptr until
+		// every one of them is encoded, copies are then left at their defaults.
+		const std::vector<std::vector<uint8_t>>* held;
+
+		// the entity instance of the component being encoded, component_ref paths are relative to it
+		const std::string* instancePath;
+
+		// where the component being encoded is in memory and in the file, references are relative to themselves
+		const uint8_t* component;
+		uint64_t componentOffset;
+
+		int64_t relativeTo(uint64_t target, const uint8_t* dest) const {
+			return int64_t(target - (componentOffset + uint64_t(dest - component)));
+		}
+	};
+
+	static Result<> EncodeStructure(EncodeContext& ctx, size_t structure, const std::string* const* values, uint8_t* dest);
+
+	static const float DEGREES_TO_RADIANS = 3.14159265358979f / 180.0f;
+
+	/*
+	Points and scales are written as "(1, 2)" or "(1, 2, 3)", rotations in degrees. A rotation3d is either three angles,
+	applied about x, then y, then z, or a quaternion as "(x, y, z, w)".
+	*/
+	static Result<> EncodeMath(const CppMember& m, const std::string& value, uint8_t* dest) {
+
+		const std::vector<std::string> parts = SplitCompoundValue(value);
+		const bool euler = m.typeName == "rotation3d" && parts.size() == 3;
+
+		if (parts.size() > MathLanes(m.typeName))
+			return Error("'"_sb + value + "' has too many values for '" + m.name + "', " + m.typeName + " has " + std::to_string(MathLanes(m.typeName)));
+
+		float v[4] = {};
+		for (size_t n = 0; n < MathLanes(m.typeName); ++n) {
+
+			v[n] = MathDefault(m.typeName, n);
+			if (n >= parts.size() || parts[n].empty())
+				continue;
+
+			char* end = nullptr;
+			v[n] = std::strtof(parts[n].c_str(), &end);
+
+			if (*end != 0)
+				return Error("Unable to read '"_sb + value + "' as " + m.typeName + " for '" + m.name + "'");
+		}
+
+		if (m.typeName == "rotation2d") {
+			Store(dest, Rotation2{v[0] * DEGREES_TO_RADIANS});
+		} else if (m.typeName == "point2d" || m.typeName == "scale2d") {
+			Store(dest, Vec2{v[0], v[1]});
+		} else if (m.typeName == "point3d" || m.typeName == "scale3d") {
+			Store(dest, Vec3{v[0], v[1], v[2], 0.0f});
+		} else if (euler) {
+			Store(dest, QuatFromEuler(v[0] * DEGREES_TO_RADIANS, v[1] * DEGREES_TO_RADIANS, v[2] * DEGREES_TO_RADIANS));
+		} else {
+			Store(dest, Quat{v[0], v[1], v[2], v[3]});
+		}
+
+		return Ok();
+	}
+
+	// values are written as "Value" or "Enum::Value"
+	static Result<int64_t> EnumValue(const CppMember& m, const std::string& value) {
+
+		const CppEnum& e = m.enumeration;
+		std::string name = value;
+
+		if (name.empty()) {
+			const size_t separator = m.defaultValue.find("::");
+			if (separator != std::string::npos)
+				name = m.defaultValue.substr(separator + 2);
+		}
+
+		if (name.compare(0, e.name.size(), e.name) == 0 && name.compare(e.name.size(), 2, "::") == 0)
+			name = name.substr(e.name.size() + 2);
+
+		if (name.empty())
+			return Ok(e.enumerators.empty() ? int64_t(0) : e.enumerators.front().value);
+
+		for (const CppEnumerator& v : e.enumerators) {
+			if (v.name == name)
+				return Ok(v.value);
+		}
+
+		return Error(m.name + " can't be '" + name + "', it is not a value of " + e.name);
+	}
+
+	static Result<> EncodeMember(EncodeContext& ctx, const CppMember& m, const std::string& value, uint8_t* dest) {
+
+		const char* str = value.c_str();
+		char* end = nullptr;
+
+		if (IsSignedInteger(m.typeName)) {
+			const long long v = std::strtoll(str, &end, 10);
+
+			switch (m.size) {
+				case 1: Store(dest, int8_t(v)); break;
+				case 2: Store(dest, int16_t(v)); break;
+				case 4: Store(dest, int32_t(v)); break;
+				default: Store(dest, int64_t(v)); break;
+			}
+		} else if (IsUnsignedInteger(m.typeName)) {
+			const unsigned long long v = std::strtoull(str, &end, 10);
+
+			switch (m.size) {
+				case 1: Store(dest, uint8_t(v)); break;
+				case 2: Store(dest, uint16_t(v)); break;
+				case 4: Store(dest, uint32_t(v)); break;
+				default: Store(dest, uint64_t(v)); break;
+			}
+		} else if (IsFloat(m.typeName)) {
+			const double v = std::strtod(str, &end);
+			const CppEncoding& e = m.quantization;
+
+			if (e.kind == CppEncoding::Kind::Half) {
+				Store(dest, EncodeHalf(float(v)));
+			} else if (e.kind == CppEncoding::Kind::Unorm) {
+				if (e.size == 1) Store(dest, EncodeUnorm<uint8_t>(v)); else Store(dest, EncodeUnorm<uint16_t>(v));
+			} else if (e.kind == CppEncoding::Kind::Snorm) {
+				if (e.size == 1) Store(dest, EncodeSnorm<int8_t>(v)); else Store(dest, EncodeSnorm<int16_t>(v));
+			} else if (e.kind == CppEncoding::Kind::Fixed) {
+				if (e.size == 1) Store(dest, EncodeFixed<uint8_t>(v, e.min, e.max)); else Store(dest, EncodeFixed<uint16_t>(v, e.min, e.max));
+			} else if (m.size == 4) {
+				Store(dest, float(v));
+			} else {
+				Store(dest, v);
+			}
+		} else if (MathLanes(m.typeName) != 0) {
+
+			return EncodeMath(m, value, dest);
+
+		} else if (m.typeName == "enum") {
+
+			auto v = EnumValue(m, value);
+			if (v.failed())
+				return v.error();
+
+			// two's complement, so signed values truncate to the same bits
+			switch (m.size) {
+				case 1: Store(dest, uint8_t(*v)); break;
+				case 2: Store(dest, uint16_t(*v)); break;
+				case 4: Store(dest, uint32_t(*v)); break;
+				default: Store(dest, uint64_t(*v)); break;
+			}
+
+		} else if (m.typeName == "text") {
+
+			if (ctx.writer)
+				Store(dest, ctx.relativeTo(ctx.writer->writeText(value.c_str(), value.size()), dest));
+
+		} else if (m.typeName == "component_ref") {
+
+			if (value.empty() || !ctx.writer) {
+				Store(dest, uint64_t(0));
+				return Ok();
+			}
+
+			const std::string path = *ctx.instancePath + value;
+
+			auto target = ctx.paths.find(path);
+			if (target == ctx.paths.end())
+				return Error("Unable to find component '"_sb + path + "' referenced by '" + m.name + "'");
+
+			Store(dest, ctx.relativeTo(ctx.writer->componentOffset(target->second.range, target->second.index), dest));
+
+		} else if (m.typeName == "component") {
+
+			auto nested_itr = ctx.source.structureNames.find(m.defaultValue);
+			if (nested_itr == ctx.source.structureNames.end())
+				return Error("'"_sb + m.name + "' uses unknown component '" + m.defaultValue + "'");
+
+			const CppStructure& nested = ctx.source.structures[nested_itr->second];
+			const std::vector<std::string> parts = SplitCompoundValue(value);
+
+			if (parts.size() > nested.members.size())
+				return Error("'"_sb + value + "' has too many values for '" + m.name + "', " + nested.name + " has " + std::to_string(nested.members.size()) + " members");
+
+			std::vector<const std::string*> nested_values;
+			nested_values.reserve(nested.members.size());
+
+			for (size_t n = 0; n < nested.members.size(); ++n) {
+				nested_values.push_back(n < parts.size() && !parts[n].empty() ? &parts[n] : DefaultValue(nested.members[n]));
+			}
+
+			return EncodeStructure(ctx, nested_itr->second, nested_values.data(), dest);
+
+		} else {
+			return Error("'"_sb + m.name + "' has type '" + m.typeName + "' which has no runtime representation");
+		}
+
+		if (end) {
+			while (*end == ' ' || *end == '\t')
+				++end;
+
+			if (*end != 0)
+				return Error("Unable to read '"_sb + value + "' as " + m.typeName + " for '" + m.name + "'");
+		}
+
+		return Ok();
+	}
+
+	// copies the component an inline component_ref points at over the member that holds the copy, see CppMember::inlineTarget
+	static Result<> CopyInlineTarget(EncodeContext& ctx, const CppMember& ref, const std::string& value, uint8_t* dest) {
+
+		const std::string path = *ctx.instancePath + value;
+
+		auto target = ctx.paths.find(path);
+		if (target == ctx.paths.end())
+			return Error("Unable to find component '"_sb + path + "' referenced by '" + ref.name + "'");
+
+		auto structure = ctx.source.structureNames.find(ref.defaultValue);
+		if (structure == ctx.source.structureNames.end() || target->second.structure != structure->second)
+			return Error("'"_sb + path + "' referenced by '" + ref.name + "' is not a " + ref.defaultValue + ", so it can't be copied");
+
+		const size_t size = ctx.source.structures[structure->second].size;
+		std::memcpy(dest, (*ctx.held)[structure->second].data() + size_t(target->second.flattenIndex) * size, size);
+
+		return Ok();
+	}
+
+	static Result<> EncodeStructure(EncodeContext& ctx, size_t structure, const std::string* const* values, uint8_t* dest) {
+
+		const CppStructure& s = ctx.source.structures[structure];
+		const DefaultComponent* defaults = ctx.defaults && !(*ctx.defaults)[structure].bytes.empty() ? &(*ctx.defaults)[structure] : nullptr;
+
+		// most properties of most components are left at their default, which is copied rather than parsed again
+		if (defaults)
+			std::memcpy(dest, defaults->bytes.data(), s.size);
+
+		for (size_t n = 0; n < s.members.size(); ++n) {
+
+			// encoded into the cold part by the caller
+			if (s.members[n].cold)
+				continue;
+
+			const size_t ref = s.members[n].inlineOf;
+			if (ref != CppMember::NO_MEMBER && ctx.held && !values[ref]->empty()) {
+				auto res = CopyInlineTarget(ctx, s.members[ref], *values[ref], dest + s.members[n].offset);
+				if (res.failed())
+					return Error(s.name + "::" + res.errorMessage(), res.errorInfo());
+
+				continue;
+			}
+
+			if (defaults && defaults->copied[n] && *values[n] == *DefaultValue(s.members[n]))
+				continue;
+
+			auto res = EncodeMember(ctx, s.members[n], *values[n], dest + s.members[n].offset);
+			if (res.failed())
+				return Error(s.name + "::" + res.errorMessage(), res.errorInfo());
+		}
+
+		return Ok();
+	}
+
+	static bool HasComponentRefs(const std::vector<CppStructure>& structures) {
+
+		for (const CppStructure& s : structures) {
+			for (const CppMember& m : s.members) {
+				if (m.typeName == "component_ref")
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	/*
+	Where a component keeps its position and size, found by name since properties have no other meaning to the
+	compiler. A component is positioned when it, or a component nested in it, has f32 properties x and y. f32 width and
+	height make it a rectangle from the position, an f32 radius a circle around it, otherwise it is a point.
+	*/
+	struct SpatialLayout {
+		static const size_t NONE = ~size_t(0);
+
+		bool positioned = false;
+		size_t x = NONE;
+		size_t y = NONE;
+		size_t width = NONE;
+		size_t height = NONE;
+		size_t radius = NONE;
+	};
+
+	static size_t FindFloatMember(const CppStructure& s, const char* name) {
+
+		for (const CppMember& m : s.members) {
+			if (m.typeName == "f32" && m.quantization.kind == CppEncoding::Kind::None && !m.cold && m.name == name)
+				return m.offset;
+		}
+
+		return SpatialLayout::NONE;
+	}
+
+	static bool FindPosition(const SceneSource& source, const CppStructure& s, size_t offset, SpatialLayout& layout) {
+
+		const size_t x = FindFloatMember(s, "x");
+		const size_t y = FindFloatMember(s, "y");
+
+		if (x != SpatialLayout::NONE && y != SpatialLayout::NONE) {
+			layout.x = offset + x;
+			layout.y = offset + y;
+			return true;
+		}
+
+		// an inline copy is where its target is, not the component holding it
+		for (const CppMember& m : s.members) {
+			if (m.typeName != "component" || m.cold || m.inlineOf != CppMember::NO_MEMBER)
+				continue;
+
+			auto nested = source.structureNames.find(m.defaultValue);
+			if (nested != source.structureNames.end() && FindPosition(source, source.structures[nested->second], offset + m.offset, layout))
+				return true;
+		}
+
+		return false;
+	}
+
+	static SpatialLayout FindSpatialLayout(const SceneSource& source, const CppStructure& s) {
+
+		SpatialLayout layout;
+		layout.positioned = FindPosition(source, s, 0, layout);
+		layout.width = FindFloatMember(s, "width");
+		layout.height = FindFloatMember(s, "height");
+		layout.radius = FindFloatMember(s, "radius");
+		return layout;
+	}
+
+	static SceneBounds ComponentBounds(const SpatialLayout& layout, const uint8_t* component) {
+
+		auto load = [component](size_t offset) {
+			float value;
+			std::memcpy(&value, component + offset, sizeof(value));
+			return value;
+		};
+
+		const float x = load(layout.x);
+		const float y = load(layout.y);
+
+		SceneBounds bounds = {x, y, x, y};
+
+		if (layout.width != SpatialLayout::NONE && layout.height != SpatialLayout::NONE) {
+			bounds.minX = std::min(x, x + load(layout.width));
+			bounds.maxX = std::max(x, x + load(layout.width));
+			bounds.minY = std::min(y, y + load(layout.height));
+			bounds.maxY = std::max(y, y + load(layout.height));
+		} else if (layout.radius != SpatialLayout::NONE) {
+			const float radius = std::fabs(load(layout.radius));
+			bounds = {x - radius, y - radius, x + radius, y + radius};
+		}
+
+		// a component whose position isn't a number can't be placed, so it is found by every query instead
+		if (!std::isfinite(bounds.minX) || !std::isfinite(bounds.minY) || !std::isfinite(bounds.maxX) || !std::isfinite(bounds.maxY))
+			bounds = {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX};
+
+		return bounds;
+	}
+
+	/*
+	Components are written to their range in the order of a sort key rather than the order the entity graph is walked
+	in. A component with a sort key property is ordered by its value, a positioned one by the Morton (Z-order) code of
+	its center, so components that are close in the world are close in memory as well. Any other range is left in the
+	order it is flattened in.
+	*/
+	struct RangeOrder {
+		const CppMember* sortKey = nullptr;
+		bool positioned = false;
+
+		// text and references can only be encoded once the file is open, so these components are encoded again
+		bool needsWriter = false;
+
+		// other components hold inline copies of these, so they are kept from the first pass even when not reordered
+		bool copied = false;
+
+		std::vector<uint64_t> keys; // in flatten order
+		std::vector<float> centers; // x, y of each positioned component, turned into keys once the range is complete
+
+		// the index in the range of each component by flatten order, and the reverse
+		std::vector<uint32_t> writeIndices;
+		std::vector<uint32_t> byKey;
+
+		bool sorted() const { return sortKey || positioned; }
+	};
+
+	// an integer that sorts the same way as value
+	static uint64_t OrderedBits(double value) {
+		const uint64_t bits = Load<uint64_t>(reinterpret_cast<const uint8_t*>(&value));
+		return bits & 0x8000000000000000ull ? ~bits : bits | 0x8000000000000000ull;
+	}
+
+	static double LoadSortKey(const CppMember& m, const uint8_t* component) {
+
+		const uint8_t* src = component + m.offset;
+
+		if (m.typeName == "f32")
+			return Load<float>(src);
+
+		if (m.typeName == "f64")
+			return Load<double>(src);
+
+		const bool is_signed = m.typeName == "enum" ? m.enumeration.isSigned : IsSignedInteger(m.typeName);
+
+		switch (m.size) {
+			case 1: return is_signed ? double(Load<int8_t>(src)) : double(Load<uint8_t>(src));
+			case 2: return is_signed ? double(Load<int16_t>(src)) : double(Load<uint16_t>(src));
+			case 4: return is_signed ? double(Load<int32_t>(src)) : double(Load<uint32_t>(src));
+			default: return is_signed ? double(Load<int64_t>(src)) : double(Load<uint64_t>(src));
+		}
+	}
+
+	// moves the bits of v to the even bits of the result
+	static uint64_t SpreadBits(uint32_t v) {
+		uint64_t x = v;
+		x = (x | (x << 16)) & 0x0000ffff0000ffffull;
+		x = (x | (x << 8)) & 0x00ff00ff00ff00ffull;
+		x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0full;
+		x = (x | (x << 2)) & 0x3333333333333333ull;
+		x = (x | (x << 1)) & 0x5555555555555555ull;
+		return x;
+	}
+
+	// the centers are scaled to the bounds of the range, components that are everywhere go last
+	static void CalcMortonKeys(RangeOrder& order) {
+
+		float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+
+		for (size_t n = 0; n < order.centers.size(); n += 2) {
+			if (!std::isfinite(order.centers[n]) || !std::isfinite(order.centers[n + 1]))
+				continue;
+
+			min_x = std::min(min_x, order.centers[n]);
+			max_x = std::max(max_x, order.centers[n]);
+			min_y = std::min(min_y, order.centers[n + 1]);
+			max_y = std::max(max_y, order.centers[n + 1]);
+		}
+
+		const double scale_x = max_x > min_x ? 4294967295.0 / (double(max_x) - min_x) : 0.0;
+		const double scale_y = max_y > min_y ? 4294967295.0 / (double(max_y) - min_y) : 0.0;
+
+		order.keys.clear();
+		order.keys.reserve(order.centers.size() / 2);
+
+		for (size_t n = 0; n < order.centers.size(); n += 2) {
+			const float x = order.centers[n];
+			const float y = order.centers[n + 1];
+
+			if (!std::isfinite(x) || !std::isfinite(y)) {
+				order.keys.push_back(~uint64_t(0));
+				continue;
+			}
+
+			const uint32_t qx = uint32_t(std::min((double(x) - min_x) * scale_x, 4294967295.0));
+			const uint32_t qy = uint32_t(std::min((double(y) - min_y) * scale_y, 4294967295.0));
+			order.keys.push_back(SpreadBits(qx) | (SpreadBits(qy) << 1));
+		}
+
+		order.centers = std::vector<float>();
+	}
+
+	// equal keys keep their flatten order, so compiling the same scene twice gives the same file
+	static void CalcSlots(RangeOrder& order) {
+
+		std::vector<uint32_t> by_key(order.keys.size());
+		for (uint32_t n = 0; n < by_key.size(); ++n) {
+			by_key[n] = n;
+		}
+
+		std::stable_sort(by_key.begin(), by_key.end(), [&](uint32_t a, uint32_t b) {
+			return order.keys[a] < order.keys[b];
+		});
+
+		order.writeIndices.resize(by_key.size());
+		for (uint32_t n = 0; n < by_key.size(); ++n) {
+			order.writeIndices[by_key[n]] = n;
+		}
+
+		order.byKey = std::move(by_key);
+		order.keys = std::vector<uint64_t>();
+	}
+
+	// whether encoding s writes text or refers to another component, cold members aside
+	static bool NeedsWriter(const SceneSource& source, const CppStructure& s) {
+
+		for (const CppMember& m : s.members) {
+			if (m.cold)
+				continue;
+
+			if (m.typeName == "text" || m.typeName == "component_ref")
+				return true;
+
+			if (m.typeName == "component") {
+				auto nested = source.structureNames.find(m.defaultValue);
+				if (nested != source.structureNames.end() && NeedsWriter(source, source.structures[nested->second]))
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	// a component of a structure with every property at its default, text and references are left 0
+	static Result<> EncodeDefault(const SceneSource& source, size_t structure, std::vector<uint8_t>& dest) {
+
+		const CppStructure& s = source.structures[structure];
+
+		const std::vector<size_t> no_ranges;
+		const std::unordered_map<std::string, ComponentLocation> no_paths;
+		EncodeContext ctx{source, nullptr, no_ranges, no_paths, nullptr, nullptr, &EMPTY_VALUE, nullptr, 0};
+
+		std::vector<const std::string*> values;
+		for (const CppMember& m : s.members) {
+			values.push_back(DefaultValue(m));
+		}
+
+		dest.assign(s.size, 0);
+		ctx.component = dest.data();
+
+		auto res = EncodeStructure(ctx, structure, values.data(), dest.data());
+		if (res.failed())
+			dest.clear();
+
+		return res;
+	}
+
+	// Encodes every structure with its properties at their defaults once, so components only encode what they override.
+	// A structure whose defaults can't be encoded is left empty, and the error is reported by the first component of it.
+	static std::vector<DefaultComponent> EncodeDefaults(const SceneSource& source) {
+
+		std::vector<DefaultComponent> defaults(source.structures.size());
+
+		for (size_t n = 0; n < source.structures.size(); ++n) {
+
+			DefaultComponent& d = defaults[n];
+			if (source.structures[n].size == 0 || EncodeDefault(source, n, d.bytes).failed())
+				continue;
+
+			for (const CppMember& m : source.structures[n].members) {
+				auto nested = m.typeName == "component" ? source.structureNames.find(m.defaultValue) : source.structureNames.end();
+				d.copied.push_back(m.typeName != "text" && (nested == source.structureNames.end() || !NeedsWriter(source, source.structures[nested->second])));
+			}
+		}
+
+		return defaults;
+	}
+
+	/*
+	The scene is flattened twice. The first pass counts components, which is enough for the writer to lay out every
+	section, the second pass encodes each component and streams it straight to the writer. Ranges that are reordered,
+	see RangeOrder, are encoded by the first pass to read their sort keys, kept in memory, and written in key order once
+	the second pass is over. Components that others hold inline copies of are kept from the first pass too, so the
+	second pass can copy them whatever order the two are flattened in. The bounds of positioned components are collected
+	on the way for the spatial index, and with names the path of every component for the name table.
+	*/
+	static Result<SceneCompileStats> CompileSceneSource(const SceneSource& source, id_t scene_id, const std::string& output_path, bool names, SceneCompileStats stats) {
+
+		const size_t structure_count = source.structures.size();
+
+		std::vector<uint32_t> counts(structure_count, 0);
+		std::unordered_map<std::string, ComponentLocation> paths;
+
+		// one range per structure that is used, in TypeId order
+		std::vector<size_t> structure_ranges(structure_count, 0);
+		std::vector<SceneRangeInfo> ranges;
+
+		std::vector<SpatialLayout> spatial_layouts;
+		for (const CppStructure& s : source.structures) {
+			// cold parts are never placed, their component is
+			spatial_layouts.push_back(s.hotStructure == CppStructure::NO_STRUCTURE ? FindSpatialLayout(source, s) : SpatialLayout());
+		}
+
+		// cold parts are written in the order of their component
+		std::vector<RangeOrder> orders(structure_count);
+		for (size_t n = 0; n < structure_count; ++n) {
+			for (const CppMember& m : source.structures[n].members) {
+				if (m.sortKey)
+					orders[n].sortKey = &m;
+			}
+
+			orders[n].positioned = !orders[n].sortKey && spatial_layouts[n].positioned;
+			orders[n].needsWriter = orders[n].sorted() && NeedsWriter(source, source.structures[n]);
+		}
+
+		for (const CppStructure& s : source.structures) {
+			for (const CppMember& m : s.members) {
+				auto target = m.inlineOf != CppMember::NO_MEMBER ? source.structureNames.find(m.defaultValue) : source.structureNames.end();
+				if (target != source.structureNames.end())
+					orders[target->second].copied = true;
+			}
+		}
+
+		const std::vector<DefaultComponent> defaults = EncodeDefaults(source);
+
+		// the components of reordered or copied ranges and the cold parts of reordered ranges, in flatten order
+		std::vector<std::vector<uint8_t>> held(structure_count);
+
+		// the index of the first component of each range in Scene::components
+		std::vector<uint32_t> range_starts;
+		uint64_t spatial_count = 0;
+		uint64_t name_count = 0;
+
+		{
+			const auto start = Clock::now();
+
+			const bool needs_paths = HasComponentRefs(source.structures);
+
+			EncodeContext key_ctx{source, nullptr, structure_ranges, paths, &defaults, nullptr, nullptr, nullptr, 0};
+
+			// ranges and their order aren't known yet, they are filled in once every component is counted
+			std::function<Result<>(const FlatComponent&)> count = [&](const FlatComponent& c) -> Result<> {
+				if (needs_paths)
+					paths[*c.instancePath + *c.name] = {c.structure, 0, 0, counts[c.structure]};
+
+				counts[c.structure]++;
+
+				const size_t cold = source.structures[c.structure].coldStructure;
+				if (cold != CppStructure::NO_STRUCTURE)
+					counts[cold]++;
+
+				RangeOrder& order = orders[c.structure];
+				if (!order.sorted() && !order.copied)
+					return Ok();
+
+				const CppStructure& s = source.structures[c.structure];
+
+				std::vector<uint8_t>& components = held[c.structure];
+				components.resize(components.size() + s.size, 0);
+				uint8_t* component = components.data() + components.size() - s.size;
+
+				key_ctx.instancePath = c.instancePath;
+				key_ctx.component = component;
+
+				auto res = EncodeStructure(key_ctx, c.structure, c.values, component);
+				if (res.failed())
+					return Error("Unable to compile '"_sb + *c.instancePath + *c.name + "': " + res.errorMessage(), res.errorInfo());
+
+				if (order.sortKey) {
+					order.keys.push_back(OrderedBits(LoadSortKey(*order.sortKey, component)));
+				} else if (order.positioned) {
+					// NaN when the component is everywhere
+					const SceneBounds bounds = ComponentBounds(spatial_layouts[c.structure], component);
+					const bool placed = std::isfinite(bounds.maxX - bounds.minX) && std::isfinite(bounds.maxY - bounds.minY);
+					order.centers.push_back(placed ? bounds.minX * 0.5f + bounds.maxX * 0.5f : NAN);
+					order.centers.push_back(placed ? bounds.minY * 0.5f + bounds.maxY * 0.5f : NAN);
+				}
+
+				return Ok();
+			};
+
+			auto res = SceneFlattener(source, count).flatten(scene_id, "");
+			if (res.failed())
+				return res.error();
+
+			for (size_t s = 0; s < structure_count; ++s) {
+
+				if (counts[s] == 0)
+					continue;
+
+				if (source.structures[s].size == 0)
+					return Error("'"_sb + source.structures[s].name + "' has properties with no runtime representation, it can't be compiled into a scene");
+
+				structure_ranges[s] = ranges.size();
+				ranges.push_back({uint32_t(s), counts[s], uint32_t(source.structures[s].size)});
+				range_starts.push_back(uint32_t(stats.componentCount));
+				stats.componentCount += counts[s];
+
+				if (spatial_layouts[s].positioned)
+					spatial_count += counts[s];
+
+				// the cold part of a component is found through the component
+				if (names && source.structures[s].hotStructure == CppStructure::NO_STRUCTURE)
+					name_count += counts[s];
+
+				if (orders[s].positioned)
+					CalcMortonKeys(orders[s]);
+
+				if (orders[s].sorted())
+					CalcSlots(orders[s]);
+
+				const size_t cold = source.structures[s].coldStructure;
+				if (orders[s].sorted() && cold != CppStructure::NO_STRUCTURE)
+					held[cold].resize(size_t(counts[s]) * source.structures[cold].size);
+			}
+
+			for (auto& kv : paths) {
+				const RangeOrder& order = orders[kv.second.structure];
+				kv.second.range = uint32_t(structure_ranges[kv.second.structure]);
+				kv.second.index = order.sorted() ? order.writeIndices[kv.second.flattenIndex] : kv.second.flattenIndex;
+			}
+
+			stats.flattenSeconds = SecondsSince(start);
+		}
+
+		{
+			const auto start = Clock::now();
+
+			const SceneSchemaTables schema = BuildSceneSchema(source.structures);
+
+			SceneWriter writer;
+			if (!writer.open(output_path, ranges, schema.schema(), spatial_count, name_count))
+				return Error(writer.error());
+
+			std::vector<SceneSpatialEntry> spatial_entries;
+			spatial_entries.reserve(size_t(spatial_count));
+
+			std::vector<SceneNameEntry> name_entries;
+			name_entries.reserve(size_t(name_count));
+
+			// how many components of each structure have been flattened
+			std::vector<uint32_t> flattened(structure_count, 0);
+
+			// the first pass encoded every component that is copied, none of them need the file
+			EncodeContext ctx{source, &writer, structure_ranges, paths, &defaults, &held, nullptr, nullptr, 0};
+
+			size_t max_size = 0;
+			for (const CppStructure& s : source.structures) {
+				max_size = std::max(max_size, s.size);
+			}
+
+			std::vector<uint8_t> component(max_size);
+			std::vector<uint8_t> cold_component(max_size);
+			std::vector<const std::string*> cold_values;
+
+			std::function<Result<>(const FlatComponent&)> write = [&](const FlatComponent& c) -> Result<> {
+
+				const CppStructure& s = source.structures[c.structure];
+				const RangeOrder& order = orders[c.structure];
+				const size_t range = structure_ranges[c.structure];
+
+				const uint32_t index = flattened[c.structure]++;
+				const uint32_t range_index = order.sorted() ? order.writeIndices[index] : index;
+
+				// the first pass encoded the component already, unless it needed the file
+				const bool kept = order.sorted() || order.copied;
+				uint8_t* encoded = kept ? held[c.structure].data() + size_t(index) * s.size : component.data();
+
+				if (!kept || order.needsWriter) {
+					std::fill(encoded, encoded + s.size, 0);
+					ctx.instancePath = c.instancePath;
+					ctx.component = encoded;
+					ctx.componentOffset = writer.componentOffset(range, range_index);
+
+					auto res = EncodeStructure(ctx, c.structure, c.values, encoded);
+					if (res.failed())
+						return Error("Unable to compile '"_sb + *c.instancePath + *c.name + "': " + res.errorMessage(), res.errorInfo());
+				}
+
+				if (!order.sorted() && !writer.writeComponent(range, encoded))
+					return Error(writer.error());
+
+				if (spatial_layouts[c.structure].positioned)
+					spatial_entries.push_back({range_starts[range] + range_index, ComponentBounds(spatial_layouts[c.structure], encoded)});
+
+				// hashed in two parts, which gives the same as StringHash of the whole path
+				if (names)
+					name_entries.push_back({Hasher().bytes(c.instancePath->data(), c.instancePath->size()).bytes(c.name->data(), c.name->size()).result(), range_starts[range] + range_index});
+
+				// the cold part goes to its own range, at the same index as the component
+				if (s.coldStructure != CppStructure::NO_STRUCTURE) {
+					const CppStructure& cold = source.structures[s.coldStructure];
+
+					cold_values.clear();
+					for (size_t n = 0; n < s.members.size(); ++n) {
+						if (s.members[n].cold)
+							cold_values.push_back(c.values[n]);
+					}
+
+					uint8_t* cold_encoded = order.sorted() ? held[s.coldStructure].data() + size_t(index) * cold.size : cold_component.data();
+
+					std::fill(cold_encoded, cold_encoded + cold.size, 0);
+					ctx.instancePath = c.instancePath;
+					ctx.component = cold_encoded;
+					ctx.componentOffset = writer.componentOffset(structure_ranges[s.coldStructure], range_index);
+
+					auto res = EncodeStructure(ctx, s.coldStructure, cold_values.data(), cold_encoded);
+					if (res.failed())
+						return Error("Unable to compile '"_sb + *c.instancePath + *c.name + "': " + res.errorMessage(), res.errorInfo());
+
+					if (!order.sorted() && !writer.writeComponent(structure_ranges[s.coldStructure], cold_encoded))
+						return Error(writer.error());
+				}
+
+				return Ok();
+			};
+
+			auto res = SceneFlattener(source, write).flatten(scene_id, "");
+			if (res.failed())
+				return res.error();
+
+			for (size_t n = 0; n < structure_count; ++n) {
+				if (counts[n] == 0 || !orders[n].sorted())
+					continue;
+
+				const size_t cold = source.structures[n].coldStructure;
+
+				for (uint32_t flat_index : orders[n].byKey) {
+					if (!writer.writeComponent(structure_ranges[n], held[n].data() + size_t(flat_index) * source.structures[n].size))
+						return Error(writer.error());
+
+					if (cold != CppStructure::NO_STRUCTURE && !writer.writeComponent(structure_ranges[cold], held[cold].data() + size_t(flat_index) * source.structures[cold].size))
+						return Error(writer.error());
+				}
+			}
+
+			if (!writer.writeSpatialIndex(spatial_entries) || !writer.writeNameTable(name_entries) || !writer.finish())
+				return Error(writer.error());
+
+			stats.writeSeconds = SecondsSince(start);
+			stats.byteSize = writer.byteSize();
+		}
+
+		return Ok(stats);
+	}
+
+	static void PrintStats(const std::string& output_path, const SceneCompileStats& stats) {
+
+		if (stats.cached) {
+			std::cout << "Reused " << output_path << " from the cache: " << stats.byteSize << " bytes in " << stats.writeSeconds << "s" << std::endl;
+			return;
+		}
+
+		const double total_seconds = std::max(stats.querySeconds + stats.flattenSeconds + stats.writeSeconds, 1e-9);
+
+		std::cout << "Compiled " << output_path << ": "
+			<< stats.componentCount << " components, "
+			<< stats.byteSize << " bytes in " << total_seconds << "s "
+			<< "(query " << stats.querySeconds << "s, layout " << stats.flattenSeconds << "s, write " << stats.writeSeconds << "s), "
+			<< size_t(stats.componentCount / total_seconds) << " components/s" << std::endl;
+	}
+
+	// bump this whenever the compiler writes something different for the same input, so stale cache entries are ignored
+	static const uint64_t SCENE_CACHE_VERSION = 7;
+
+	/*
+	Hashes everything a compiled scene is built from: the layout of every structure, since it also decides the TypeIds,
+	and every entity, component, child, override and property link reachable from the scene. Entity hashes don't depend
+	on where the entity is instanced, so they are calculated once and shared by every scene that uses them.
+	*/
+	class SceneInputHasher {
+
+		const SceneSource& mSource;
+		uint64_t mSchemaHash = 0;
+
+		std::unordered_map<id_t, uint64_t> mEntityHashes;
+		std::vector<id_t> mEntityStack;
+
+		static void hashOverrides(Hasher& h, const std::vector<SceneSource::Override>& overrides) {
+			h.value(overrides.size());
+			for (const SceneSource::Override& o : overrides) {
+				h.value(o.componentPropId).text(o.value);
+			}
+		}
+
+		uint64_t entityHash(id_t entity_id) {
+
+			auto hash_itr = mEntityHashes.find(entity_id);
+			if (hash_itr != mEntityHashes.end())
+				return hash_itr->second;
+
+			Hasher h;
+			h.value(entity_id);
+
+			auto entity_itr = mSource.entities.find(entity_id);
+
+			// unknown entities and cycles fail to compile, so they never reach the cache
+			if (entity_itr == mSource.entities.end() || std::find(mEntityStack.begin(), mEntityStack.end(), entity_id) != mEntityStack.end())
+				return h.result();
+
+			const SceneSource::Entity& entity = entity_itr->second;
+			mEntityStack.push_back(entity_id);
+
+			h.value(entity.components.size());
+			for (const SceneSource::EntityComponent& ec : entity.components) {
+				h.value(ec.structure).text(ec.name);
+				hashOverrides(h, ec.overrides);
+
+				h.value(ec.links.size());
+				for (const SceneSource::PropLink& link : ec.links) {
+					h.value(link.componentPropId).text(link.operation);
+
+					auto prop_value = mSource.entityPropValues.find(link.entityPropId);
+					h.text(prop_value != mSource.entityPropValues.end() ? prop_value->second : std::string());
+				}
+			}
+
+			h.value(entity.children.size());
+			for (const SceneSource::EntityChild& child : entity.children) {
+				h.text(child.name).value(entityHash(child.childId));
+				hashOverrides(h, child.overrides);
+			}
+
+			mEntityStack.pop_back();
+
+			return mEntityHashes[entity_id] = h.result();
+		}
+
+	public:
+		SceneInputHasher(const SceneSource& source)
+		: mSource(source)
+		{
+			Hasher h;
+			h.value(source.structures.size());
+
+			for (const CppStructure& s : source.structures) {
+				h.value(s.id).text(s.name).value(s.size).value(s.members.size());
+
+				for (const CppMember& m : s.members) {
+					h.value(m.id).text(m.typeName).text(m.name).text(m.defaultValue).text(m.encoding).value(m.cold).value(m.sortKey).value(m.offset).value(m.size);
+
+					for (const CppEnumerator& v : m.enumeration.enumerators) {
+						h.text(v.name).value(v.value);
+					}
+				}
+			}
+
+			mSchemaHash = h.result();
+		}
+
+		uint64_t sceneKey(id_t scene_id) {
+			return Hasher().value(SCENE_CACHE_VERSION).value(mSchemaHash).value(entityHash(scene_id)).result();
+		}
+	};
+
+	static Result<> CopySceneFile(const std::string& from, const std::string& to) {
+
+		FILE* in = std::fopen(from.c_str(), "rb");
+		if (!in)
+			return Error("Unable to open "_sb + from);
+
+		FILE* out = std::fopen(to.c_str(), "wb");
+		if (!out) {
+			std::fclose(in);
+			return Error("Unable to open "_sb + to + " for writing");
+		}
+
+		std::vector<uint8_t> buffer(SceneWriter::CHUNK_SIZE);
+		bool ok = true;
+
+		while (ok) {
+			const size_t count = std::fread(buffer.data(), 1, buffer.size(), in);
+			if (count == 0) {
+				ok = !std::ferror(in);
+				break;
+			}
+
+			ok = std::fwrite(buffer.data(), 1, count, out) == count;
+		}
+
+		std::fclose(in);
+		ok = std::fclose(out) == 0 && ok;
+
+		if (!ok)
+			return Error("Unable to copy "_sb + from + " to " + to);
+
+		return Ok();
+	}
+
+	static bool FileExists(const std::string& path) {
+
+		FILE* fp = std::fopen(path.c_str(), "rb");
+		if (!fp)
+			return false;
+
+		std::fclose(fp);
+		return true;
+	}
+
+	/*
+	Compiled scenes are stored in cache_dir named after the hash of their input, so an unchanged scene is a file copy.
+	New entries are written under a temporary name and renamed, other builds sharing the cache never see partial files.
+	*/
+	static Result<SceneCompileStats> CompileCachedScene(const SceneSource& source, id_t scene_id, uint64_t key, const std::string& output_path, const std::string& cache_dir, bool names, SceneCompileStats stats) {
+
+		if (cache_dir.empty())
+			return CompileSceneSource(source, scene_id, output_path, names, stats);
+
+		char key_text[32];
+		std::snprintf(key_text, sizeof(key_text), "%016llx", (unsigned long long)key);
+		const std::string cache_path = cache_dir + "/" + key_text + (names ? ".names.bin" : ".bin");
+
+		if (FileExists(cache_path)) {
+			const auto start = Clock::now();
+
+			// replaced like SceneWriter does, a running game may have the output mapped
+			const std::string temp_output_path = output_path + ".tmp";
+
+			auto res = CopySceneFile(cache_path, temp_output_path);
+			if (res.failed())
+				return res.error();
+
+			if (!ReplaceFile(temp_output_path, output_path)) {
+				std::remove(temp_output_path.c_str());
+				return Error("Unable to write "_sb + output_path);
+			}
+
+			FILE* fp = std::fopen(output_path.c_str(), "rb");
+			if (fp) {
+				std::fseek(fp, 0, SEEK_END);
+				stats.byteSize = size_t(std::ftell(fp));
+				std::fclose(fp);
+			}
+
+			stats.cached = true;
+			stats.writeSeconds = SecondsSince(start);
+			return Ok(stats);
+		}
+
+		auto res = CompileSceneSource(source, scene_id, output_path, names, stats);
+		if (res.failed())
+			return res.error();
+
+		const std::string temp_path = cache_path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+		auto copy_res = CopySceneFile(output_path, temp_path);
+		if (copy_res.failed())
+			return copy_res.error();
+
+		// another build may have added the same entry in the mean time, which is just as good
+		if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0)
+			std::remove(temp_path.c_str());
+
+		return res;
+	}
+
+	// entities that are not instanced by any other entity
+	static std::vector<id_t> FindSceneEntities(const SceneSource& source) {
+
+		std::unordered_set<id_t> instanced;
+		for (const auto& kv : source.entities) {
+			for (const SceneSource::EntityChild& child : kv.second.children) {
+				instanced.insert(child.childId);
+			}
+		}
+
+		std::vector<id_t> result;
+		for (const auto& kv : source.entities) {
+			if (!instanced.count(kv.first) && (!kv.second.components.empty() || !kv.second.children.empty()))
+				result.push_back(kv.first);
+		}
+
+		std::sort(result.begin(), result.end(), [&](id_t a, id_t b) {
+			return source.entities.at(a).name < source.entities.at(b).name;
+		});
+
+		return result;
+	}
+
+	/*
+	Scenes only read from the source, so any number of them can be compiled at once. Each worker takes the next scene
+	that hasn't been started, the first error stops the workers from taking more.
+	*/
+	static Result<MultiSceneCompileStats> CompileSceneSources(const SceneSource& source, const std::vector<id_t>& scene_ids, const std::string& output_dir, const std::string& cache_dir, size_t thread_count, bool names, MultiSceneCompileStats stats) {
+
+		for (size_t n = 0; n < scene_ids.size(); ++n) {
+			for (size_t i = 0; i < n; ++i) {
+				if (source.entities.at(scene_ids[i]).name == source.entities.at(scene_ids[n]).name)
+					return Error("More than one scene is named '"_sb + source.entities.at(scene_ids[n]).name + "'");
+			}
+		}
+
+		// hashing shares work between scenes, so it is done up front rather than on the workers
+		std::vector<uint64_t> keys;
+		if (!cache_dir.empty()) {
+			SceneInputHasher hasher(source);
+			for (id_t scene_id : scene_ids) {
+				keys.push_back(hasher.sceneKey(scene_id));
+			}
+		}
+
+		stats.threadCount = std::max<size_t>(1, std::min(thread_count, scene_ids.size()));
+		stats.scenes.resize(scene_ids.size());
+
+		std::atomic<size_t> next_scene{0};
+		std::atomic<bool> failed{false};
+
+		std::mutex error_mutex;
+		Result<> error = Ok();
+
+		auto worker = [&]() {
+			while (!failed) {
+
+				const size_t n = next_scene++;
+				if (n >= scene_ids.size())
+					return;
+
+				const std::string& name = source.entities.at(scene_ids[n]).name;
+				const std::string output_path = output_dir + "/" + name + ".bin";
+
+				auto res = CompileCachedScene(source, scene_ids[n], keys.empty() ? 0 : keys[n], output_path, cache_dir, names, SceneCompileStats());
+				if (res.failed()) {
+					std::lock_guard<std::mutex> lock(error_mutex);
+					if (!failed.exchange(true))
+						error = Error("Unable to compile scene '"_sb + name + "': " + res.errorMessage(), res.errorInfo());
+
+					return;
+				}
+
+				stats.scenes[n] = {output_path, *res};
+			}
+		};
+
+		const auto start = Clock::now();
+
+		{
+			std::vector<std::thread> threads;
+			for (size_t n = 1; n < stats.threadCount; ++n) {
+				threads.emplace_back(worker);
+			}
+
+			worker();
+
+			for (std::thread& t : threads) {
+				t.join();
+			}
+		}
+
+		stats.compileSeconds = SecondsSince(start);
+
+		if (error.failed())
+			return error.error();
+
+		double sequential_seconds = 0;
+		size_t cached_count = 0;
+
+		for (const auto& scene : stats.scenes) {
+			PrintStats(scene.first, scene.second);
+			sequential_seconds += scene.second.flattenSeconds + scene.second.writeSeconds;
+			cached_count += scene.second.cached ? 1 : 0;
+		}
+
+		std::cout << "Compiled " << stats.scenes.size() - cached_count << " scenes and reused " << cached_count << " on " << stats.threadCount << " threads in "
+			<< stats.querySeconds + stats.compileSeconds << "s (query " << stats.querySeconds << "s, compile " << stats.compileSeconds << "s), "
+			<< sequential_seconds / std::max(stats.compileSeconds, 1e-9) << "x the speed of one thread" << std::endl;
+
+		return Ok(std::move(stats));
+	}
+
+	Result<std::vector<std::vector<uint8_t>>> EncodeDefaultComponents(const std::vector<CppStructure>& structures) {
+
+		SceneSource source;
+		source.structures = structures;
+		source.indexStructures();
+
+		std::vector<std::vector<uint8_t>> defaults(structures.size());
+
+		for (size_t n = 0; n < structures.size(); ++n) {
+			if (structures[n].size == 0)
+				continue;
+
+			auto res = EncodeDefault(source, n, defaults[n]);
+			if (res.failed())
+				return Error("Unable to generate the default '"_sb + structures[n].name + "': " + res.errorMessage(), res.errorInfo());
+		}
+
+		return Ok(std::move(defaults));
+	}
+
+	Result<SceneCompileStats> CompileScene(const Transaction& t, const std::string& scene_name, const std::string& output_path, const std::string& cache_dir, bool names) {
+
+		SceneCompileStats stats;
+		SceneSource source;
+
+		{
+			const auto start = Clock::now();
+
+			auto res = QuerySceneSource(t, source);
+			if (res.failed())
+				return res.error();
+
+			stats.querySeconds = SecondsSince(start);
+		}
+
+		for (const auto& kv : source.entities) {
+			if (kv.second.name != scene_name)
+				continue;
+
+			const uint64_t key = cache_dir.empty() ? 0 : SceneInputHasher(source).sceneKey(kv.first);
+
+			auto res = CompileCachedScene(source, kv.first, key, output_path, cache_dir, names, stats);
+			if (res.failed())
+				return res.error();
+
+			PrintStats(output_path, *res);
+			return res;
+		}
+
+		return Error("Unable to find scene entity '"_sb + scene_name + "'");
+	}
+
+	Result<MultiSceneCompileStats> CompileAllScenes(const Transaction& t, const std::string& output_dir, const std::string& cache_dir, size_t thread_count, const std::string& pack_path, bool names) {
+
+		MultiSceneCompileStats stats;
+		SceneSource source;
+
+		{
+			const auto start = Clock::now();
+
+			auto res = QuerySceneSource(t, source);
+			if (res.failed())
+				return res.error();
+
+			stats.querySeconds = SecondsSince(start);
+		}
+
+		const std::vector<id_t> scene_ids = FindSceneEntities(source);
+
+		auto res = CompileSceneSources(source, scene_ids, output_dir, cache_dir, thread_count, names, std::move(stats));
+		if (res.failed() || pack_path.empty())
+			return res;
+
+		std::vector<ScenePackInput> pack_inputs;
+		for (size_t n = 0; n < scene_ids.size(); ++n) {
+			pack_inputs.push_back({source.entities.at(scene_ids[n]).name, res->scenes[n].first});
+		}
+
+		auto pack_res = WriteScenePack(source.structures, pack_inputs, pack_path);
+		if (pack_res.failed())
+			return pack_res.error();
+
+		return res;
+	}
+
+	static CppMember BenchmarkMember(id_t id, const char* type_name, const char* name, const char* default_value) {
+		CppMember m;
+		m.id = id;
+		m.typeName = type_name;
+		m.name = name;
+		m.defaultValue = default_value;
+		return m;
+	}
+
+	Result<SceneCompileStats> BenchmarkSceneCompiler(size_t component_count, const std::string& output_path) {
+
+		const size_t LEAF_COMPONENTS = 10;
+		const size_t BLOCK_CHILDREN = 100;
+
+		SceneSource source;
+
+		// the same components the example game uses, in TypeId order
+		{
+			CppStructure transform;
+			transform.id = 1;
+			transform.name = "Transform";
+			transform.members = {BenchmarkMember(1, "f32", "x", "0"), BenchmarkMember(2, "f32", "y", "0")};
+
+			CppStructure circle;
+			circle.id = 2;
+			circle.name = "Circle";
+			circle.members = {BenchmarkMember(3, "f32", "radius", "1"), BenchmarkMember(4, "component", "transform", "Transform")};
+
+			CppStructure rect;
+			rect.id = 3;
+			rect.name = "Rect";
+			rect.members = {BenchmarkMember(5, "f32", "width", "1"), BenchmarkMember(6, "f32", "height", "1"), BenchmarkMember(7, "component", "transform", "Transform")};
+
+			source.structures = {transform, circle, rect};
+			CalcLayouts(source.structures);
+			source.indexStructures();
+		}
+
+		// a leaf entity with a mix of components, instanced in blocks, which are instanced by the scene
+		const id_t LEAF_ID = 1, BLOCK_ID = 2, SCENE_ID = 3;
+
+		{
+			SceneSource::Entity& leaf = source.entities[LEAF_ID];
+			leaf.name = "Leaf";
+
+			const id_t override_props[] = {1, 3, 5};
+
+			for (size_t n = 0; n < LEAF_COMPONENTS; ++n) {
+				SceneSource::EntityComponent ec;
+				ec.id = id_t(n);
+				ec.name = "Component " + std::to_string(n);
+				ec.structure = n % source.structures.size();
+				ec.overrides.push_back({override_props[ec.structure], std::to_string(n * 2)});
+				leaf.components.push_back(std::move(ec));
+			}
+		}
+
+		{
+			SceneSource::Entity& block = source.entities[BLOCK_ID];
+			block.name = "Block";
+
+			for (size_t n = 0; n < BLOCK_CHILDREN; ++n) {
+				SceneSource::EntityChild ec;
+				ec.id = id_t(n);
+				ec.name = "Leaf " + std::to_string(n);
+				ec.childId = LEAF_ID;
+				ec.overrides.push_back({7, "(" + std::to_string(n) + ", " + std::to_string(n * 2) + ")"});
+				block.children.push_back(std::move(ec));
+			}
+		}
+
+		{
+			SceneSource::Entity& scene = source.entities[SCENE_ID];
+			scene.name = "Scene";
+
+			const size_t block_count = std::max<size_t>(1, component_count / (LEAF_COMPONENTS * BLOCK_CHILDREN));
+
+			for (size_t n = 0; n < block_count; ++n) {
+				SceneSource::EntityChild ec;
+				ec.id = id_t(BLOCK_CHILDREN + n);
+				ec.name = "Block " + std::to_string(n);
+				ec.childId = BLOCK_ID;
+				ec.overrides.push_back({4, "(" + std::to_string(n) + ", 0)"});
+				scene.children.push_back(std::move(ec));
+			}
+		}
+
+		auto res = CompileSceneSource(source, SCENE_ID, output_path, false, SceneCompileStats());
+		if (res.failed())
+			return res.error();
+
+		PrintStats(output_path, *res);
+		return res;
+	}
+
+	// a section to build a table into, 8 byte aligned like the scene file
+	static std::vector<uint64_t> NameTableSection(size_t entry_count) {
+		return std::vector<uint64_t>(size_t(SceneNameTableSize(entry_count) + 7) / 8);
+	}
+
+	static uint64_t PathHash(const std::string& path) {
+		return StringHash(path.data(), path.size());
+	}
+
+	TEST(SceneNames, LookupEveryPath) {
+
+		for (uint32_t count : {1u, 2u, 3u, 7u, 100u, 10000u}) {
+
+			std::vector<SceneNameEntry> entries;
+			for (uint32_t n = 0; n < count; ++n) {
+				entries.push_back({PathHash("Block " + std::to_string(n / 10) + "/Leaf " + std::to_string(n % 10)), n * 3});
+			}
+
+			std::vector<uint64_t> section = NameTableSection(entries.size());
+			ASSERT_TRUE(BuildSceneNameTable(entries, reinterpret_cast<uint8_t*>(section.data())));
+
+			const SceneNameTable& table = *reinterpret_cast<const SceneNameTable*>(section.data());
+			EXPECT_EQ(count, table.entryCount);
+
+			for (const SceneNameEntry& e : entries) {
+				EXPECT_EQ(e.component, LookupSceneName(table, e.hash)) << count << " entries";
+			}
+
+			// paths that aren't in the table land on a slot that belongs to another path
+			for (uint32_t n = 0; n < 1000; ++n) {
+				EXPECT_EQ(NO_SCENE_NAME, LookupSceneName(table, PathHash("Missing/Leaf " + std::to_string(n)))) << count << " entries";
+			}
+		}
+	}
+
+	TEST(SceneNames, DuplicateHashes) {
+
+		std::vector<SceneNameEntry> entries;
+		for (uint32_t n = 0; n < 100; ++n) {
+			entries.push_back({PathHash("Leaf " + std::to_string(n)), n});
+		}
+
+		// the same path for two components, among others
+		entries.push_back({PathHash("Leaf 42"), 100});
+
+		std::vector<uint64_t> section = NameTableSection(entries.size());
+		EXPECT_FALSE(BuildSceneNameTable(entries, reinterpret_cast<uint8_t*>(section.data())));
+
+		// and on their own
+		const std::vector<SceneNameEntry> pair = {{PathHash("Door/Body"), 0}, {PathHash("Door/Body"), 1}};
+		section = NameTableSection(pair.size());
+		EXPECT_FALSE(BuildSceneNameTable(pair, reinterpret_cast<uint8_t*>(section.data())));
+	}
+
+	TEST(SceneNames, EmptyTable) {
+		EXPECT_EQ(0u, SceneNameTableSize(0));
+		EXPECT_TRUE(BuildSceneNameTable({}, nullptr));
+	}
+
+	static std::vector<uint32_t> QuerySpatial(const std::vector<SceneSpatialEntry>& entries, const SceneBounds& area) {
+
+		std::vector<uint64_t> section(size_t(SceneSpatialIndexSize(entries.size()) + 7) / 8);
+		BuildSceneSpatialIndex(entries, reinterpret_cast<uint8_t*>(section.data()));
+
+		std::vector<uint32_t> found;
+		QuerySceneSpatialIndex(*reinterpret_cast<const SceneSpatialIndex*>(section.data()), area, found);
+		std::sort(found.begin(), found.end());
+		return found;
+	}
+
+	static std::vector<uint32_t> QueryBruteForce(const std::vector<SceneSpatialEntry>& entries, const SceneBounds& area) {
+
+		std::vector<uint32_t> found;
+		for (const SceneSpatialEntry& e : entries) {
+			if (e.bounds.overlaps(area))
+				found.push_back(e.component);
+		}
+
+		std::sort(found.begin(), found.end());
+		return found;
+	}
+
+	TEST(SceneSpatial, MatchesBruteForce) {
+
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> small(0.0f, 20.0f);
+		std::uniform_real_distribution<float> large(100.0f, 800.0f);
+		std::uniform_int_distribution<int> kind(0, 99);
+
+		const float inf = std::numeric_limits<float>::infinity();
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+
+		for (uint32_t count : {1u, 5u, 100u, 5000u}) {
+
+			std::vector<SceneSpatialEntry> entries;
+			for (uint32_t n = 0; n < count; ++n) {
+				const float x = position(random);
+				const float y = position(random);
+				const int k = kind(random);
+
+				SceneBounds bounds = {x, y, x, y}; // points
+				if (k < 60)
+					bounds = {x, y, x + small(random), y + small(random)};
+				else if (k < 70)
+					bounds = {x, y, x + large(random), y + large(random)}; // larger than a cell
+				else if (k < 73)
+					bounds = {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX}; // everywhere, what the compiler writes for non finite positions
+				else if (k < 75)
+					bounds = {nan, y, nan, y};
+
+				entries.push_back({n * 2 + 1, bounds});
+			}
+
+			std::vector<SceneBounds> areas = {
+				{-inf, -inf, inf, inf},
+				{-1000.0f, -1000.0f, 1000.0f, 1000.0f}, // the grid exactly, so its last column and row are clamped
+				{990.0f, 990.0f, 5000.0f, 5000.0f}, // over the far edge
+				{-5000.0f, -5000.0f, -990.0f, -990.0f}, // over the near edge
+				{2000.0f, 2000.0f, 3000.0f, 3000.0f}, // past the grid
+				{-3000.0f, -3000.0f, -2000.0f, -2000.0f}, // before it
+				{0.0f, 0.0f, 0.0f, 0.0f},
+				{nan, 0.0f, 10.0f, 10.0f},
+			};
+
+			for (int n = 0; n < 200; ++n) {
+				const float x = position(random);
+				const float y = position(random);
+				areas.push_back({x, y, x + small(random) * 10.0f, y + small(random) * 10.0f});
+			}
+
+			// points exactly on the corners of entries, which only touch
+			for (size_t n = 0; n < entries.size() && n < 50; ++n) {
+				areas.push_back({entries[n].bounds.maxX, entries[n].bounds.maxY, entries[n].bounds.maxX, entries[n].bounds.maxY});
+				areas.push_back({entries[n].bounds.minX, entries[n].bounds.minY, entries[n].bounds.minX, entries[n].bounds.minY});
+			}
+
+			for (const SceneBounds& area : areas) {
+				EXPECT_EQ(QueryBruteForce(entries, area), QuerySpatial(entries, area)) << count << " entries, area " << area.minX << ", " << area.minY << " to " << area.maxX << ", " << area.maxY;
+			}
+		}
+	}
+
+	TEST(SceneSpatial, Degenerate) {
+
+		// every component at one point, and only components that cover everything
+		const std::vector<SceneSpatialEntry> same = {{0, {5.0f, 5.0f, 5.0f, 5.0f}}, {1, {5.0f, 5.0f, 5.0f, 5.0f}}, {2, {5.0f, 5.0f, 6.0f, 6.0f}}};
+		const std::vector<SceneSpatialEntry> everywhere = {{0, {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX}}, {1, {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX}}};
+
+		for (const SceneBounds& area : {SceneBounds{4.0f, 4.0f, 5.0f, 5.0f}, SceneBounds{5.5f, 5.5f, 7.0f, 7.0f}, SceneBounds{-10.0f, -10.0f, -9.0f, -9.0f}}) {
+			EXPECT_EQ(QueryBruteForce(same, area), QuerySpatial(same, area));
+			EXPECT_EQ(QueryBruteForce(everywhere, area), QuerySpatial(everywhere, area));
+		}
+	}
+
+	TEST(Quantize, HalfRoundTrip) {
+
+		// every half that is a number decodes and encodes back to itself, with either sign
+		for (uint32_t half = 0; half < 0x10000; ++half) {
+			if ((half & 0x7fff) > 0x7c00) {
+				EXPECT_TRUE(std::isnan(DecodeHalf(uint16_t(half)))) << half;
+				EXPECT_EQ(0x7e00u, EncodeHalf(DecodeHalf(uint16_t(half))) & 0x7fffu) << half;
+				continue;
+			}
+
+			EXPECT_EQ(half, EncodeHalf(DecodeHalf(uint16_t(half)))) << half;
+		}
+
+		EXPECT_EQ(0x3c00, EncodeHalf(1.0f));
+		EXPECT_EQ(0xc000, EncodeHalf(-2.0f));
+		EXPECT_EQ(0x7bff, EncodeHalf(65504.0f));
+		EXPECT_EQ(0x0001, EncodeHalf(std::ldexp(1.0f, -24)));
+		EXPECT_EQ(0x8000, EncodeHalf(-0.0f));
+	}
+
+	TEST(Quantize, HalfRounding) {
+
+		// halfway between two halves rounds to the even one, anything off the middle to the nearer, denormals included
+		for (uint32_t half = 0; half < 0x7bff; ++half) {
+			const float low = DecodeHalf(uint16_t(half));
+			const float high = DecodeHalf(uint16_t(half + 1));
+			const float middle = low + (high - low) * 0.5f;
+			const uint16_t even = uint16_t((half & 1) ? half + 1 : half);
+
+			EXPECT_EQ(even, EncodeHalf(middle)) << half;
+			EXPECT_EQ(half, EncodeHalf(std::nextafter(middle, 0.0f))) << half;
+			EXPECT_EQ(half + 1, EncodeHalf(std::nextafter(middle, FLT_MAX))) << half;
+			EXPECT_EQ(half | 0x8000, EncodeHalf(-std::nextafter(middle, 0.0f))) << half;
+		}
+
+		// below half the smallest denormal is zero
+		EXPECT_EQ(0x0000, EncodeHalf(std::ldexp(1.0f, -25)));
+		EXPECT_EQ(0x0001, EncodeHalf(std::nextafter(std::ldexp(1.0f, -25), 1.0f)));
+		EXPECT_EQ(0x8000, EncodeHalf(-std::ldexp(1.0f, -30)));
+	}
+
+	TEST(Quantize, HalfOverflow) {
+
+		const float inf = std::numeric_limits<float>::infinity();
+
+		// 65520 is halfway between the largest half and the next power of two, so it rounds up to infinity
+		EXPECT_EQ(0x7bff, EncodeHalf(std::nextafter(65520.0f, 0.0f)));
+		EXPECT_EQ(0x7c00, EncodeHalf(65520.0f));
+		EXPECT_EQ(0x7c00, EncodeHalf(65536.0f));
+		EXPECT_EQ(0x7c00, EncodeHalf(FLT_MAX));
+		EXPECT_EQ(0x7c00, EncodeHalf(inf));
+		EXPECT_EQ(0xfc00, EncodeHalf(-1e10f));
+		EXPECT_EQ(0xfc00, EncodeHalf(-inf));
+
+		EXPECT_EQ(inf, DecodeHalf(0x7c00));
+		EXPECT_EQ(-inf, DecodeHalf(0xfc00));
+		EXPECT_TRUE(std::isnan(DecodeHalf(EncodeHalf(std::numeric_limits<float>::quiet_NaN()))));
+	}
+
+	TEST(Quantize, Unorm) {
+
+		for (uint32_t n = 0; n <= 0xff; ++n) {
+			EXPECT_EQ(n, EncodeUnorm<uint8_t>(DecodeUnorm(uint8_t(n))));
+		}
+
+		for (uint32_t n = 0; n <= 0xffff; ++n) {
+			EXPECT_EQ(n, EncodeUnorm<uint16_t>(DecodeUnorm(uint16_t(n))));
+		}
+
+		EXPECT_EQ(0xffffffffu, EncodeUnorm<uint32_t>(1.0));
+		EXPECT_EQ(1.0f, DecodeUnorm(uint32_t(0xffffffffu)));
+
+		// to nearest, halfway away from zero
+		EXPECT_EQ(0, EncodeUnorm<uint8_t>(0.49 / 255.0));
+		EXPECT_EQ(1, EncodeUnorm<uint8_t>(0.5 / 255.0));
+		EXPECT_EQ(128, EncodeUnorm<uint8_t>(0.5));
+		EXPECT_EQ(254, EncodeUnorm<uint8_t>(254.49 / 255.0));
+
+		const double inf = std::numeric_limits<double>::infinity();
+		EXPECT_EQ(0, EncodeUnorm<uint8_t>(-0.5));
+		EXPECT_EQ(0, EncodeUnorm<uint8_t>(-inf));
+		EXPECT_EQ(255, EncodeUnorm<uint8_t>(1.5));
+		EXPECT_EQ(0xffff, EncodeUnorm<uint16_t>(inf));
+		EXPECT_EQ(0, EncodeUnorm<uint8_t>(std::numeric_limits<double>::quiet_NaN()));
+		EXPECT_EQ(0u, EncodeUnorm<uint32_t>(std::numeric_limits<double>::quiet_NaN()));
+	}
+
+	TEST(Quantize, Snorm) {
+
+		// the smallest value is the only one that doesn't come back, it decodes to -1 like the one above it
+		for (int32_t n = -127; n <= 127; ++n) {
+			EXPECT_EQ(n, EncodeSnorm<int8_t>(DecodeSnorm(int8_t(n))));
+		}
+
+		for (int32_t n = -32767; n <= 32767; ++n) {
+			EXPECT_EQ(n, EncodeSnorm<int16_t>(DecodeSnorm(int16_t(n))));
+		}
+
+		EXPECT_EQ(-1.0f, DecodeSnorm(int8_t(-128)));
+		EXPECT_EQ(-1.0f, DecodeSnorm(int16_t(-32768)));
+		EXPECT_EQ(0.0f, DecodeSnorm(int8_t(0)));
+
+		EXPECT_EQ(0, EncodeSnorm<int8_t>(0.49 / 127.0));
+		EXPECT_EQ(1, EncodeSnorm<int8_t>(0.5 / 127.0));
+		EXPECT_EQ(-1, EncodeSnorm<int8_t>(-0.5 / 127.0));
+
+		const double inf = std::numeric_limits<double>::infinity();
+		EXPECT_EQ(-127, EncodeSnorm<int8_t>(-2.0));
+		EXPECT_EQ(-32767, EncodeSnorm<int16_t>(-inf));
+		EXPECT_EQ(127, EncodeSnorm<int8_t>(2.0));
+		EXPECT_EQ(32767, EncodeSnorm<int16_t>(inf));
+		EXPECT_EQ(0, EncodeSnorm<int8_t>(std::numeric_limits<double>::quiet_NaN()));
+		EXPECT_EQ(0, EncodeSnorm<int32_t>(std::numeric_limits<double>::quiet_NaN()));
+	}
+
+	TEST(Quantize, Fixed) {
+
+		for (uint32_t n = 0; n <= 0xffff; ++n) {
+			EXPECT_EQ(n, EncodeFixed<uint16_t>(DecodeFixed(uint16_t(n), -100.0f, 300.0f), -100.0f, 300.0f));
+		}
+
+		EXPECT_EQ(0, EncodeFixed<uint8_t>(-100.0, -100.0f, 300.0f));
+		EXPECT_EQ(255, EncodeFixed<uint8_t>(300.0, -100.0f, 300.0f));
+		EXPECT_EQ(-100.0f, DecodeFixed(uint8_t(0), -100.0f, 300.0f));
+		EXPECT_EQ(300.0f, DecodeFixed(uint8_t(255), -100.0f, 300.0f));
+
+		// steps of 400 / 255, to the nearer one
+		const double step = 400.0 / 255.0;
+		EXPECT_EQ(10, EncodeFixed<uint8_t>(-100.0 + step * 10.4, -100.0f, 300.0f));
+		EXPECT_EQ(11, EncodeFixed<uint8_t>(-100.0 + step * 10.6, -100.0f, 300.0f));
+
+		EXPECT_EQ(0, EncodeFixed<uint8_t>(-1000.0, -100.0f, 300.0f));
+		EXPECT_EQ(255, EncodeFixed<uint8_t>(1000.0, -100.0f, 300.0f));
+		EXPECT_EQ(0, EncodeFixed<uint8_t>(std::numeric_limits<double>::quiet_NaN(), -100.0f, 300.0f));
+
+		// an empty range is 0 / 0
+		EXPECT_EQ(0, EncodeFixed<uint8_t>(5.0, 5.0f, 5.0f));
+	}
+
+	// schemas by hand, so a test controls exactly what changed between them
+	struct TestSchemaMember {
+		const char* name;
+		const char* type;
+		const char* target;
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	static void AddTestSchemaType(SceneSchemaTables& tables, const char* name, uint32_t size, const std::vector<TestSchemaMember>& members) {
+
+		tables.types.push_back({StringHash(name, std::strlen(name)), size, uint32_t(tables.members.size()), uint32_t(members.size()), 0});
+
+		for (const TestSchemaMember& m : members) {
+			const uint64_t target = m.target ? StringHash(m.target, std::strlen(m.target)) : 0;
+			tables.members.push_back({StringHash(m.name, std::strlen(m.name)), StringHash(m.type, std::strlen(m.type)), target, m.offset, m.size});
+		}
+	}
+
+	template<typename T>
+	static T LoadAt(const uint8_t* p) {
+		T value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	template<typename T>
+	static void StoreAt(uint8_t* p, T value) {
+		std::memcpy(p, &value, sizeof(value));
+	}
+
+	TEST(SceneSchema, ConvertScene) {
+
+		SceneSchemaTables source;
+		source.hash = 1;
+		AddTestSchemaType(source, "Item", 48, {
+			{"a", "f32", nullptr, 0, 4},
+			{"b", "i32", nullptr, 4, 4},
+			{"c", "f64", nullptr, 8, 8},
+			{"label", "text", nullptr, 16, 8},
+			{"owner", "component_ref", "Item", 24, 8},
+			{"removed", "u32", nullptr, 32, 4},
+			{"retyped", "f32", nullptr, 36, 4},
+		});
+		AddTestSchemaType(source, "Gone", 16, {{"x", "i32", nullptr, 0, 4}});
+		AddTestSchemaType(source, "Other", 16, {
+			{"value", "u64", nullptr, 0, 8},
+			{"item", "component_ref", "Item", 8, 8},
+		});
+
+		// Item is reordered, gains added, loses removed and retyped changes type. Other swaps its members, Gone is dropped.
+		SceneSchemaTables target;
+		target.hash = 2;
+		AddTestSchemaType(target, "Other", 16, {
+			{"item", "component_ref", "Item", 0, 8},
+			{"value", "u64", nullptr, 8, 8},
+		});
+		AddTestSchemaType(target, "Item", 48, {
+			{"c", "f64", nullptr, 0, 8},
+			{"a", "f32", nullptr, 8, 4},
+			{"b", "i32", nullptr, 12, 4},
+			{"added", "f32", nullptr, 16, 4},
+			{"retyped", "f64", nullptr, 24, 8},
+			{"label", "text", nullptr, 32, 8},
+			{"owner", "component_ref", "Item", 40, 8},
+		});
+
+		const std::string path = ::testing::TempDir() + "sg_convert_test.scene";
+		const std::vector<SceneRangeInfo> ranges = {{0, 3, 48}, {1, 2, 16}, {2, 2, 16}};
+
+		{
+			SceneWriter writer;
+			ASSERT_TRUE(writer.open(path, ranges, source.schema())) << writer.error();
+
+			for (uint32_t n = 0; n < 3; ++n) {
+				uint8_t item[48] = {};
+				const uint64_t at = writer.nextComponentOffset(0);
+				const std::string label = "Item " + std::to_string(n);
+
+				StoreAt(item + 0, float(n) + 0.5f);
+				StoreAt(item + 4, -int32_t(n));
+				StoreAt(item + 8, double(n) * 100.25);
+				StoreAt(item + 16, int64_t(writer.writeText(label.data(), label.size()) - (at + 16)));
+				StoreAt(item + 32, uint32_t(0xdeadbeef));
+				StoreAt(item + 36, 3.0f);
+
+				// the last item refers to nothing
+				if (n < 2)
+					StoreAt(item + 24, int64_t(writer.componentOffset(0, n + 1) - (at + 24)));
+
+				ASSERT_TRUE(writer.writeComponent(0, item)) << writer.error();
+			}
+
+			for (uint32_t n = 0; n < 2; ++n) {
+				uint8_t gone[16] = {};
+				StoreAt(gone, int32_t(7));
+				ASSERT_TRUE(writer.writeComponent(1, gone)) << writer.error();
+			}
+
+			for (uint32_t n = 0; n < 2; ++n) {
+				uint8_t other[16] = {};
+				const uint64_t at = writer.nextComponentOffset(2);
+
+				StoreAt(other + 0, uint64_t(1000 + n));
+				StoreAt(other + 8, int64_t(writer.componentOffset(0, 2 - n) - (at + 8)));
+				ASSERT_TRUE(writer.writeComponent(2, other)) << writer.error();
+			}
+
+			ASSERT_TRUE(writer.finish()) << writer.error();
+		}
+
+		std::vector<SceneBlock> file;
+		{
+			FILE* fp = std::fopen(path.c_str(), "rb");
+			ASSERT_NE(nullptr, fp);
+
+			std::fseek(fp, 0, SEEK_END);
+			const size_t size = size_t(std::ftell(fp));
+			std::fseek(fp, 0, SEEK_SET);
+
+			file.resize(size / sizeof(SceneBlock) + 1);
+			const bool ok = std::fread(file.data(), 1, size, fp) == size;
+			std::fclose(fp);
+			std::remove(path.c_str());
+
+			ASSERT_TRUE(ok);
+			ASSERT_EQ(nullptr, ValidateSceneHeader(file.data(), size));
+			ASSERT_NE(nullptr, ValidateSceneHeader(file.data(), size, target.hash));
+		}
+
+		std::vector<SceneBlock> converted;
+		bool kept_all = true;
+		ASSERT_EQ(nullptr, ConvertScene(file.data(), target.schema(), converted, kept_all));
+		EXPECT_FALSE(kept_all);
+
+		// the Scene is Refs relative to its own fields, followed by the ranges, the offsets and the components
+		const uint8_t* scene = converted.front().bytes;
+		const uint8_t* offsets = scene + LoadAt<int64_t>(scene);
+		const uint8_t* scene_ranges = scene + 16 + LoadAt<int64_t>(scene + 16);
+
+		ASSERT_EQ(5u, LoadAt<uint64_t>(scene + 8));
+		ASSERT_EQ(2u, LoadAt<uint64_t>(scene + 24));
+		EXPECT_EQ(1u, LoadAt<uint32_t>(scene_ranges));
+		EXPECT_EQ(3u, LoadAt<uint32_t>(scene_ranges + 4));
+		EXPECT_EQ(0u, LoadAt<uint32_t>(scene_ranges + 8));
+		EXPECT_EQ(2u, LoadAt<uint32_t>(scene_ranges + 12));
+
+		const uint8_t* components[5];
+		for (size_t n = 0; n < 5; ++n) {
+			components[n] = offsets + n * 8 + LoadAt<int64_t>(offsets + n * 8);
+			EXPECT_EQ(0u, uintptr_t(components[n]) % 16);
+		}
+
+		const uint8_t* file_begin = file.front().bytes;
+		const uint8_t* file_end = file_begin + file.size() * sizeof(SceneBlock);
+
+		for (uint32_t n = 0; n < 3; ++n) {
+			const uint8_t* item = components[n];
+
+			EXPECT_EQ(double(n) * 100.25, LoadAt<double>(item + 0));
+			EXPECT_EQ(float(n) + 0.5f, LoadAt<float>(item + 8));
+			EXPECT_EQ(-int32_t(n), LoadAt<int32_t>(item + 12));
+			EXPECT_EQ(0.0f, LoadAt<float>(item + 16));
+			EXPECT_EQ(0.0, LoadAt<double>(item + 24));
+
+			// text is still read from the file
+			const uint8_t* text = item + 32 + LoadAt<int64_t>(item + 32);
+			ASSERT_TRUE(text >= file_begin && text < file_end);
+
+			const std::string label = "Item " + std::to_string(n);
+			const SceneString string = LoadAt<SceneString>(text);
+			EXPECT_EQ(label.size(), string.length);
+			EXPECT_EQ(label, std::string(reinterpret_cast<const char*>(text + sizeof(SceneString)), string.length));
+
+			const int64_t owner = LoadAt<int64_t>(item + 40);
+			if (n < 2) {
+				EXPECT_EQ(components[n + 1], item + 40 + owner);
+			} else {
+				EXPECT_EQ(0, owner);
+			}
+
+			// the padding after added, where nothing of the removed member may end up
+			EXPECT_EQ(0u, LoadAt<uint32_t>(item + 20));
+		}
+
+		for (uint32_t n = 0; n < 2; ++n) {
+			const uint8_t* other = components[3 + n];
+
+			EXPECT_EQ(components[2 - n], other + LoadAt<int64_t>(other));
+			EXPECT_EQ(1000u + n, LoadAt<uint64_t>(other + 8));
+		}
+
+		// with Gone in the target nothing is dropped
+		AddTestSchemaType(target, "Gone", 16, {{"x", "i32", nullptr, 0, 4}});
+		ASSERT_EQ(nullptr, ConvertScene(file.data(), target.schema(), converted, kept_all));
+		EXPECT_TRUE(kept_all);
+
+		scene = converted.front().bytes;
+		EXPECT_EQ(7u, LoadAt<uint64_t>(scene + 8));
+		EXPECT_EQ(3u, LoadAt<uint64_t>(scene + 24));
+	}
+
+	// the SIMD paths round differently from the scalar ones where a fused multiply add is used
+	static void ExpectNearFloat(float expected, float actual, size_t n) {
+		EXPECT_NEAR(expected, actual, 1e-5f * (1.0f + std::fabs(expected))) << "point " << n;
+	}
+
+	TEST(VectorMath, TransformPoints) {
+
+		std::mt19937 random(43);
+		std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+
+		for (size_t count : {1u, 2u, 3u, 5u, 7u, 9u, 17u, 33u}) {
+
+			// one past the start as well, so the SIMD loads aren't aligned
+			for (size_t first : {0u, 1u}) {
+
+				std::vector<Vec2> points(count + first);
+				std::vector<float> xs(count + first), ys(count + first);
+
+				for (size_t n = 0; n < points.size(); ++n) {
+					points[n] = {value(random), value(random)};
+					xs[n] = points[n].x;
+					ys[n] = points[n].y;
+				}
+
+				const Vec2 translation = {value(random), value(random)};
+				const Rotation2 rotation = {value(random)};
+				const Vec2 scale = {value(random) * 0.1f, value(random) * 0.1f};
+
+				std::vector<Vec2> out(count);
+				std::vector<float> out_xs(count), out_ys(count);
+				TransformPoints(points.data() + first, count, translation, rotation, scale, out.data());
+				TransformPointLanes(xs.data() + first, ys.data() + first, count, translation, rotation, scale, out_xs.data(), out_ys.data());
+
+				for (size_t n = 0; n < count; ++n) {
+					const Vec2 p = points[first + n];
+
+					// a single point only takes the scalar path
+					Vec2 scalar;
+					TransformPoints(&p, 1, translation, rotation, scale, &scalar);
+					ExpectNearFloat(scalar.x, out[n].x, n);
+					ExpectNearFloat(scalar.y, out[n].y, n);
+
+					float scalar_x, scalar_y;
+					TransformPointLanes(&p.x, &p.y, 1, translation, rotation, scale, &scalar_x, &scalar_y);
+					ExpectNearFloat(scalar_x, out_xs[n], n);
+					ExpectNearFloat(scalar_y, out_ys[n], n);
+
+					// and both are what the position, rotation and scale describe
+					const Vec2 placed = Rotate(p * scale, rotation) + translation;
+					EXPECT_NEAR(placed.x, scalar.x, 1e-3f) << "point " << n;
+					EXPECT_NEAR(placed.y, scalar.y, 1e-3f) << "point " << n;
+				}
+
+				// in place
+				TransformPoints(points.data() + first, count, translation, rotation, scale, points.data() + first);
+				for (size_t n = 0; n < count; ++n) {
+					EXPECT_EQ(out[n].x, points[first + n].x);
+					EXPECT_EQ(out[n].y, points[first + n].y);
+				}
+			}
+		}
+	}
+
+	TEST(VectorMath, RotatePoints) {
+
+		std::mt19937 random(44);
+		std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> angle(-3.2f, 3.2f);
+
+		for (size_t count : {1u, 3u, 5u, 17u}) {
+
+			std::vector<Vec3> points(count);
+			for (Vec3& p : points) {
+				p = {value(random), value(random), value(random), 0.0f};
+			}
+
+			const Quat q = QuatFromEuler(angle(random), angle(random), angle(random));
+
+			std::vector<Vec3> out(count);
+			RotatePoints(points.data(), count, q, out.data());
+
+			for (size_t n = 0; n < count; ++n) {
+
+				// q p q* with the scalar quaternion product
+				const Quat p = {points[n].x, points[n].y, points[n].z, 0.0f};
+				const Quat rotated = q * p * Conjugate(q);
+
+				EXPECT_NEAR(rotated.x, out[n].x, 1e-3f) << "point " << n;
+				EXPECT_NEAR(rotated.y, out[n].y, 1e-3f) << "point " << n;
+				EXPECT_NEAR(rotated.z, out[n].z, 1e-3f) << "point " << n;
+			}
+
+			RotatePoints(points.data(), count, q, points.data());
+			for (size_t n = 0; n < count; ++n) {
+				EXPECT_EQ(out[n].x, points[n].x);
+				EXPECT_EQ(out[n].y, points[n].y);
+				EXPECT_EQ(out[n].z, points[n].z);
+			}
+		}
+	}
+
+	// the values the flattener gives every component, by path and component name
+	using FlatValues = std::unordered_map<std::string, std::vector<std::string>>;
+
+	static Result<FlatValues> FlattenTestScene(const SceneSource& source, id_t scene_id) {
+
+		FlatValues result;
+		std::function<Result<>(const FlatComponent&)> callback = [&](const FlatComponent& c) -> Result<> {
+			std::vector<std::string>& values = result[*c.instancePath + *c.name];
+			for (size_t m = 0; m < source.structures[c.structure].members.size(); ++m) {
+				values.push_back(*c.values[m]);
+			}
+
+			return Ok();
+		};
+
+		SceneFlattener flattener(source, callback);
+		auto res = flattener.flatten(scene_id, "");
+		if (res.failed())
+			return res.error();
+
+		return Ok(std::move(result));
+	}
+
+	// one component type with a property of every kind the links combine
+	static SceneSource FlattenTestSource() {
+
+		SceneSource source;
+
+		CppStructure s;
+		s.id = 1;
+		s.name = "Thing";
+		s.members = {
+			BenchmarkMember(1, "i32", "count", "10"),
+			BenchmarkMember(2, "f32", "speed", "1.5"),
+			BenchmarkMember(3, "point2d", "position", "(1, 2)"),
+			BenchmarkMember(4, "scale2d", "scale", ""),
+			BenchmarkMember(5, "rotation2d", "angle", "90"),
+			BenchmarkMember(6, "text", "label", "default"),
+		};
+
+		source.structures = {s};
+		CalcLayouts(source.structures);
+		source.indexStructures();
+		return source;
+	}
+
+	TEST(SceneFlattener, OverridePrecedence) {
+
+		SceneSource source = FlattenTestSource();
+		const id_t LEAF_ID = 1, MIDDLE_ID = 2, SCENE_ID = 3;
+
+		SceneSource::EntityComponent thing;
+		thing.id = 1;
+		thing.name = "Thing";
+		thing.structure = 0;
+		thing.overrides = {{1, "1"}, {6, "leaf"}};
+		source.entities[LEAF_ID] = {"Leaf", {thing}, {}};
+
+		// the middle entity overrides count in its leaf, the scene overrides it again in one of two middles
+		source.entities[MIDDLE_ID] = {"Middle", {}, {{1, "Leaf", LEAF_ID, {{1, "2"}, {2, "4.5"}}}}};
+		source.entities[SCENE_ID] = {"Scene", {}, {
+			{2, "Outer", MIDDLE_ID, {{1, "3"}}},
+			{3, "Plain", MIDDLE_ID, {}},
+		}};
+
+		auto res = FlattenTestScene(source, SCENE_ID);
+		ASSERT_FALSE(res.failed()) << res.errorMessage();
+		ASSERT_EQ(2u, res->size());
+
+		const std::vector<std::string>& outer = (*res)["Outer/Leaf/Thing"];
+		EXPECT_EQ("3", outer[0]);
+		EXPECT_EQ("4.5", outer[1]); // only count was overridden again, the inner override of speed stays
+		EXPECT_EQ("(1, 2)", outer[2]);
+		EXPECT_EQ("leaf", outer[5]);
+
+		const std::vector<std::string>& plain = (*res)["Plain/Leaf/Thing"];
+		EXPECT_EQ("2", plain[0]);
+		EXPECT_EQ("4.5", plain[1]);
+
+		// the leaf on its own only has its component overrides
+		auto leaf = FlattenTestScene(source, LEAF_ID);
+		ASSERT_FALSE(leaf.failed()) << leaf.errorMessage();
+		EXPECT_EQ("1", (*leaf)["Thing"][0]);
+		EXPECT_EQ("1.5", (*leaf)["Thing"][1]);
+	}
+
+	TEST(SceneFlattener, PropLinks) {
+
+		SceneSource source = FlattenTestSource();
+		const id_t SCENE_ID = 1, CHILD_ID = 2;
+
+		source.entityPropValues = {{1, "5"}, {2, "2.25"}, {3, "(10, 20)"}, {4, "(1, 1)"}, {5, "-30"}, {6, "linked"}, {7, "7"}};
+
+		SceneSource::EntityComponent copied;
+		copied.id = 1;
+		copied.name = "Copied";
+		copied.structure = 0;
+		copied.overrides = {{1, "100"}, {6, "overridden"}};
+		copied.links = {{7, 1, "copy"}, {6, 6, "copy"}};
+
+		// preset only replaces a value that is still the default
+		SceneSource::EntityComponent preset;
+		preset.id = 2;
+		preset.name = "Preset";
+		preset.structure = 0;
+		preset.overrides = {{1, "100"}};
+		preset.links = {{7, 1, "preset"}, {6, 6, "preset"}};
+
+		SceneSource::EntityComponent added;
+		added.id = 3;
+		added.name = "Added";
+		added.structure = 0;
+		added.links = {{1, 1, "add"}, {2, 2, "add"}, {3, 3, "add"}, {4, 4, "add"}, {5, 5, "add"}};
+
+		SceneSource::EntityComponent subtracted;
+		subtracted.id = 4;
+		subtracted.name = "Subtracted";
+		subtracted.structure = 0;
+		subtracted.overrides = {{2, "2"}};
+		subtracted.links = {{1, 1, "subtract"}, {2, 2, "subtract"}, {3, 3, "subtract"}, {5, 5, "subtract"}};
+
+		source.entities[CHILD_ID] = {"Child", {copied, preset, added, subtracted}, {}};
+
+		// a child override still beats a link
+		source.entities[SCENE_ID] = {"Scene", {}, {{1, "Child", CHILD_ID, {{2, "9"}}}}};
+
+		auto res = FlattenTestScene(source, SCENE_ID);
+		ASSERT_FALSE(res.failed()) << res.errorMessage();
+
+		const std::vector<std::string>& c = (*res)["Child/Copied"];
+		EXPECT_EQ("7", c[0]);
+		EXPECT_EQ("linked", c[5]);
+
+		const std::vector<std::string>& p = (*res)["Child/Preset"];
+		EXPECT_EQ("100", p[0]);
+		EXPECT_EQ("linked", p[5]);
+
+		const std::vector<std::string>& a = (*res)["Child/Added"];
+		EXPECT_EQ("15", a[0]);
+		EXPECT_EQ("9", a[1]);
+		EXPECT_EQ("(11, 22)", a[2]);
+		EXPECT_EQ("(2, 2)", a[3]); // an empty scale is (1, 1)
+		EXPECT_EQ("(60)", a[4]);
+
+		const std::vector<std::string>& s = (*res)["Child/Subtracted"];
+		EXPECT_EQ("5", s[0]);
+		EXPECT_EQ("9", s[1]);
+		EXPECT_EQ("(-9, -18)", s[2]);
+		EXPECT_EQ("(120)", s[4]);
+
+		// without the child override, subtracting from an overridden value
+		source.entities[SCENE_ID].children[0].overrides.clear();
+		res = FlattenTestScene(source, SCENE_ID);
+		ASSERT_FALSE(res.failed()) << res.errorMessage();
+		EXPECT_EQ("-0.25", (*res)["Child/Subtracted"][1]);
+		EXPECT_EQ("3.75", (*res)["Child/Added"][1]);
+	}
+
+	TEST(SceneFlattener, Errors) {
+
+		const id_t A_ID = 1, B_ID = 2, C_ID = 3;
+
+		{
+			// a contains b, which contains a
+			SceneSource source = FlattenTestSource();
+			source.entities[A_ID] = {"A", {}, {{1, "B", B_ID, {}}}};
+			source.entities[B_ID] = {"B", {}, {{2, "A", A_ID, {}}}};
+
+			auto res = FlattenTestScene(source, A_ID);
+			ASSERT_TRUE(res.failed());
+			EXPECT_NE(std::string::npos, res.errorMessage().find("contains itself")) << res.errorMessage();
+		}
+
+		{
+			// an entity used twice side by side doesn't contain itself
+			SceneSource source = FlattenTestSource();
+			source.entities[A_ID] = {"A", {}, {{1, "B1", B_ID, {}}, {2, "B2", B_ID, {}}}};
+			source.entities[B_ID] = {"B", {}, {}};
+			EXPECT_FALSE(FlattenTestScene(source, A_ID).failed());
+		}
+
+		SceneSource::EntityComponent thing;
+		thing.id = 1;
+		thing.name = "Thing";
+		thing.structure = 0;
+
+		{
+			SceneSource source = FlattenTestSource();
+			thing.overrides = {{42, "1"}};
+			source.entities[A_ID] = {"A", {thing}, {}};
+
+			auto res = FlattenTestScene(source, A_ID);
+			ASSERT_TRUE(res.failed());
+			EXPECT_NE(std::string::npos, res.errorMessage().find("overrides a property")) << res.errorMessage();
+			thing.overrides.clear();
+		}
+
+		{
+			SceneSource source = FlattenTestSource();
+			thing.links = {{1, 1, "multiply"}};
+			source.entityPropValues[1] = "2";
+			source.entities[A_ID] = {"A", {thing}, {}};
+
+			auto res = FlattenTestScene(source, A_ID);
+			ASSERT_TRUE(res.failed());
+			EXPECT_NE(std::string::npos, res.errorMessage().find("Unknown property link operation")) << res.errorMessage();
+
+			// text can't be added to
+			source.entities[A_ID].components[0].links = {{1, 6, "add"}};
+			EXPECT_TRUE(FlattenTestScene(source, A_ID).failed());
+
+			// nor linked to an entity property that doesn't exist
+			source.entities[A_ID].components[0].links = {{9, 1, "copy"}};
+			EXPECT_TRUE(FlattenTestScene(source, A_ID).failed());
+		}
+
+		{
+			SceneSource source = FlattenTestSource();
+			source.entities[A_ID] = {"A", {}, {{1, "Missing", C_ID, {}}}};
+			EXPECT_TRUE(FlattenTestScene(source, A_ID).failed());
+		}
+	}
+
+	static CppEnum TestEnum(const char* name, const std::vector<CppEnumerator>& enumerators) {
+		CppEnum e;
+		e.id = 1;
+		e.name = name;
+		e.enumerators = enumerators;
+		CalcEnumLayout(e);
+		return e;
+	}
+
+	static std::vector<CppStructure> DoorStructures(const CppEnum& state, const CppEnum& kind) {
+
+		CppStructure door;
+		door.id = 1;
+		door.name = "Door";
+		door.members = {BenchmarkMember(1, "enum", "state", "State::Locked"), BenchmarkMember(2, "enum", "kind", "Kind::B"), BenchmarkMember(3, "f32", "width", "3")};
+		door.members[0].enumeration = state;
+		door.members[1].enumeration = kind;
+
+		std::vector<CppStructure> structures = {door};
+		CalcLayouts(structures);
+		return structures;
+	}
+
+	TEST(SceneSchema, ConvertRenumberedEnum) {
+
+		const CppEnum kind = TestEnum("Kind", {{"A", 0}, {"B", 1}});
+		const std::vector<CppStructure> source_structures = DoorStructures(TestEnum("State", {{"Open", 0}, {"Closed", 1}, {"Locked", 2}}), kind);
+		const std::vector<CppStructure> target_structures = DoorStructures(TestEnum("State", {{"Open", 0}, {"Closed", 2}, {"Locked", 3}}), kind);
+
+		const SceneSchemaTables source = BuildSceneSchema(source_structures);
+		const SceneSchemaTables target = BuildSceneSchema(target_structures);
+		ASSERT_NE(source.hash, target.hash);
+
+		auto defaults = EncodeDefaultComponents(target_structures);
+		ASSERT_FALSE(defaults.failed()) << defaults.errorMessage();
+
+		const CppStructure& door = source_structures[0];
+		const std::string path = ::testing::TempDir() + "sg_convert_enum_test.scene";
+
+		{
+			// a closed door of kind A, neither of them the default
+			std::vector<uint8_t> component(door.size, 0);
+			StoreAt(component.data() + door.members[0].offset, uint8_t(1));
+			StoreAt(component.data() + door.members[1].offset, uint8_t(0));
+			StoreAt(component.data() + door.members[2].offset, 7.0f);
+
+			SceneWriter writer;
+			ASSERT_TRUE(writer.open(path, {{0, 1, uint32_t(door.size)}}, source.schema())) << writer.error();
+			ASSERT_TRUE(writer.writeComponent(0, component.data())) << writer.error();
+			ASSERT_TRUE(writer.finish()) << writer.error();
+		}
+
+		std::vector<SceneBlock> file;
+		{
+			FILE* fp = std::fopen(path.c_str(), "rb");
+			ASSERT_NE(nullptr, fp);
+
+			std::fseek(fp, 0, SEEK_END);
+			const size_t size = size_t(std::ftell(fp));
+			std::fseek(fp, 0, SEEK_SET);
+
+			file.resize(size / sizeof(SceneBlock) + 1);
+			const bool ok = std::fread(file.data(), 1, size, fp) == size;
+			std::fclose(fp);
+			std::remove(path.c_str());
+			ASSERT_TRUE(ok);
+		}
+
+		const void* target_defaults[] = {(*defaults)[0].data()};
+		SceneSchema target_schema = target.schema();
+		target_schema.defaults = target_defaults;
+
+		std::vector<SceneBlock> converted;
+		bool kept_all = false;
+		ASSERT_EQ(nullptr, ConvertScene(file.data(), target_schema, converted, kept_all));
+		EXPECT_TRUE(kept_all);
+
+		const uint8_t* scene = converted.front().bytes;
+		ASSERT_EQ(1u, LoadAt<uint64_t>(scene + 8));
+
+		const uint8_t* offsets = scene + LoadAt<int64_t>(scene);
+		const uint8_t* component = offsets + LoadAt<int64_t>(offsets);
+		const CppStructure& target_door = target_structures[0];
+
+		// the renumbered enum is back at its default, Locked is now 3, the unchanged one keeps its value
+		EXPECT_EQ(3, LoadAt<uint8_t>(component + target_door.members[0].offset));
+		EXPECT_EQ(0, LoadAt<uint8_t>(component + target_door.members[1].offset));
+		EXPECT_EQ(7.0f, LoadAt<float>(component + target_door.members[2].offset));
+
+		// without defaults it is zeroed
+		ASSERT_EQ(nullptr, ConvertScene(file.data(), target.schema(), converted, kept_all));
+		scene = converted.front().bytes;
+		offsets = scene + LoadAt<int64_t>(scene);
+		component = offsets + LoadAt<int64_t>(offsets);
+		EXPECT_EQ(0, LoadAt<uint8_t>(component + target_door.members[0].offset));
+		EXPECT_EQ(0, LoadAt<uint8_t>(component + target_door.members[1].offset));
+	}
+
+	// a compiled test scene read back whole, aligned the way a mapped one is
+	static std::vector<SceneBlock> ReadTestScene(const std::string& path) {
+
+		std::vector<SceneBlock> file;
+
+		FILE* fp = std::fopen(path.c_str(), "rb");
+		if (!fp)
+			return file;
+
+		std::fseek(fp, 0, SEEK_END);
+		const size_t size = size_t(std::ftell(fp));
+		std::fseek(fp, 0, SEEK_SET);
+
+		file.resize(size / sizeof(SceneBlock) + 1);
+		if (std::fread(file.data(), 1, size, fp) != size || ValidateSceneHeader(file.data(), size) != nullptr || !VerifySceneSections(file.data()))
+			file.clear();
+
+		std::fclose(fp);
+		std::remove(path.c_str());
+		return file;
+	}
+
+	// the Scene of a compiled file, its fields are Refs relative to themselves like the generated header's
+	struct TestScene {
+		const uint8_t* file = nullptr;
+		const uint8_t* offsets = nullptr;
+		const uint8_t* ranges = nullptr;
+		uint64_t componentCount = 0;
+		uint64_t rangeCount = 0;
+
+		explicit TestScene(const std::vector<SceneBlock>& data) {
+			file = data.front().bytes;
+			const uint8_t* scene = file + reinterpret_cast<const SceneFileHeader*>(file)->sections[SCENE_SECTION_SCENE].offset;
+			offsets = scene + LoadAt<int64_t>(scene);
+			componentCount = LoadAt<uint64_t>(scene + 8);
+			ranges = scene + 16 + LoadAt<int64_t>(scene + 16);
+			rangeCount = LoadAt<uint64_t>(scene + 24);
+		}
+
+		uint32_t rangeType(uint64_t range) const { return LoadAt<uint32_t>(ranges + range * 8); }
+		uint32_t rangeSize(uint64_t range) const { return LoadAt<uint32_t>(ranges + range * 8 + 4); }
+
+		const uint8_t* component(uint64_t index) const {
+			return offsets + index * 8 + LoadAt<int64_t>(offsets + index * 8);
+		}
+
+		// the index of the component a Ref at p points to, componentCount when it points at none
+		uint64_t target(const uint8_t* p) const {
+			const int64_t ref = LoadAt<int64_t>(p);
+			for (uint64_t n = 0; ref != 0 && n < componentCount; ++n) {
+				if (component(n) == p + ref)
+					return n;
+			}
+
+			return componentCount;
+		}
+
+		std::string text(const uint8_t* p) const {
+			const int64_t ref = LoadAt<int64_t>(p);
+			if (ref == 0)
+				return std::string();
+
+			const uint8_t* string = p + ref;
+			return std::string(reinterpret_cast<const char*>(string + sizeof(SceneString)), LoadAt<SceneString>(string).length);
+		}
+	};
+
+	static size_t MemberOffset(const CppStructure& s, const char* name) {
+		for (const CppMember& m : s.members) {
+			if (m.name == name)
+				return m.offset;
+		}
+
+		ADD_FAILURE() << s.name << " has no member " << name;
+		return 0;
+	}
+
+	TEST(SceneCompiler, ReorderedRanges) {
+
+		// Body is positioned through its nested Transform and has a cold part, Item is ordered by rank, Link is left in
+		// flatten order and refers into both
+		SceneSource source;
+		{
+			CppStructure transform;
+			transform.id = 1;
+			transform.name = "Transform";
+			transform.members = {BenchmarkMember(1, "f32", "x", "0"), BenchmarkMember(2, "f32", "y", "0")};
+
+			CppStructure body;
+			body.id = 2;
+			body.name = "Body";
+			body.members = {BenchmarkMember(3, "component", "transform", "Transform"), BenchmarkMember(4, "f32", "radius", "0.25"), BenchmarkMember(5, "text", "label", ""), BenchmarkMember(6, "f32", "heat", "0")};
+			body.members[3].cold = true;
+
+			CppStructure item;
+			item.id = 3;
+			item.name = "Item";
+			item.members = {BenchmarkMember(7, "i32", "rank", "0"), BenchmarkMember(8, "component_ref", "owner", "Body"), BenchmarkMember(9, "text", "label", "")};
+			item.members[0].sortKey = true;
+
+			CppStructure link;
+			link.id = 4;
+			link.name = "Link";
+			link.members = {BenchmarkMember(10, "component_ref", "item", "Item"), BenchmarkMember(11, "component_ref", "body", "Body")};
+
+			source.structures = {transform, body, item, link};
+			ASSERT_FALSE(SplitColdStructures(source.structures).failed());
+			CalcLayouts(source.structures);
+			source.indexStructures();
+		}
+
+		const id_t GROUP_ID = 1, SCENE_ID = 2;
+
+		// bodies along the diagonal, so their Morton order is their position order, and one that is everywhere
+		const int positions[] = {4, 2, 0, 3, 1};
+		{
+			SceneSource::Entity& group = source.entities[GROUP_ID];
+			group.name = "Group";
+
+			for (int n = 0; n < 6; ++n) {
+				const std::string position = n < 5 ? std::to_string(positions[n]) : "nan";
+				group.components.push_back({id_t(n), "B" + std::to_string(n), 1, {{3, "(" + position + ", " + position + ")"}, {5, "B" + std::to_string(n)}, {6, std::to_string(100 + n)}}, {}});
+			}
+		}
+
+		// items by rank, two have the same rank and keep their flatten order, links before everything they refer to
+		const int ranks[] = {5, 1, 3, 1, 4};
+		{
+			SceneSource::Entity& scene = source.entities[SCENE_ID];
+			scene.name = "Scene";
+
+			scene.components.push_back({10, "L0", 3, {{10, "I0"}, {11, "G/B2"}}, {}});
+			scene.components.push_back({11, "L1", 3, {{10, "I3"}, {11, "G/B5"}}, {}});
+			scene.components.push_back({12, "L2", 3, {{11, "G/B0"}}, {}});
+
+			for (int n = 0; n < 5; ++n) {
+				scene.components.push_back({id_t(20 + n), "I" + std::to_string(n), 2, {{7, std::to_string(ranks[n])}, {8, "G/B" + std::to_string(4 - n)}, {9, "I" + std::to_string(n)}}, {}});
+			}
+
+			scene.children.push_back({1, "G", GROUP_ID, {}});
+		}
+
+		const std::string path = ::testing::TempDir() + "sg_reorder_test.scene";
+		auto res = CompileSceneSource(source, SCENE_ID, path, true, SceneCompileStats());
+		ASSERT_FALSE(res.failed()) << res.errorMessage();
+
+		const std::vector<SceneBlock> file = ReadTestScene(path);
+		ASSERT_FALSE(file.empty());
+
+		const TestScene scene(file);
+		const size_t BODY = 1, ITEM = 2, LINK = 3, BODY_COLD = source.structures[BODY].coldStructure;
+
+		// one range per used structure in TypeId order, the cold parts last
+		ASSERT_EQ(4u, scene.rangeCount);
+		ASSERT_EQ(20u, scene.componentCount);
+		EXPECT_EQ(BODY, scene.rangeType(0));
+		EXPECT_EQ(6u, scene.rangeSize(0));
+		EXPECT_EQ(ITEM, scene.rangeType(1));
+		EXPECT_EQ(5u, scene.rangeSize(1));
+		EXPECT_EQ(LINK, scene.rangeType(2));
+		EXPECT_EQ(3u, scene.rangeSize(2));
+		EXPECT_EQ(BODY_COLD, scene.rangeType(3));
+		EXPECT_EQ(6u, scene.rangeSize(3));
+
+		const CppStructure& body = source.structures[BODY];
+		const CppStructure& item = source.structures[ITEM];
+		const CppStructure& link = source.structures[LINK];
+		const size_t body_x = MemberOffset(body, "transform") + MemberOffset(source.structures[0], "x");
+
+		// bodies by position, the one that is everywhere last, and each cold part at the index of its body
+		const char* body_order[] = {"B2", "B4", "B1", "B3", "B0", "B5"};
+		std::unordered_map<std::string, uint64_t> index_of;
+
+		for (uint64_t n = 0; n < 6; ++n) {
+			const std::string label = scene.text(scene.component(n) + MemberOffset(body, "label"));
+			EXPECT_EQ(body_order[n], label) << n;
+			index_of[label] = n;
+
+			const float heat = LoadAt<float>(scene.component(14 + n) + MemberOffset(source.structures[BODY_COLD], "heat"));
+			EXPECT_EQ(float(100 + std::stoi(label.substr(1))), heat) << n;
+		}
+
+		const char* item_order[] = {"I1", "I3", "I2", "I4", "I0"};
+		for (uint64_t n = 0; n < 5; ++n) {
+			const uint8_t* component = scene.component(6 + n);
+			const std::string label = scene.text(component + MemberOffset(item, "label"));
+			EXPECT_EQ(item_order[n], label) << n;
+			index_of[label] = 6 + n;
+
+			const int flattened = std::stoi(label.substr(1));
+			EXPECT_EQ(ranks[flattened], LoadAt<int32_t>(component + MemberOffset(item, "rank")));
+			EXPECT_EQ(index_of.at("B" + std::to_string(4 - flattened)), scene.target(component + MemberOffset(item, "owner"))) << label;
+		}
+
+		// links aren't reordered, but everything they refer to was
+		const uint8_t* l0 = scene.component(11);
+		const uint8_t* l1 = scene.component(12);
+		const uint8_t* l2 = scene.component(13);
+		EXPECT_EQ(index_of["I0"], scene.target(l0 + MemberOffset(link, "item")));
+		EXPECT_EQ(index_of["B2"], scene.target(l0 + MemberOffset(link, "body")));
+		EXPECT_EQ(index_of["I3"], scene.target(l1 + MemberOffset(link, "item")));
+		EXPECT_EQ(index_of["B5"], scene.target(l1 + MemberOffset(link, "body")));
+		EXPECT_EQ(scene.componentCount, scene.target(l2 + MemberOffset(link, "item")));
+		EXPECT_EQ(index_of["B0"], scene.target(l2 + MemberOffset(link, "body")));
+
+		// every spatial entry is the body at its index, and the names find components where they ended up
+		const SceneSpatialIndex* spatial = FindSceneSpatialIndex(scene.file);
+		ASSERT_NE(nullptr, spatial);
+		ASSERT_EQ(6u, spatial->entryCount);
+
+		std::vector<uint32_t> found;
+		QuerySceneSpatialIndex(*spatial, {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX}, found);
+		std::sort(found.begin(), found.end());
+		EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 3, 4, 5}), found);
+
+		for (uint64_t n = 0; n < 5; ++n) {
+			const float x = LoadAt<float>(scene.component(n) + body_x);
+			EXPECT_EQ(float(n), x);
+
+			found.clear();
+			QuerySceneSpatialIndex(*spatial, {x - 0.1f, x - 0.1f, x + 0.1f, x + 0.1f}, found);
+			std::sort(found.begin(), found.end());
+			EXPECT_EQ(std::vector<uint32_t>({uint32_t(n), 5}), found) << n;
+		}
+
+		const SceneNameTable* names = FindSceneNameTable(scene.file);
+		ASSERT_NE(nullptr, names);
+
+		for (const auto& kv : index_of) {
+			const std::string name = kv.first[0] == 'B' ? "G/" + kv.first : kv.first;
+			EXPECT_EQ(kv.second, LookupSceneName(*names, PathHash(name))) << name;
+		}
+
+		EXPECT_EQ(12u, LookupSceneName(*names, PathHash("L1")));
+	}
+
+	TEST(SceneCompiler, InlineCopies) {
+
+		// Point is positioned, so it is reordered, and Holder keeps a copy of the Point its target refers to
+		SceneSource source;
+		{
+			CppStructure point;
+			point.id = 1;
+			point.name = "Point";
+			point.members = {BenchmarkMember(1, "f32", "x", "0"), BenchmarkMember(2, "f32", "y", "0"), BenchmarkMember(3, "f32", "weight", "5")};
+
+			CppStructure holder;
+			holder.id = 2;
+			holder.name = "Holder";
+			holder.members = {BenchmarkMember(4, "component_ref", "target", "Point"), BenchmarkMember(-1, "component", "targetInline", "Point"), BenchmarkMember(5, "i32", "tag", "0")};
+			holder.members[0].inlineTarget = true;
+			holder.members[1].inlineOf = 0;
+
+			source.structures = {point, holder};
+			CalcLayouts(source.structures);
+			source.indexStructures();
+		}
+
+		const id_t GROUP_ID = 1, SCENE_ID = 2;
+
+		// the group's holder comes before the points it can refer to, and the points are out of position order
+		const int positions[] = {3, 1, 2, 0};
+		{
+			SceneSource::Entity& group = source.entities[GROUP_ID];
+			group.name = "Group";
+			group.components.push_back({0, "H", 1, {{4, "P1"}, {5, "3"}}, {}});
+
+			for (int n = 0; n < 4; ++n) {
+				const std::string position = std::to_string(positions[n]);
+				group.components.push_back({id_t(1 + n), "P" + std::to_string(n), 0, {{1, position}, {2, position}, {3, std::to_string(10 + n)}}, {}});
+			}
+		}
+
+		// every holder of the scene is flattened before the points in its child, the last refers to nothing
+		{
+			SceneSource::Entity& scene = source.entities[SCENE_ID];
+			scene.name = "Scene";
+			scene.components.push_back({10, "H0", 1, {{4, "G/P3"}, {5, "0"}}, {}});
+			scene.components.push_back({11, "H1", 1, {{4, "G/P0"}, {5, "1"}}, {}});
+			scene.components.push_back({12, "H2", 1, {{5, "2"}}, {}});
+			scene.children.push_back({1, "G", GROUP_ID, {}});
+		}
+
+		const std::string path = ::testing::TempDir() + "sg_inline_test.scene";
+		auto res = CompileSceneSource(source, SCENE_ID, path, false, SceneCompileStats());
+		ASSERT_FALSE(res.failed()) << res.errorMessage();
+
+		auto defaults = EncodeDefaultComponents(source.structures);
+		ASSERT_FALSE(defaults.failed()) << defaults.errorMessage();
+
+		const std::vector<SceneBlock> file = ReadTestScene(path);
+		ASSERT_FALSE(file.empty());
+
+		const TestScene scene(file);
+		ASSERT_EQ(2u, scene.rangeCount);
+		ASSERT_EQ(8u, scene.componentCount);
+		EXPECT_EQ(0u, scene.rangeType(0));
+		EXPECT_EQ(1u, scene.rangeType(1));
+
+		const CppStructure& point = source.structures[0];
+		const CppStructure& holder = source.structures[1];
+		const size_t target = MemberOffset(holder, "target"), copy = MemberOffset(holder, "targetInline");
+
+		// the points by position, which isn't the order they were flattened, or held, in
+		const int point_order[] = {3, 1, 2, 0};
+		for (uint64_t n = 0; n < 4; ++n) {
+			EXPECT_EQ(float(n), LoadAt<float>(scene.component(n) + MemberOffset(point, "x")));
+			EXPECT_EQ(float(10 + point_order[n]), LoadAt<float>(scene.component(n) + MemberOffset(point, "weight")));
+		}
+
+		// the holders by tag, each copy is the component its target refers to in the file
+		const uint64_t targets[] = {0, 3, scene.componentCount, 1};
+		for (uint64_t n = 0; n < 4; ++n) {
+			const uint8_t* component = scene.component(4 + n);
+			EXPECT_EQ(int32_t(n), LoadAt<int32_t>(component + MemberOffset(holder, "tag")));
+			ASSERT_EQ(targets[n], scene.target(component + target)) << n;
+
+			const uint8_t* expected = targets[n] < scene.componentCount ? scene.component(targets[n]) : (*defaults)[0].data();
+			EXPECT_EQ(0, std::memcmp(expected, component + copy, point.size)) << n;
+		}
+
+		// a target that isn't a Point can't be copied
+		source.entities[SCENE_ID].components.push_back({13, "H3", 1, {{4, "H0"}}, {}});
+		res = CompileSceneSource(source, SCENE_ID, path, false, SceneCompileStats());
+		ASSERT_TRUE(res.failed());
+		EXPECT_NE(std::string::npos, res.errorMessage().find("is not a Point")) << res.errorMessage();
+		std::remove(path.c_str());
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Result.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sg {
+
+	struct SceneCompileStats {
+		size_t componentCount = 0;
+		size_t byteSize = 0;
+		double querySeconds = 0;
+		double flattenSeconds = 0;
+		double writeSeconds = 0;
+		bool cached = false; // copied from the cache, only byteSize and writeSeconds are set
+	};
+
+	struct MultiSceneCompileStats {
+		std::vector<std::pair<std::string, SceneCompileStats>> scenes; // output path and stats, ordered by scene name
+		size_t threadCount = 0;
+		double querySeconds = 0;
+		double compileSeconds = 0; // wall clock time of every scene
+	};
+
+	// Flattens the entity named scene_name, with all of its child entities instanced and their overrides applied, into
+	// the data the generated ToScene() expects. When cache_dir is set, a scene whose input hasn't changed since it was
+	// last compiled is copied from the cache instead. With names, the scene also gets a table the game can find
+	// components in by their path, see SceneNames.h.
+	Result<SceneCompileStats> CompileScene(const class Transaction& t, const std::string& scene_name, const std::string& output_path, const std::string& cache_dir = "", bool names = false);
+
+	// Compiles every entity that isn't a child of another entity into output_dir/<entity name>.bin. The database is
+	// read once, the scenes are then compiled concurrently from that snapshot on up to thread_count threads. When
+	// pack_path is set, the scenes are also combined into a pack that the game can look each scene up in by name.
+	Result<MultiSceneCompileStats> CompileAllScenes(const class Transaction& t, const std::string& output_dir, const std::string& cache_dir, size_t thread_count, const std::string& pack_path = "", bool names = false);
+
+	// Each structure's component with every property at its default value, encoded the way compiled scenes store it,
+	// empty for structures that can't be compiled. Text and references are left 0, they only exist within a scene.
+	Result<std::vector<std::vector<uint8_t>>> EncodeDefaultComponents(const std::vector<struct CppStructure>& structures);
+
+	// Compiles a generated scene of roughly component_count components without using the database, to measure the
+	// throughput of the compiler itself.
+	Result<SceneCompileStats> BenchmarkSceneCompiler(size_t component_count, const std::string& output_path);
+}
@@ -0,0 +1,324 @@
+#include "ScenePacker.h"
+#include "FormatString.h"
+#include "Hash.h"
+#include "SceneFormat.h"
+#include "SceneWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream> // for std::cout
+#include <unordered_map>
+
+namespace sg {
+
+	static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static Result<std::vector<uint8_t>> ReadSceneFile(const std::string& path) {
+
+		FILE* fp = std::fopen(path.c_str(), "rb");
+		if (!fp)
+			return Error("Unable to open "_sb + path);
+
+		std::fseek(fp, 0, SEEK_END);
+		std::vector<uint8_t> result(size_t(std::ftell(fp)));
+		std::fseek(fp, 0, SEEK_SET);
+
+		const bool ok = std::fread(result.data(), 1, result.size(), fp) == result.size();
+		std::fclose(fp);
+
+		if (!ok)
+			return Error("Unable to read "_sb + path);
+
+		return Ok(std::move(result));
+	}
+
+	/*
+	Finds every text Ref in a scene by walking its components with the layouts of the structures they were compiled
+	from, nested components included.
+	*/
+	class SceneTextVisitor {
+
+		using Callback = std::function<Result<>(uint64_t ref_offset, const char* text, size_t length)>;
+
+		const std::vector<CppStructure>& mStructures;
+		std::unordered_map<std::string, size_t> mStructureNames;
+
+		Result<> visitStructure(std::vector<uint8_t>& scene, const SceneSectionInfo& text, const CppStructure& s, uint64_t offset, const Callback& fn) const {
+
+			for (const CppMember& m : s.members) {
+
+				// visited in the cold part, which has a range of its own
+				if (m.cold)
+					continue;
+
+				const uint64_t member_offset = offset + m.offset;
+
+				if (m.typeName == "text") {
+
+					int64_t ref;
+					std::memcpy(&ref, &scene[member_offset], sizeof(ref));
+
+					if (ref == 0)
+						continue;
+
+					const uint64_t target = member_offset + uint64_t(ref);
+					const uint64_t text_end = text.offset + text.size;
+
+					if (target < text.offset || target > text_end || text_end - target < sizeof(SceneString))
+						return Error(s.name + "::" + m.name + " does not refer to the text section");
+
+					SceneString string;
+					std::memcpy(&string, &scene[target], sizeof(string));
+
+					if (text_end - target < SceneStringSize(string.length) || scene[target + sizeof(SceneString) + string.length] != 0)
+						return Error(s.name + "::" + m.name + " does not refer to a string in the text section");
+
+					auto res = fn(member_offset, reinterpret_cast<const char*>(&scene[target + sizeof(SceneString)]), string.length);
+					if (res.failed())
+						return res;
+
+				} else if (m.typeName == "component") {
+
+					auto nested = mStructureNames.find(m.defaultValue);
+					if (nested == mStructureNames.end())
+						return Error("'"_sb + m.name + "' uses unknown component '" + m.defaultValue + "'");
+
+					auto res = visitStructure(scene, text, mStructures[nested->second], member_offset, fn);
+					if (res.failed())
+						return res;
+				}
+			}
+
+			return Ok();
+		}
+
+	public:
+		SceneTextVisitor(const std::vector<CppStructure>& structures)
+		: mStructures(structures)
+		{
+			for (size_t n = 0; n < structures.size(); ++n) {
+				mStructureNames[structures[n].name] = n;
+			}
+		}
+
+		Result<> visit(std::vector<uint8_t>& scene, const Callback& fn) const {
+
+			const SceneFileHeader& header = *reinterpret_cast<const SceneFileHeader*>(scene.data());
+			const SceneSectionInfo& ranges = header.sections[SCENE_SECTION_RANGES];
+			const SceneSectionInfo& offsets = header.sections[SCENE_SECTION_OFFSETS];
+			const SceneSectionInfo& text = header.sections[SCENE_SECTION_TEXT];
+
+			uint64_t component_index = 0;
+
+			for (uint64_t range_offset = ranges.offset; range_offset < ranges.offset + ranges.size; range_offset += COMPONENT_RANGE_SIZE) {
+
+				uint32_t range[2]; // typeId, count
+				std::memcpy(range, &scene[range_offset], sizeof(range));
+
+				if (range[0] >= mStructures.size())
+					return Error("The scene has a component type that doesn't exist");
+
+				const CppStructure& s = mStructures[range[0]];
+
+				for (uint32_t n = 0; n < range[1]; ++n, ++component_index) {
+
+					const uint64_t entry_offset = offsets.offset + component_index * COMPONENT_OFFSET_SIZE;
+					if (entry_offset + COMPONENT_OFFSET_SIZE > offsets.offset + offsets.size)
+						return Error("The scene has more components than offsets");
+
+					int64_t ref;
+					std::memcpy(&ref, &scene[entry_offset], sizeof(ref));
+
+					const uint64_t component_offset = entry_offset + uint64_t(ref);
+					if (component_offset + s.size > scene.size())
+						return Error("A " + s.name + " component is outside of the scene");
+
+					auto res = visitStructure(scene, text, s, component_offset, fn);
+					if (res.failed())
+						return res;
+				}
+			}
+
+			return Ok();
+		}
+	};
+
+	struct PackedScene {
+		std::string name;
+		std::string path;
+		uint64_t nameHash;
+		uint64_t nameOffset; // into the names section
+		uint64_t offset; // from the start of the pack
+		uint64_t size; // without the text section
+	};
+
+	/*
+	Scenes are read twice, once to pool their text and once to rewrite the text Refs and write them out. Only one scene
+	is in memory at a time, and every section's position is known before anything is written, so the pack is written
+	front to back in one go.
+	*/
+	Result<> WriteScenePack(const std::vector<CppStructure>& structures, const std::vector<ScenePackInput>& scenes, const std::string& pack_path) {
+
+		const uint64_t schema_hash = SchemaHash(structures);
+		const SceneTextVisitor visitor(structures);
+
+		std::vector<PackedScene> packed;
+		std::string names;
+
+		std::unordered_map<std::string, uint64_t> pool_offsets;
+		std::vector<uint8_t> pool;
+		uint64_t text_bytes = 0;
+
+		for (const ScenePackInput& input : scenes) {
+
+			auto scene = ReadSceneFile(input.path);
+			if (scene.failed())
+				return scene.error();
+
+			if (const char* error = ValidateSceneHeader(scene->data(), scene->size(), schema_hash))
+				return Error("Unable to pack "_sb + input.path + ": " + error);
+
+			auto res = visitor.visit(*scene, [&](uint64_t, const char* text, size_t length) -> Result<> {
+				if (!pool_offsets.emplace(std::string(text, length), pool.size()).second)
+					return Ok();
+
+				const size_t offset = pool.size();
+				pool.resize(offset + size_t(SceneStringSize(length)));
+				WriteSceneString(text, length, uint32_t(pool_offsets.size() - 1), &pool[offset]);
+				return Ok();
+			});
+
+			if (res.failed())
+				return Error("Unable to pack "_sb + input.path + ": " + res.errorMessage());
+
+			const SceneFileHeader& header = *reinterpret_cast<const SceneFileHeader*>(scene->data());
+			text_bytes += header.sections[SCENE_SECTION_TEXT].size;
+
+			PackedScene p;
+			p.name = input.name;
+			p.path = input.path;
+			p.nameHash = ScenePackNameHash(input.name.c_str());
+			p.nameOffset = names.size();
+			p.offset = 0;
+			p.size = header.sections[SCENE_SECTION_TEXT].offset;
+			packed.push_back(std::move(p));
+
+			names.append(input.name.c_str(), input.name.size() + 1);
+		}
+
+		std::sort(packed.begin(), packed.end(), [](const PackedScene& a, const PackedScene& b) {
+			return a.nameHash != b.nameHash ? a.nameHash < b.nameHash : a.name < b.name;
+		});
+
+		for (size_t n = 1; n < packed.size(); ++n) {
+			if (packed[n - 1].nameHash == packed[n].nameHash && packed[n - 1].name == packed[n].name)
+				return Error("More than one scene is named '"_sb + packed[n].name + "'");
+		}
+
+		ScenePackHeader header = {};
+		header.magic = SCENE_PACK_MAGIC;
+		header.version = SCENE_PACK_VERSION;
+		header.schemaHash = schema_hash;
+		header.sceneCount = packed.size();
+
+		header.entries.offset = sizeof(ScenePackHeader);
+		header.entries.size = packed.size() * sizeof(ScenePackEntry);
+		header.names.offset = header.entries.offset + header.entries.size;
+		header.names.size = names.size();
+		header.text.offset = AlignUp(header.names.offset + header.names.size, COMPONENT_ALIGNMENT);
+		header.text.size = pool.size();
+
+		uint64_t offset = header.text.offset + header.text.size;
+
+		std::vector<ScenePackEntry> entries;
+		for (PackedScene& p : packed) {
+			p.offset = AlignUp(offset, SCENE_PACK_ALIGNMENT);
+			offset = p.offset + p.size;
+
+			entries.push_back({p.nameHash, header.names.offset + p.nameOffset, p.offset, p.size});
+		}
+
+		header.fileSize = offset;
+		header.entries.checksum = Checksum().bytes(entries.data(), header.entries.size).result();
+		header.names.checksum = Checksum().bytes(names.data(), names.size()).result();
+		header.text.checksum = Checksum().bytes(pool.data(), pool.size()).result();
+		header.headerChecksum = ScenePackHeaderChecksum(header);
+
+		// written next to the pack and moved over it when complete, a running game may have the old pack mapped
+		const std::string temp_path = pack_path + ".tmp";
+
+		FILE* fp = std::fopen(temp_path.c_str(), "wb");
+		if (!fp)
+			return Error("Unable to open "_sb + temp_path + " for writing");
+
+		uint64_t written = 0;
+		bool ok = true;
+
+		auto write = [&](const void* data, uint64_t size) {
+			ok = ok && std::fwrite(data, 1, size_t(size), fp) == size;
+			written += size;
+		};
+
+		auto pad_to = [&](uint64_t target) {
+			static const uint8_t zeros[SCENE_PACK_ALIGNMENT] = {};
+			write(zeros, target - written);
+		};
+
+		write(&header, sizeof(header));
+		write(entries.data(), header.entries.size);
+		write(names.data(), names.size());
+		pad_to(header.text.offset);
+		write(pool.data(), pool.size());
+
+		// packed is sorted by name hash, which is also file order
+		for (const PackedScene& p : packed) {
+
+			auto scene = ReadSceneFile(p.path);
+			if (scene.failed()) {
+				std::fclose(fp);
+				std::remove(temp_path.c_str());
+				return scene.error();
+			}
+
+			// point every text Ref at the pool, relative to where the Ref ends up in the pack
+			auto res = visitor.visit(*scene, [&](uint64_t ref_offset, const char* text, size_t length) -> Result<> {
+				const int64_t ref = int64_t((header.text.offset + pool_offsets.at(std::string(text, length))) - (p.offset + ref_offset));
+				std::memcpy(&(*scene)[ref_offset], &ref, sizeof(ref));
+				return Ok();
+			});
+
+			if (res.failed()) {
+				std::fclose(fp);
+				std::remove(temp_path.c_str());
+				return Error("Unable to pack "_sb + p.path + ": " + res.errorMessage());
+			}
+
+			SceneFileHeader& scene_header = *reinterpret_cast<SceneFileHeader*>(scene->data());
+			scene_header.fileSize = p.size;
+			scene_header.sections[SCENE_SECTION_TEXT].size = 0;
+
+			SceneSectionInfo& components = scene_header.sections[SCENE_SECTION_COMPONENTS];
+			components.checksum = Checksum().bytes(scene->data() + components.offset, components.size).result();
+			scene_header.sections[SCENE_SECTION_TEXT].checksum = Checksum().result();
+			scene_header.headerChecksum = SceneHeaderChecksum(scene_header);
+
+			pad_to(p.offset);
+			write(scene->data(), p.size);
+		}
+
+		ok = std::fclose(fp) == 0 && ok;
+		if (!ok || !ReplaceFile(temp_path, pack_path)) {
+			std::remove(temp_path.c_str());
+			return Error("Unable to write "_sb + pack_path);
+		}
+
+		std::cout << "Packed " << packed.size() << " scenes into " << pack_path << ": " << header.fileSize << " bytes, "
+			<< text_bytes << " bytes of text pooled into " << pool.size() << std::endl;
+
+		return Ok();
+	}
+}
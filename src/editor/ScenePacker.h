@@ -0,0 +1,19 @@
+#pragma once
+
+#include "CodeGenerator.h"
+#include "Result.h"
+#include <string>
+#include <vector>
+
+namespace sg {
+
+	struct ScenePackInput {
+		std::string name; // what the game looks the scene up by
+		std::string path; // a scene compiled by CompileScene or CompileAllScenes
+	};
+
+	// Combines compiled scenes into one pack file, see ScenePackHeader. Text is moved out of every scene into a pool
+	// shared by the whole pack, so a string used by many scenes is stored once. The structures are needed to find the
+	// text inside components, and must be the ones the scenes were compiled with.
+	Result<> WriteScenePack(const std::vector<CppStructure>& structures, const std::vector<ScenePackInput>& scenes, const std::string& pack_path);
+}
@@ -2,6 +2,7 @@
 #include <QCommandLineParser>
 #include <QCommandLineOption>
 #include <QDebug>
+#include <QDir>
 
 #include <gtest/gtest.h>
 
@@ -10,8 +11,12 @@
 #include "Controller.h"
 #include "Connection.h"
 #include "CodeGenerator.h"
+#include "SceneCompiler.h"
 #include "InitialSetup.h"
 
+#include <algorithm>
+#include <thread>
+
 
 
 namespace sg {
@@ -68,6 +73,24 @@ int main(int argc, char** argv)
 	parser.addOption(codegen_header);
 	parser.addOption(codegen_cpp);
 
+	QCommandLineOption compile_scene("compile_scene", "Compile a scene entity to the runtime format (specify entity name)", "scene");
+	QCommandLineOption scene_output("scene_output", "Output path for the compiled scene", "scene.bin", "scene.bin");
+	QCommandLineOption compile_bench("compile_bench", "Measure scene compiler throughput on a generated scene", "component count");
+	QCommandLineOption compile_all_scenes("compile_all_scenes", "Compile every scene entity to the runtime format (specify output directory)", "directory");
+	QCommandLineOption compile_threads("compile_threads", "Number of scenes compiled at once, defaults to the number of cores", "count");
+	QCommandLineOption scene_pack("scene_pack", "With compile_all_scenes, also combine the scenes into one pack file (specify path)", "path");
+	QCommandLineOption scene_cache("scene_cache", "Directory of previously compiled scenes, unchanged scenes are copied from it", "directory");
+	QCommandLineOption scene_names("scene_names", "Add a table to compiled scenes for finding components by path, e.g. Child/Component");
+
+	parser.addOption(compile_scene);
+	parser.addOption(scene_output);
+	parser.addOption(compile_bench);
+	parser.addOption(compile_all_scenes);
+	parser.addOption(compile_threads);
+	parser.addOption(scene_cache);
+	parser.addOption(scene_pack);
+	parser.addOption(scene_names);
+
 
 	QApplication app(argc, argv);
 
@@ -83,6 +106,20 @@ int main(int argc, char** argv)
 		return RUN_ALL_TESTS();
 	}
 
+	if (parser.isSet(compile_bench)) {
+		auto bench_res = BenchmarkSceneCompiler(
+			parser.value(compile_bench).toULongLong(),
+			parser.value(scene_output).toStdString()
+		);
+
+		if (bench_res.failed()) {
+			qCritical() << bench_res.errorMessage().c_str();
+			return -1;
+		}
+
+		return 0;
+	}
+
 	auto res = CreateConnection();
 	if (res.failed()) {
 		MessageBoxCritical(MainWindow::tr("Unable to start SGEdit"), res.errorMessage(), res.errorInfo());
@@ -115,6 +152,59 @@ int main(int argc, char** argv)
 			return -1;
 		}
 
+		if (!parser.isSet(compile_scene) && !parser.isSet(compile_all_scenes))
+			return 0;
+	}
+
+	if (parser.isSet(scene_cache))
+		QDir().mkpath(parser.value(scene_cache));
+
+	if (parser.isSet(compile_scene)) {
+		auto compile_res = CompileScene(
+			controller.createTransaction("Compile Scene"),
+			parser.value(compile_scene).toStdString(),
+			parser.value(scene_output).toStdString(),
+			parser.value(scene_cache).toStdString(),
+			parser.isSet(scene_names)
+		);
+
+		if (compile_res.failed()) {
+			qCritical() << compile_res.errorMessage().c_str();
+			if (!compile_res.errorInfo().empty()) {
+				qCritical() << compile_res.errorInfo().c_str();
+			}
+
+			return -1;
+		}
+
+		return 0;
+	}
+
+	if (parser.isSet(compile_all_scenes)) {
+		const size_t thread_count = parser.isSet(compile_threads)
+			? parser.value(compile_threads).toULongLong()
+			: std::max(1u, std::thread::hardware_concurrency());
+
+		QDir().mkpath(parser.value(compile_all_scenes));
+
+		auto compile_res = CompileAllScenes(
+			controller.createTransaction("Compile Scenes"),
+			parser.value(compile_all_scenes).toStdString(),
+			parser.value(scene_cache).toStdString(),
+			thread_count,
+			parser.value(scene_pack).toStdString(),
+			parser.isSet(scene_names)
+		);
+
+		if (compile_res.failed()) {
+			qCritical() << compile_res.errorMessage().c_str();
+			if (!compile_res.errorInfo().empty()) {
+				qCritical() << compile_res.errorInfo().c_str();
+			}
+
+			return -1;
+		}
+
 		return 0;
 	}
 
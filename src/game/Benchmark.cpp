@@ -0,0 +1,304 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "SceneFormat.h"
+#include "SceneRenderer.h"
+#include "SceneSchema.h"
+#include "SceneWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <SDL.h>
+
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct BenchmarkRange {
+	sg::TypeId typeId;
+	uint32_t count;
+};
+
+static bool ParseMix(const std::string& mix, std::vector<BenchmarkRange>& ranges) {
+
+	size_t start = 0;
+
+	while (start < mix.size()) {
+		size_t end = mix.find(',', start);
+		if (end == std::string::npos)
+			end = mix.size();
+
+		const std::string entry = mix.substr(start, end - start);
+		start = end + 1;
+
+		const size_t equals = entry.find('=');
+		if (equals == std::string::npos) {
+			printf("Expected type=count, not '%s'\n", entry.c_str());
+			return false;
+		}
+
+		const std::string name = entry.substr(0, equals);
+		BenchmarkRange range;
+		range.count = uint32_t(std::strtoul(entry.c_str() + equals + 1, nullptr, 10));
+
+		bool found = false;
+#define X(component_id) if (name == #component_id) { range.typeId = sg::TypeId::component_id; found = true; }
+		SG_COMPONENTS
+#undef X
+
+		if (!found) {
+			printf("There is no component named '%s'\n", name.c_str());
+			return false;
+		}
+
+		if (range.count > 0)
+			ranges.push_back(range);
+	}
+
+	return true;
+}
+
+static const float VIEW_WIDTH = 640.0f;
+static const float VIEW_HEIGHT = 480.0f;
+
+// spread over the world, by default the size of the view so drawing covers about the same area as a real scene
+static float BenchmarkCoordinate(uint32_t index, uint32_t salt, uint32_t limit) {
+	const uint32_t hash = (index ^ salt) * 2654435761u;
+	return float((hash >> 8) % limit);
+}
+
+// types without an overload keep their default values
+template<typename T>
+static void FillComponent(T&, uint32_t, const BenchmarkOptions&) {}
+
+static void FillComponent(sg::Transform& t, uint32_t index, const BenchmarkOptions& options) {
+	t.x = BenchmarkCoordinate(index, 0x1234, std::max(options.worldWidth, 1u));
+	t.y = BenchmarkCoordinate(index, 0x5678, std::max(options.worldHeight, 1u));
+}
+
+static void FillComponent(sg::Circle& c, uint32_t index, const BenchmarkOptions& options) {
+	c.radius = 1.0f + float(index % 16);
+	FillComponent(c.transform, index, options);
+}
+
+static void FillComponent(sg::Rect& r, uint32_t index, const BenchmarkOptions& options) {
+	r.width = 1.0f + float(index % 16);
+	r.height = 1.0f + float((index / 16) % 16);
+	FillComponent(r.transform, index, options);
+}
+
+// only the components the renderer culls go in the spatial index, unlike a compiled scene where every positioned one does
+template<typename T>
+static uint32_t SpatialCount(uint32_t count) {
+	return HasComponentBounds<T>::value ? count : 0;
+}
+
+template<typename T>
+static bool WriteComponents(sg::SceneWriter& writer, size_t range, uint32_t first, uint32_t count, const BenchmarkOptions& options, std::vector<sg::SceneSpatialEntry>& spatial_entries) {
+
+	for (uint32_t n = 0; n < count; ++n) {
+		T component{};
+		FillComponent(component, n, options);
+
+		if (!writer.writeComponent(range, &component))
+			return false;
+
+		if constexpr (HasComponentBounds<T>::value)
+			spatial_entries.push_back({first + n, ComponentBounds(component)});
+	}
+
+	return true;
+}
+
+static bool WriteBenchmarkScene(const BenchmarkOptions& options, const std::vector<BenchmarkRange>& ranges) {
+
+	const std::string& path = options.scenePath;
+	uint64_t spatial_count = 0;
+
+	std::vector<sg::SceneRangeInfo> infos;
+	for (const BenchmarkRange& r : ranges) {
+		sg::SceneRangeInfo info;
+		info.typeId = uint32_t(r.typeId);
+		info.count = r.count;
+
+		switch (r.typeId) {
+#define X(component_id) case sg::TypeId::component_id: info.componentSize = uint32_t(sizeof(sg::component_id)); break;
+			SG_COMPONENTS
+#undef X
+
+			// the cold parts of components aren't benchmarked
+			default:
+				break;
+		}
+
+		switch (r.typeId) {
+#define X(component_id) case sg::TypeId::component_id: spatial_count += SpatialCount<sg::component_id>(r.count); break;
+			SG_COMPONENTS
+#undef X
+
+			default:
+				break;
+		}
+
+		infos.push_back(info);
+	}
+
+	sg::SceneWriter writer;
+	bool ok = writer.open(path, infos, sg::GeneratedSchema(), spatial_count);
+
+	std::vector<sg::SceneSpatialEntry> spatial_entries;
+	spatial_entries.reserve(size_t(spatial_count));
+
+	uint32_t first = 0;
+	for (size_t n = 0; ok && n < ranges.size(); ++n) {
+		switch (ranges[n].typeId) {
+#define X(component_id) case sg::TypeId::component_id:\
+			ok = WriteComponents<sg::component_id>(writer, n, first, ranges[n].count, options, spatial_entries);\
+			break;
+
+			SG_COMPONENTS
+#undef X
+
+			default:
+				break;
+		}
+
+		first += ranges[n].count;
+	}
+
+	if (!ok || (spatial_count != 0 && !writer.writeSpatialIndex(spatial_entries)) || !writer.finish()) {
+		printf("Unable to write '%s': %s\n", path.c_str(), writer.error().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+int RunBenchmark(const BenchmarkOptions& options) {
+
+	std::vector<BenchmarkRange> ranges;
+	if (!ParseMix(options.mix, ranges))
+		return -1;
+
+	uint64_t component_count = 0;
+	uint64_t culled_count = 0;
+	for (const BenchmarkRange& r : ranges) {
+		component_count += r.count;
+
+		switch (r.typeId) {
+#define X(component_id) case sg::TypeId::component_id: culled_count += SpatialCount<sg::component_id>(r.count); break;
+			SG_COMPONENTS
+#undef X
+
+			default:
+				break;
+		}
+	}
+
+	auto start = Clock::now();
+	if (!WriteBenchmarkScene(options, ranges))
+		return -1;
+
+	const double write_seconds = SecondsSince(start);
+
+	// the same steps as SceneLoader, verification included even though release builds skip it
+	start = Clock::now();
+
+	MappedFile file;
+	if (!file.open(options.scenePath.c_str(), MappedFile::Access::Random)) {
+		printf("Error loading '%s'\n", options.scenePath.c_str());
+		return -1;
+	}
+
+	if (const char* reason = sg::ValidateSceneHeader(file.data(), file.size(), sg::SCHEMA_HASH)) {
+		printf("Unable to load '%s': %s\n", options.scenePath.c_str(), reason);
+		return -1;
+	}
+
+	file.prefetch(0, file.size());
+	const double map_seconds = SecondsSince(start);
+
+	start = Clock::now();
+	const bool verified = sg::VerifySceneSections(file.data());
+	const double verify_seconds = SecondsSince(start);
+
+	if (!verified) {
+		printf("Unable to load '%s': the scene is corrupt\n", options.scenePath.c_str());
+		return -1;
+	}
+
+	start = Clock::now();
+	const sg::Scene* scene = sg::ToScene(file.data());
+	const sg::SceneSpatialIndex* spatial = sg::FindSceneSpatialIndex(file.data());
+	const double to_scene_seconds = SecondsSince(start);
+
+	// drawing into a surface needs neither a window nor a video driver
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, int(VIEW_WIDTH), int(VIEW_HEIGHT), 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+
+	if (!renderer) {
+		printf("Unable to create a software renderer: %s\n", SDL_GetError());
+		if (surface)
+			SDL_FreeSurface(surface);
+
+		return -1;
+	}
+
+	RenderBatch batch;
+	JobSystem jobs(options.threads);
+	std::vector<double> frame_seconds;
+	uint64_t visible_count = 0;
+
+	// the view crosses the world diagonally over the frames, staying inside it
+	const float pan_x = std::max(float(options.worldWidth) - VIEW_WIDTH, 0.0f);
+	const float pan_y = std::max(float(options.worldHeight) - VIEW_HEIGHT, 0.0f);
+
+	for (uint32_t frame = 0; frame < options.frames; ++frame) {
+		PROFILE_ZONE("Frame");
+		const auto frame_start = Clock::now();
+
+		const float t = options.frames > 1 ? float(frame) / float(options.frames - 1) : 0.0f;
+		const sg::SceneBounds view = {pan_x * t, pan_y * t, pan_x * t + VIEW_WIDTH, pan_y * t + VIEW_HEIGHT};
+
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+		SDL_RenderClear(renderer);
+		SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+
+		RenderScene(renderer, batch, &jobs, scene, spatial, view);
+
+		SDL_RenderPresent(renderer);
+		frame_seconds.push_back(SecondsSince(frame_start));
+		visible_count += batch.visible.size();
+	}
+
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(surface);
+
+	double render_seconds = 0.0;
+	double worst_frame = 0.0;
+	for (double s : frame_seconds) {
+		render_seconds += s;
+		worst_frame = std::max(worst_frame, s);
+	}
+
+	printf("Scene: %llu components in %u ranges, %llu bytes, written in %gs\n", (unsigned long long)component_count,
+		unsigned(ranges.size()), (unsigned long long)file.size(), write_seconds);
+	printf("Load: mapped and paged in in %gs, verified in %gs, ToScene in %gs\n", map_seconds, verify_seconds, to_scene_seconds);
+
+	if (options.frames > 0) {
+		const double frame_average = render_seconds / double(options.frames);
+		printf("Render: %u frames on %u threads in %gs, %gms per frame (worst %gms), %g components/s\n", options.frames,
+			unsigned(jobs.threadCount()), render_seconds, frame_average * 1000.0, worst_frame * 1000.0, double(component_count) / frame_average);
+		printf("Culling: %llu of %llu culled components visible per frame on average, %s\n", (unsigned long long)(visible_count / options.frames),
+			(unsigned long long)culled_count, spatial ? "through the spatial index" : "tested one by one");
+	}
+
+	return 0;
+}
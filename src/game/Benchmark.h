@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+struct BenchmarkOptions {
+	std::string mix = "Transform=1000000,Rect=100000"; // component type=count, comma separated
+	std::string scenePath = "bench_scene.bin"; // where the generated scene is written
+	uint32_t worldWidth = 640; // components are spread over this area, the view is the size of the default window
+	uint32_t worldHeight = 480;
+	uint32_t frames = 100;
+	uint32_t threads = std::thread::hardware_concurrency(); // for the job system, 1 to run everything on one core
+};
+
+/*
+Measures the runtime without a display or a GPU, so it runs on CI machines. A scene with the requested mix of
+components is generated through SceneWriter, loaded the way SceneLoader loads scenes and drawn for a number of frames by
+the software renderer into an offscreen surface. When the world is larger than the view, the view pans across it so
+culling is measured as well.
+*/
+int RunBenchmark(const BenchmarkOptions& options);
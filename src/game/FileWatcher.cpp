@@ -0,0 +1,130 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <system_error>
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static std::string DirectoryOf(const std::string& path) {
+	const std::string directory = std::filesystem::path(path).parent_path().string();
+	return directory.empty() ? "." : directory;
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher() {
+	mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+}
+
+FileWatcher::~FileWatcher() {
+	if (mInotify >= 0)
+		close(mInotify);
+}
+
+bool FileWatcher::watch(const std::string& path) {
+
+	if (mInotify < 0)
+		return false;
+
+	const std::string directory = DirectoryOf(path);
+
+	// editors and the scene compiler replace files by renaming a finished file over them, which only the directory sees
+	auto itr = mDirectories.find(directory);
+	if (itr == mDirectories.end()) {
+		const int wd = inotify_add_watch(mInotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd < 0)
+			return false;
+
+		itr = mDirectories.emplace(directory, wd).first;
+	}
+
+	WatchedFile file;
+	file.path = path;
+	file.name = std::filesystem::path(path).filename().string();
+	file.directory = itr->second;
+	mFiles.push_back(std::move(file));
+	return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+
+	std::vector<std::string> result;
+
+	if (mInotify < 0)
+		return result;
+
+	alignas(inotify_event) char buffer[4096];
+
+	while (true) {
+		const ssize_t length = read(mInotify, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+
+		for (ssize_t offset = 0; offset < length; ) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if (event->len == 0)
+				continue;
+
+			for (const WatchedFile& file : mFiles) {
+				if (file.directory == event->wd && file.name == event->name && std::find(result.begin(), result.end(), file.path) == result.end())
+					result.push_back(file.path);
+			}
+		}
+	}
+
+	return result;
+}
+
+#else
+
+FileWatcher::FileWatcher() {}
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::watch(const std::string& path) {
+
+	std::error_code error;
+	if (!std::filesystem::is_directory(DirectoryOf(path), error))
+		return false;
+
+	WatchedFile file;
+	file.path = path;
+	file.name = std::filesystem::path(path).filename().string();
+	file.lastWrite = std::filesystem::last_write_time(path, error);
+	mFiles.push_back(std::move(file));
+	return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+
+	std::vector<std::string> result;
+
+	// asking for the time of every file each frame would cost more than the frame, a reload can wait a little
+	const auto now = std::chrono::steady_clock::now();
+	if (now - mLastPoll < std::chrono::milliseconds(250))
+		return result;
+
+	mLastPoll = now;
+
+	for (WatchedFile& file : mFiles) {
+		std::error_code error;
+		const std::filesystem::file_time_type last_write = std::filesystem::last_write_time(file.path, error);
+
+		// a file that is missing is being replaced, it is reported once the new one is there
+		if (!error && last_write != file.lastWrite) {
+			file.lastWrite = last_write;
+
+			if (std::find(result.begin(), result.end(), file.path) == result.end())
+				result.push_back(file.path);
+		}
+	}
+
+	return result;
+}
+
+#endif
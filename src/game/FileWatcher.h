@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+Tells the game when files it uses were replaced or written, so scenes can be reloaded while it runs. Linux is told by
+the kernel through inotify, other platforms compare modification times a few times a second.
+*/
+class FileWatcher {
+
+	struct WatchedFile {
+		std::string path; // as passed to watch()
+		std::string name; // without the directory
+		int directory = -1; // the inotify watch of the directory the file is in
+		std::filesystem::file_time_type lastWrite;
+	};
+
+	std::vector<WatchedFile> mFiles;
+
+#ifdef __linux__
+	int mInotify = -1;
+	std::unordered_map<std::string, int> mDirectories;
+#else
+	std::chrono::steady_clock::time_point mLastPoll;
+#endif
+
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// the file doesn't have to exist yet, the directory it is in does
+	bool watch(const std::string& path);
+
+	// the watched files that changed since the last call, never blocks
+	std::vector<std::string> poll();
+};
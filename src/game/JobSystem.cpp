@@ -0,0 +1,130 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(size_t thread_count) {
+
+	thread_count = std::max<size_t>(thread_count, 1);
+
+	for (size_t n = 0; n < thread_count; ++n) {
+		mQueues.emplace_back(new Queue);
+	}
+
+	for (size_t n = 1; n < thread_count; ++n) {
+		mThreads.emplace_back([this, n]() { run(n); });
+	}
+}
+
+JobSystem::~JobSystem() {
+
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mQuit = true;
+	}
+
+	mWake.notify_all();
+
+	for (std::thread& thread : mThreads) {
+		thread.join();
+	}
+}
+
+bool JobSystem::pop(size_t worker, Job& job) {
+
+	Queue& queue = *mQueues[worker];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.jobs.empty())
+		return false;
+
+	job = queue.jobs.back();
+	queue.jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::steal(size_t worker, Job& job) {
+
+	// start with the next worker so thieves spread out instead of all hitting the first queue
+	for (size_t n = 1; n < mQueues.size(); ++n) {
+		Queue& queue = *mQueues[(worker + n) % mQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.jobs.empty()) {
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::runOne(size_t worker) {
+
+	Job job;
+	if (!pop(worker, job) && !steal(worker, job))
+		return false;
+
+	--mQueued;
+
+	{
+		PROFILE_ZONE("Job");
+		(*job.body)(job.begin, job.end);
+	}
+
+	job.remaining->fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void JobSystem::run(size_t worker) {
+
+	while (true) {
+		if (runOne(worker))
+			continue;
+
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWake.wait(lock, [this]() { return mQuit || mQueued.load() > 0; });
+
+		if (mQuit)
+			return;
+	}
+}
+
+void JobSystem::parallelFor(size_t count, const Body& body) {
+
+	if (count == 0)
+		return;
+
+	// a few chunks per worker, so the load evens out when some chunks are slower than others
+	size_t chunk = std::max(MIN_CHUNK, (count + mQueues.size() * 4 - 1) / (mQueues.size() * 4));
+	chunk = (chunk + CHUNK_ALIGNMENT - 1) / CHUNK_ALIGNMENT * CHUNK_ALIGNMENT;
+
+	const size_t chunk_count = (count + chunk - 1) / chunk;
+
+	if (chunk_count == 1 || mQueues.size() == 1) {
+		body(0, count);
+		return;
+	}
+
+	std::atomic<size_t> remaining(chunk_count);
+
+	// dealt out round robin, each worker starts with its own share and only steals once that is gone
+	for (size_t n = 0; n < chunk_count; ++n) {
+		Queue& queue = *mQueues[n % mQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back({&body, n * chunk, std::min(count, (n + 1) * chunk), &remaining});
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mQueued += chunk_count;
+	}
+
+	mWake.notify_all();
+
+	while (remaining.load(std::memory_order_acquire) > 0) {
+		if (!runOne(0))
+			std::this_thread::yield();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Splits loops over components across every core. Each worker owns a deque of jobs. It takes work from the back of its
+own deque, and when that is empty it steals from the front of another worker's, so a core that finishes early takes
+over the work a busy core hasn't started yet. The thread that starts a loop is one of the workers and helps until the
+loop is done, so a loop returns with every iteration finished.
+*/
+class JobSystem {
+
+	using Body = std::function<void(size_t begin, size_t end)>;
+
+	struct Job {
+		const Body* body;
+		size_t begin;
+		size_t end;
+		std::atomic<size_t>* remaining;
+	};
+
+	// a worker's deque, on its own cache line so workers don't slow each other down
+	struct alignas(64) Queue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<Queue>> mQueues; // mQueues[0] belongs to the thread calling parallelFor
+	std::vector<std::thread> mThreads;
+
+	std::mutex mWakeMutex;
+	std::condition_variable mWake;
+	std::atomic<size_t> mQueued{0};
+	bool mQuit = false;
+
+	bool pop(size_t worker, Job& job);
+	bool steal(size_t worker, Job& job);
+	bool runOne(size_t worker);
+	void run(size_t worker);
+
+public:
+	// iterations per chunk are a multiple of this, so chunks of 16 byte or larger elements start on a cache line
+	static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+	// smaller loops aren't worth waking other cores for
+	static constexpr size_t MIN_CHUNK = 1024;
+
+	// thread_count includes the calling thread, 1 runs everything on it
+	explicit JobSystem(size_t thread_count);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	size_t threadCount() const { return mQueues.size(); }
+
+	// calls body for chunks of [0, count) on every worker and returns once all of them are done, must only be called
+	// from the thread that created the job system
+	void parallelFor(size_t count, const Body& body);
+};
@@ -0,0 +1,147 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+void MappedFile::prefetch(size_t offset, size_t size) const {
+
+	// 4 KiB is the smallest page size of any platform we run on, touching a large page more than once is harmless
+	const size_t STRIDE = 4096;
+	const size_t end = std::min(offset + size, mSize);
+
+	volatile uint8_t sink = 0;
+	for (size_t n = offset; n < end; n += STRIDE) {
+		sink = sink + mData[n];
+	}
+
+	if (offset < end)
+		sink = sink + mData[end - 1];
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path, Access) {
+
+	close();
+
+	mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE) {
+		mFile = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0) {
+		close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMapping) {
+		close();
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!mData) {
+		close();
+		return false;
+	}
+
+	mSize = size_t(size.QuadPart);
+	return true;
+}
+
+void MappedFile::close() {
+
+	if (mData)
+		UnmapViewOfFile(mData);
+
+	if (mMapping)
+		CloseHandle(mMapping);
+
+	if (mFile)
+		CloseHandle(mFile);
+
+	mData = nullptr;
+	mSize = 0;
+	mMapping = nullptr;
+	mFile = nullptr;
+}
+
+// Windows has no equivalent of madvise for file mappings, it reads ahead on its own
+void MappedFile::advise(size_t, size_t, Access) {}
+
+#else
+
+static int AdviceFor(MappedFile::Access access) {
+
+	switch (access) {
+		case MappedFile::Access::Sequential: return MADV_SEQUENTIAL;
+		case MappedFile::Access::Random: return MADV_RANDOM;
+		case MappedFile::Access::WillNeed: return MADV_WILLNEED;
+	}
+
+	return MADV_NORMAL;
+}
+
+bool MappedFile::open(const char* path, Access access) {
+
+	close();
+
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+	// the mapping keeps the file open
+	::close(fd);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	mData = static_cast<const uint8_t*>(data);
+	mSize = size_t(st.st_size);
+
+	advise(0, mSize, access);
+	return true;
+}
+
+void MappedFile::close() {
+
+	if (mData)
+		munmap(const_cast<uint8_t*>(mData), mSize);
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+void MappedFile::advise(size_t offset, size_t size, Access access) {
+
+	// madvise needs a page aligned address, widen the range to whole pages
+	const size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+	const size_t start = offset & ~(page_size - 1);
+
+	if (start >= mSize)
+		return;
+
+	madvise(const_cast<uint8_t*>(mData) + start, std::min(offset + size, mSize) - start, AdviceFor(access));
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+A read only view of a whole file. Pages are read from disk the first time they are touched and are shared with every
+other process mapping the same file.
+*/
+class MappedFile {
+
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+
+#ifdef _WIN32
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#endif
+
+public:
+	// how the mapping will be read, passed on to the OS so it can read ahead or not
+	enum class Access {
+		Sequential,
+		Random,
+		WillNeed, // start reading the whole file in the background now
+	};
+
+	MappedFile() {}
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* path, Access access);
+	void close();
+
+	// changes the access hint for part of the file, e.g. random access to components after reading the tables
+	void advise(size_t offset, size_t size, Access access);
+
+	// reads every page of a range, so nothing is left to fault in from disk when it is used
+	void prefetch(size_t offset, size_t size) const;
+
+	const uint8_t* data() const { return mData; }
+	size_t size() const { return mSize; }
+};
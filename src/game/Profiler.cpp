@@ -0,0 +1,249 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Profiler::sEnabled(false);
+
+namespace {
+
+	/*
+	Durations in nanoseconds, with eight buckets per power of two so a percentile is within 12.5% of the real value.
+	Values below 16ns get a bucket each.
+	*/
+	class Histogram {
+
+		static const int SUB_BUCKET_BITS = 3;
+		static const int LINEAR_BUCKETS = 16;
+		static const int BUCKET_COUNT = LINEAR_BUCKETS + (64 - 4) * (1 << SUB_BUCKET_BITS);
+
+		uint64_t mCounts[BUCKET_COUNT] = {};
+		uint64_t mCount = 0;
+		uint64_t mTotal = 0;
+		uint64_t mMax = 0;
+
+		static int Bucket(uint64_t value) {
+			if (value < LINEAR_BUCKETS)
+				return int(value);
+
+			int exponent = 63;
+			while (!(value >> exponent))
+				--exponent;
+
+			const int sub_bucket = int(value >> (exponent - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+			return LINEAR_BUCKETS + (exponent - 4) * (1 << SUB_BUCKET_BITS) + sub_bucket;
+		}
+
+		// the largest value that falls into a bucket
+		static uint64_t BucketLimit(int bucket) {
+			if (bucket < LINEAR_BUCKETS)
+				return uint64_t(bucket);
+
+			const int exponent = (bucket - LINEAR_BUCKETS) / (1 << SUB_BUCKET_BITS) + 4;
+			const uint64_t sub_bucket = uint64_t((bucket - LINEAR_BUCKETS) % (1 << SUB_BUCKET_BITS));
+			return (uint64_t(1) << exponent) + ((sub_bucket + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+		}
+
+	public:
+		void add(uint64_t value) {
+			++mCounts[Bucket(value)];
+			++mCount;
+			mTotal += value;
+			mMax = std::max(mMax, value);
+		}
+
+		void add(const Histogram& other) {
+			for (int n = 0; n < BUCKET_COUNT; ++n) {
+				mCounts[n] += other.mCounts[n];
+			}
+
+			mCount += other.mCount;
+			mTotal += other.mTotal;
+			mMax = std::max(mMax, other.mMax);
+		}
+
+		uint64_t percentile(double p) const {
+			const uint64_t rank = uint64_t(p * double(mCount - 1));
+			uint64_t seen = 0;
+
+			for (int n = 0; n < BUCKET_COUNT; ++n) {
+				seen += mCounts[n];
+				if (seen > rank)
+					return std::min(BucketLimit(n), mMax);
+			}
+
+			return mMax;
+		}
+
+		uint64_t count() const { return mCount; }
+		uint64_t total() const { return mTotal; }
+		uint64_t max() const { return mMax; }
+	};
+
+	struct TraceEvent {
+		uint32_t zone;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	// everything one thread records, only locked against reports and traces so it is never contended
+	struct ThreadData {
+		std::mutex mutex;
+		uint32_t threadId = 0;
+		std::vector<std::unique_ptr<Histogram>> histograms; // by zone id
+		std::vector<TraceEvent> events; // a ring of the last TRACE_EVENTS zones
+		size_t nextEvent = 0;
+	};
+
+	struct Registry {
+		std::mutex mutex;
+		std::vector<const char*> zoneNames;
+		std::vector<std::unique_ptr<ThreadData>> threads; // kept after a thread exits so its zones are still reported
+		std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	};
+
+	Registry& GetRegistry() {
+		static Registry registry;
+		return registry;
+	}
+
+	ThreadData& GetThreadData() {
+
+		thread_local ThreadData* data = nullptr;
+
+		if (!data) {
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			registry.threads.emplace_back(new ThreadData);
+			data = registry.threads.back().get();
+			data->threadId = uint32_t(registry.threads.size());
+		}
+
+		return *data;
+	}
+
+	void WriteJsonString(FILE* fp, const char* text) {
+		std::fputc('"', fp);
+
+		for (const char* c = text; *c; ++c) {
+			if (*c == '"' || *c == '\\')
+				std::fputc('\\', fp);
+
+			std::fputc(*c, fp);
+		}
+
+		std::fputc('"', fp);
+	}
+}
+
+void Profiler::setEnabled(bool enabled) {
+	GetRegistry(); // starts the clock
+	sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint32_t Profiler::zoneId(const char* name) {
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	for (size_t n = 0; n < registry.zoneNames.size(); ++n) {
+		if (std::string(registry.zoneNames[n]) == name)
+			return uint32_t(n);
+	}
+
+	registry.zoneNames.push_back(name);
+	return uint32_t(registry.zoneNames.size() - 1);
+}
+
+uint64_t Profiler::now() {
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetRegistry().epoch).count());
+}
+
+void Profiler::record(uint32_t zone, uint64_t start, uint64_t end) {
+
+	ThreadData& data = GetThreadData();
+	std::lock_guard<std::mutex> lock(data.mutex);
+
+	if (zone >= data.histograms.size())
+		data.histograms.resize(zone + 1);
+
+	if (!data.histograms[zone])
+		data.histograms[zone].reset(new Histogram);
+
+	data.histograms[zone]->add(end - start);
+
+	if (data.events.size() < TRACE_EVENTS) {
+		data.events.push_back({zone, start, end});
+	} else {
+		data.events[data.nextEvent] = {zone, start, end};
+		data.nextEvent = (data.nextEvent + 1) % TRACE_EVENTS;
+	}
+}
+
+void Profiler::printReport() {
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::vector<Histogram> zones(registry.zoneNames.size());
+
+	for (const auto& thread : registry.threads) {
+		std::lock_guard<std::mutex> thread_lock(thread->mutex);
+
+		for (size_t zone = 0; zone < thread->histograms.size(); ++zone) {
+			if (thread->histograms[zone]) {
+				zones[zone].add(*thread->histograms[zone]);
+				*thread->histograms[zone] = Histogram();
+			}
+		}
+	}
+
+	printf("%-32s %10s %10s %10s %10s %10s\n", "Zone", "Count", "Mean us", "p50 us", "p99 us", "Max us");
+
+	for (size_t zone = 0; zone < zones.size(); ++zone) {
+		const Histogram& h = zones[zone];
+		if (h.count() == 0)
+			continue;
+
+		printf("%-32s %10llu %10.1f %10.1f %10.1f %10.1f\n", registry.zoneNames[zone], (unsigned long long)h.count(),
+			double(h.total()) / double(h.count()) / 1000.0, double(h.percentile(0.5)) / 1000.0,
+			double(h.percentile(0.99)) / 1000.0, double(h.max()) / 1000.0);
+	}
+}
+
+bool Profiler::writeTrace(const std::string& path) {
+
+	FILE* fp = std::fopen(path.c_str(), "wb");
+	if (!fp)
+		return false;
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::fputs("{\"traceEvents\":[\n", fp);
+	bool first = true;
+
+	for (const auto& thread : registry.threads) {
+		std::lock_guard<std::mutex> thread_lock(thread->mutex);
+
+		// oldest first, once the ring has wrapped that is the next event to be overwritten
+		for (size_t n = 0; n < thread->events.size(); ++n) {
+			const TraceEvent& event = thread->events[(thread->nextEvent + n) % thread->events.size()];
+
+			std::fputs(first ? "{\"name\":" : ",\n{\"name\":", fp);
+			WriteJsonString(fp, registry.zoneNames[event.zone]);
+			std::fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread->threadId,
+				double(event.start) / 1000.0, double(event.end - event.start) / 1000.0);
+
+			first = false;
+		}
+	}
+
+	std::fputs("\n]}\n", fp);
+	return std::fclose(fp) == 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+Times scoped zones on any thread. Each zone keeps a histogram of its durations for percentiles. Each thread keeps its
+most recent zones, so after a spike the last few seconds can be written out as a Chrome trace (chrome://tracing or
+Perfetto). While the profiler is disabled a zone costs one relaxed load, so zones stay in release builds.
+
+	void Update() {
+		PROFILE_ZONE("Update");
+		...
+	}
+*/
+class Profiler {
+
+	static std::atomic<bool> sEnabled;
+
+public:
+	// the most recent zones kept for the trace, per thread
+	static const size_t TRACE_EVENTS = 256 * 1024;
+
+	static void setEnabled(bool enabled);
+	static bool enabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+	// the id of a zone name, the same name always gets the same id, name must outlive the profiler
+	static uint32_t zoneId(const char* name);
+
+	// nanoseconds since the profiler was first used
+	static uint64_t now();
+
+	static void record(uint32_t zone, uint64_t start, uint64_t end);
+
+	// prints count, mean, p50, p99 and the maximum of every zone recorded since the last report, then starts over
+	static void printReport();
+
+	// writes the zones kept for the trace as Chrome trace event JSON
+	static bool writeTrace(const std::string& path);
+};
+
+class ProfileZone {
+
+	uint32_t mZone;
+	uint64_t mStart;
+
+public:
+	explicit ProfileZone(uint32_t zone)
+	: mZone(zone)
+	, mStart(Profiler::enabled() ? Profiler::now() : ~uint64_t(0))
+	{}
+
+	~ProfileZone() {
+		if (mStart != ~uint64_t(0))
+			Profiler::record(mZone, mStart, Profiler::now());
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// times the rest of the enclosing scope, name must be a string literal
+#define PROFILE_ZONE(name)\
+	static const uint32_t PROFILE_CONCAT(profile_zone_id_, __LINE__) = Profiler::zoneId(name);\
+	ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(PROFILE_CONCAT(profile_zone_id_, __LINE__))
@@ -0,0 +1,287 @@
+#include "SceneLoader.h"
+#include "Profiler.h"
+
+SceneLoader::SceneLoader() {
+	mThread = std::thread([this]() { run(); });
+}
+
+SceneLoader::~SceneLoader() {
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+
+	mWake.notify_one();
+	mThread.join();
+}
+
+void SceneLoader::request(Request request) {
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRequests.push_back(std::move(request));
+	}
+
+	++mRequested;
+	mWake.notify_one();
+}
+
+void SceneLoader::load(const std::string& path) {
+
+	Request r;
+	r.path = path;
+	request(std::move(r));
+}
+
+void SceneLoader::reload() {
+
+	if (!mCurrent)
+		return;
+
+	Request r;
+	r.path = mCurrent->path;
+	r.reload = true;
+	r.previous = mCurrent->checksums;
+	request(std::move(r));
+}
+
+bool SceneLoader::update(std::string& error) {
+
+	// a frame never waits for the worker, if it holds the lock the swap happens next frame
+	std::unique_lock<std::mutex> lock(mMutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return false;
+
+	mCompletedSeen = mCompleted;
+
+	if (!mError.empty()) {
+		error = std::move(mError);
+		mError.clear();
+	}
+
+	if (!mReady)
+		return false;
+
+	if (mCurrent)
+		mRetired.push_back(std::move(mCurrent));
+
+	mCurrent = std::move(mReady);
+
+	lock.unlock();
+	mWake.notify_one();
+
+	return true;
+}
+
+const std::string& SceneLoader::scenePath() const {
+	static const std::string NONE;
+	return mCurrent ? mCurrent->path : NONE;
+}
+
+std::string SceneLoader::FilePath(const std::string& scene_path) {
+	return scene_path.substr(0, scene_path.rfind('#'));
+}
+
+std::shared_ptr<MappedFile> SceneLoader::openPack(const std::string& path, bool reload, std::string& error) {
+
+	// scenes still using the old mapping keep it alive until they are retired
+	if (reload)
+		mPacks.erase(path);
+
+	auto itr = mPacks.find(path);
+	if (itr != mPacks.end())
+		return itr->second;
+
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+
+	if (!file->open(path.c_str(), MappedFile::Access::Random)) {
+		error = "Error loading '" + path + "'";
+		return nullptr;
+	}
+
+	if (const char* reason = sg::ValidateScenePackHeader(file->data(), file->size())) {
+		error = "Unable to load '" + path + "': " + reason;
+		return nullptr;
+	}
+
+	// the table of contents and the text are shared by every scene in the pack
+	const sg::ScenePackHeader* header = reinterpret_cast<const sg::ScenePackHeader*>(file->data());
+	file->prefetch(0, header->text.offset + header->text.size);
+
+	mPacks[path] = file;
+	return file;
+}
+
+std::unique_ptr<SceneLoader::LoadedScene> SceneLoader::loadScene(const Request& request, std::string& error) {
+
+	PROFILE_ZONE("Load scene");
+
+	const std::string& path = request.path;
+
+	std::unique_ptr<LoadedScene> result(new LoadedScene);
+	result->path = path;
+
+	// where the scene is inside of the file
+	size_t offset = 0;
+	size_t size = 0;
+
+	const size_t pack_separator = path.rfind('#');
+
+	if (pack_separator != std::string::npos) {
+
+		const std::string pack_path = path.substr(0, pack_separator);
+		const std::string name = path.substr(pack_separator + 1);
+
+		result->file = openPack(pack_path, request.reload, error);
+		if (!result->file)
+			return nullptr;
+
+		const sg::ScenePackEntry* entry = sg::FindPackedScene(result->file->data(), name.c_str());
+		if (!entry) {
+			error = "Unable to load '" + path + "': the pack has no scene named '" + name + "'";
+			return nullptr;
+		}
+
+		offset = size_t(entry->offset);
+		size = size_t(entry->size);
+
+		result->checksums.packText = reinterpret_cast<const sg::ScenePackHeader*>(result->file->data())->text.checksum;
+
+	} else {
+
+		result->file = std::make_shared<MappedFile>();
+
+		if (!result->file->open(path.c_str(), MappedFile::Access::Random)) {
+			error = "Error loading '" + path + "'";
+			return nullptr;
+		}
+
+		size = result->file->size();
+	}
+
+	const uint8_t* data = result->file->data() + offset;
+
+	if (const char* reason = sg::ValidateSceneHeader(data, size)) {
+		error = "Unable to load '" + path + "': " + reason;
+		return nullptr;
+	}
+
+	const sg::SceneFileHeader* header = reinterpret_cast<const sg::SceneFileHeader*>(data);
+
+	bool changed = !request.reload || result->checksums.packText != request.previous.packText;
+
+	for (size_t n = 0; n < sg::SCENE_SECTION_COUNT; ++n) {
+
+		const sg::SceneSectionInfo& section = header->sections[n];
+		result->checksums.sections[n] = section.checksum;
+
+		// a section that matches the scene being replaced was checked when that scene loaded
+		if (request.reload && section.checksum == request.previous.sections[n])
+			continue;
+
+		changed = true;
+
+#ifndef NDEBUG
+		// reads the whole section, so only debug builds pay for catching corruption before it turns into bad pointers
+		if (!sg::VerifySceneSection(data, n)) {
+			error = "Unable to load '" + path + "': the scene is corrupt";
+			return nullptr;
+		}
+#endif
+
+		// only the tables and components the first frame walks, the spatial index, names, schema and text are faulted in
+		// by whatever reads them, so a section nothing uses never comes off the disk
+		if (n <= sg::SCENE_SECTION_COMPONENTS)
+			result->file->prefetch(offset + section.offset, section.size);
+	}
+
+	// saving a file without changing it, e.g. a scene copied from the compiler cache, shouldn't cause a hitch
+	if (!changed)
+		return nullptr;
+
+	// the tables are read front to back every frame, components are reached through them
+	const sg::SceneSectionInfo& first = header->sections[sg::SCENE_SECTION_SCENE];
+	const sg::SceneSectionInfo& last = header->sections[sg::SCENE_SECTION_OFFSETS];
+	result->file->advise(offset + first.offset, last.offset + last.size - first.offset, MappedFile::Access::Sequential);
+
+	if (header->schemaHash == sg::SCHEMA_HASH) {
+		result->scene = sg::ToScene(data);
+		result->spatial = sg::FindSceneSpatialIndex(data);
+		result->names = sg::FindSceneNameTable(data);
+	} else {
+		// compiled before the components last changed, rebuilt with the current layouts instead of refusing it
+		bool kept_all = false;
+		if (const char* reason = sg::ConvertScene(data, sg::GeneratedSchema(), result->converted, kept_all)) {
+			error = "Unable to load '" + path + "': " + reason;
+			return nullptr;
+		}
+
+		result->scene = reinterpret_cast<const sg::Scene*>(result->converted.data());
+
+		// the index and the names refer to components by their position in the scene, which only holds when none were dropped
+		result->spatial = kept_all ? sg::FindSceneSpatialIndex(data) : nullptr;
+		result->names = kept_all ? sg::FindSceneNameTable(data) : nullptr;
+	}
+
+#ifndef NDEBUG
+	// systems read the copies instead of the components they were copied from, so a stale copy is a silent bug
+	if (!sg::InlineCopiesMatch(result->scene)) {
+		error = "Unable to load '" + path + "': an inline copy doesn't match the component it was copied from, recompile it";
+		return nullptr;
+	}
+#endif
+
+	return result;
+}
+
+void SceneLoader::run() {
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while (true) {
+		mWake.wait(lock, [this]() { return mQuit || !mRequests.empty() || !mRetired.empty(); });
+
+		if (mQuit)
+			return;
+
+		// unmapping can take a while for large scenes, keep it off the main thread
+		std::vector<std::unique_ptr<LoadedScene>> retired = std::move(mRetired);
+		mRetired.clear();
+
+		// only the latest request matters, anything before it would be replaced straight away
+		Request request;
+		const size_t request_count = mRequests.size();
+		if (request_count > 0) {
+			request = std::move(mRequests.back());
+			mRequests.clear();
+		}
+
+		lock.unlock();
+
+		if (!retired.empty()) {
+			PROFILE_ZONE("Unload scenes");
+			retired.clear();
+		}
+
+		std::string error;
+		std::unique_ptr<LoadedScene> loaded;
+		if (request_count > 0)
+			loaded = loadScene(request, error);
+
+		lock.lock();
+
+		if (loaded) {
+			// a scene that was never swapped in is replaced by the newer one
+			if (mReady)
+				mRetired.push_back(std::move(mReady));
+
+			mReady = std::move(loaded);
+		}
+
+		if (!error.empty())
+			mError = std::move(error);
+
+		mCompleted += request_count;
+	}
+}
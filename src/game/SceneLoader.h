@@ -0,0 +1,105 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+#include "SceneFormat.h"
+#include "SceneNames.h"
+#include "SceneSchema.h"
+#include "SceneSpatial.h"
+#include "SgCodeGen.h"
+
+/*
+Loads scenes on a worker thread while the current scene keeps rendering. The worker maps, validates and pages in the
+whole scene, so once a scene is handed over it can be used without touching the disk. The main thread only ever swaps a
+pointer, and never waits on the worker to do it. Replaced scenes are unmapped by the worker as well.
+*/
+class SceneLoader {
+
+	// what a scene was loaded from, a reload compares it to the new file to see what changed
+	struct SceneChecksums {
+		uint64_t sections[sg::SCENE_SECTION_COUNT] = {};
+		uint64_t packText = 0; // text of a packed scene lives in the pack
+	};
+
+	struct LoadedScene {
+		std::string path;
+		std::shared_ptr<MappedFile> file; // shared by every scene from the same pack
+		const sg::Scene* scene = nullptr;
+		const sg::SceneSpatialIndex* spatial = nullptr; // in the same file as the scene
+		const sg::SceneNameTable* names = nullptr; // likewise
+		std::vector<sg::SceneBlock> converted; // holds the scene when it was compiled for other components
+		SceneChecksums checksums;
+	};
+
+	struct Request {
+		std::string path;
+		bool reload = false;
+		SceneChecksums previous; // only set for reloads
+	};
+
+	std::thread mThread;
+	std::mutex mMutex;
+	std::condition_variable mWake;
+
+	// shared with the worker, guarded by mMutex
+	bool mQuit = false;
+	std::vector<Request> mRequests;
+	std::unique_ptr<LoadedScene> mReady;
+	std::vector<std::unique_ptr<LoadedScene>> mRetired;
+	std::string mError;
+	size_t mCompleted = 0;
+
+	// worker only, packs stay mapped once opened
+	std::unordered_map<std::string, std::shared_ptr<MappedFile>> mPacks;
+
+	// main thread only
+	std::unique_ptr<LoadedScene> mCurrent;
+	size_t mRequested = 0;
+	size_t mCompletedSeen = 0;
+
+	void run();
+	std::unique_ptr<LoadedScene> loadScene(const Request& request, std::string& error);
+	std::shared_ptr<MappedFile> openPack(const std::string& path, bool reload, std::string& error);
+	void request(Request request);
+
+public:
+	SceneLoader();
+	~SceneLoader();
+
+	SceneLoader(const SceneLoader&) = delete;
+	SceneLoader& operator=(const SceneLoader&) = delete;
+
+	// Starts loading a scene in the background, it replaces the current scene in the first update() after it is ready.
+	// A path of "levels.pack#Level1" loads the scene named Level1 from a scene pack, the pack is only mapped once.
+	void load(const std::string& path);
+
+	// Loads the current scene again after its file changed on disk, swapping it in like load() does. Sections that
+	// match the current scene are not verified or paged in, and if nothing changed the current scene is kept.
+	void reload();
+
+	// Call once per frame. Returns true when a new scene was swapped in, the previous scene must not be used after
+	// this. A failed load leaves the current scene in place and sets error.
+	bool update(std::string& error);
+
+	// nullptr until the first scene has loaded
+	const sg::Scene* scene() const { return mCurrent ? mCurrent->scene : nullptr; }
+
+	// nullptr when the current scene has nothing positioned or was compiled without an index
+	const sg::SceneSpatialIndex* spatialIndex() const { return mCurrent ? mCurrent->spatial : nullptr; }
+
+	// nullptr unless the current scene was compiled with scene_names, see sg::LookupSceneName
+	const sg::SceneNameTable* nameTable() const { return mCurrent ? mCurrent->names : nullptr; }
+	const std::string& scenePath() const;
+
+	// the file a scene path is loaded from, the pack for packed scenes
+	static std::string FilePath(const std::string& scene_path);
+
+	bool loading() const { return mCompletedSeen != mRequested; }
+};
@@ -0,0 +1,226 @@
+#include "SceneRenderer.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// the components of one range that are drawn, and where the view puts them
+struct VisibleRange {
+	const sg::Ref<void>* components;
+	const uint32_t* indices; // nullptr when the whole range is drawn
+	uint32_t first; // of the range in Scene::components
+	uint32_t count;
+	float offsetX;
+	float offsetY;
+};
+
+template<typename T>
+static const T* Component(const VisibleRange& range, size_t idx) {
+	return reinterpret_cast<const T*>(range.components[range.indices ? range.indices[idx] : range.first + idx].get());
+}
+
+// fills the draw data of every visible component in a range, split across the job system when the type allows it
+template<typename T, typename Prepare>
+static void PrepareRange(JobSystem* jobs, uint32_t count, const Prepare& prepare) {
+	if (jobs && T::ParallelSafe)
+		jobs->parallelFor(count, prepare);
+	else
+		prepare(0, count);
+}
+
+static void RenderTransforms(SDL_Renderer*, RenderBatch&, JobSystem*, const VisibleRange&) {}
+
+static void RenderCircles(SDL_Renderer* renderer, RenderBatch& batch, JobSystem* jobs, const VisibleRange& range) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// SDL_RenderDrawLines only draws connected lines, separate lines go through the renderer as one pixel wide quads
+	static const int CORNERS[6] = {0, 1, 2, 2, 1, 3};
+
+	batch.vertices.resize(size_t(range.count) * 4);
+	batch.indices.resize(size_t(range.count) * 6);
+
+	SDL_Color color;
+	SDL_GetRenderDrawColor(renderer, &color.r, &color.g, &color.b, &color.a);
+
+	PrepareRange<sg::Circle>(jobs, range.count, [&](size_t begin, size_t end) {
+		for (size_t idx = begin; idx < end; ++idx) {
+			const sg::Circle* c = Component<sg::Circle>(range, idx);
+
+			// the line runs diagonally down and right, the quad is widened half a pixel to either side of it
+			const float x = c->transform.x + range.offsetX;
+			const float y = c->transform.y + range.offsetY;
+			const float offset = 0.5f * 0.70710678f;
+
+			SDL_Vertex* vertices = &batch.vertices[idx * 4];
+			vertices[0] = {{x + offset, y - offset}, color, {0.0f, 0.0f}};
+			vertices[1] = {{x - offset, y + offset}, color, {0.0f, 0.0f}};
+			vertices[2] = {{x + c->radius + offset, y + c->radius - offset}, color, {0.0f, 0.0f}};
+			vertices[3] = {{x + c->radius - offset, y + c->radius + offset}, color, {0.0f, 0.0f}};
+
+			for (size_t n = 0; n < 6; ++n) {
+				batch.indices[idx * 6 + n] = int(idx * 4) + CORNERS[n];
+			}
+		}
+	});
+
+	SDL_RenderGeometry(renderer, nullptr, batch.vertices.data(), int(batch.vertices.size()), batch.indices.data(), int(batch.indices.size()));
+#else
+	for (uint32_t idx = 0; idx < range.count; ++idx) {
+		const sg::Circle* c = Component<sg::Circle>(range, idx);
+		const float x = c->transform.x + range.offsetX;
+		const float y = c->transform.y + range.offsetY;
+		SDL_RenderDrawLine(renderer, x, y, x + c->radius, y + c->radius);
+	}
+#endif
+}
+
+static void RenderRects(SDL_Renderer* renderer, RenderBatch& batch, JobSystem* jobs, const VisibleRange& range) {
+
+	batch.rects.resize(range.count);
+
+	PrepareRange<sg::Rect>(jobs, range.count, [&](size_t begin, size_t end) {
+		for (size_t idx = begin; idx < end; ++idx) {
+			const sg::Rect* r = Component<sg::Rect>(range, idx);
+
+			SDL_Rect& r2 = batch.rects[idx];
+			r2.x = r->transform.x + range.offsetX;
+			r2.y = r->transform.y + range.offsetY;
+			r2.w = r->width;
+			r2.h = r->height;
+		}
+	});
+
+	SDL_RenderFillRects(renderer, batch.rects.data(), int(range.count));
+}
+
+// sorting the visible components is cheaper than marking them while fewer than one in this many are visible
+static const uint64_t SORT_LIMIT = 64;
+
+static inline uint32_t CountTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward64(&idx, bits);
+	return uint32_t(idx);
+#else
+	return uint32_t(__builtin_ctzll(bits));
+#endif
+}
+
+// the bounds test the spatial index would have done, for scenes compiled without one
+template<typename T>
+static void CullRange(std::vector<uint32_t>& visible, const sg::Ref<void>* components, uint32_t first, uint32_t count, const sg::SceneBounds& view) {
+
+	if constexpr (HasComponentBounds<T>::value) {
+		for (uint32_t idx = first; idx < first + count; ++idx) {
+			if (ComponentBounds(*reinterpret_cast<const T*>(components[idx].get())).overlaps(view))
+				visible.push_back(idx);
+		}
+	}
+}
+
+static void CullScene(RenderBatch& batch, const sg::Scene* scene, const sg::SceneSpatialIndex* spatial, const sg::SceneBounds& view) {
+
+	PROFILE_ZONE("Cull");
+
+	batch.visible.clear();
+
+	if (spatial) {
+		sg::QuerySceneSpatialIndex(*spatial, view, batch.visible);
+
+		// ranges are contiguous in scene order, so ordering the list splits it into one run per range
+		if (batch.visible.size() < scene->componentCount / SORT_LIMIT) {
+			std::sort(batch.visible.begin(), batch.visible.end());
+			return;
+		}
+
+		// when much of the scene is visible, marking components and reading the marks back in order beats sorting
+		batch.marks.assign(size_t((scene->componentCount + 63) / 64), 0);
+		for (uint32_t idx : batch.visible) {
+			if (idx < scene->componentCount)
+				batch.marks[idx / 64] |= uint64_t(1) << (idx % 64);
+		}
+
+		batch.visible.clear();
+		for (size_t word = 0; word < batch.marks.size(); ++word) {
+			for (uint64_t bits = batch.marks[word]; bits != 0; bits &= bits - 1) {
+				batch.visible.push_back(uint32_t(word * 64 + CountTrailingZeros(bits)));
+			}
+		}
+
+		return;
+	}
+
+	const sg::ComponentRange* ranges = scene->componentRanges.get();
+	const sg::Ref<void>* components = scene->components.get();
+
+	uint32_t first = 0;
+
+	for (uint32_t range_idx = 0; range_idx < scene->componentRangeCount; ++range_idx) {
+		const sg::ComponentRange& cr = ranges[range_idx];
+
+		switch (cr.typeId) {
+#define X(component_id) case sg::TypeId::component_id:\
+			CullRange<sg::component_id>(batch.visible, components, first, cr.count, view);\
+			break;
+
+			SG_COMPONENTS
+#undef X
+
+			// the cold parts of components, read through FindColdComponents by what needs them
+			default:
+				break;
+		}
+
+		first += cr.count;
+	}
+}
+
+void RenderScene(SDL_Renderer* renderer, RenderBatch& batch, JobSystem* jobs, const sg::Scene* scene, const sg::SceneSpatialIndex* spatial, const sg::SceneBounds& view) {
+
+	CullScene(batch, scene, spatial, view);
+
+	const sg::ComponentRange* ranges = scene->componentRanges.get();
+
+	VisibleRange range;
+	range.components = scene->components.get();
+	range.offsetX = -view.minX;
+	range.offsetY = -view.minY;
+
+	uint32_t first = 0;
+	const uint32_t* visible = batch.visible.data();
+	const uint32_t* visible_end = visible + batch.visible.size();
+
+	for (uint32_t range_idx = 0; range_idx < scene->componentRangeCount; ++range_idx) {
+		const sg::ComponentRange& cr = ranges[range_idx];
+
+		const uint32_t* range_end = std::lower_bound(visible, visible_end, first + cr.count);
+		range.indices = visible;
+		range.first = first;
+		range.count = uint32_t(range_end - visible);
+
+		visible = range_end;
+		first += cr.count;
+
+		switch (cr.typeId) {
+#define X(component_id) case sg::TypeId::component_id: {\
+			if (!HasComponentBounds<sg::component_id>::value) {\
+				range.indices = nullptr;\
+				range.count = cr.count;\
+			}\
+			if (range.count == 0)\
+				break;\
+			PROFILE_ZONE("Render " #component_id);\
+			Render##component_id##s(renderer, batch, jobs, range);\
+			break;\
+		}
+
+			SG_COMPONENTS
+#undef X
+
+			default:
+				break;
+		}
+	}
+}
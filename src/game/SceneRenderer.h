@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include "JobSystem.h"
+#include "SceneSpatial.h"
+#include "SgCodeGen.h"
+
+/*
+Components are drawn a range at a time, every component in a range has the same type, so a range becomes one draw
+call instead of one per component. Only components that overlap the view are drawn, they are found through the spatial
+index when the scene has one, otherwise by testing the bounds of every component. Types without bounds are always drawn
+in full. The draw data of a range is filled in by every core when its type is ParallelSafe, and is complete before the
+range is drawn. The buffers are kept between frames so drawing doesn't allocate.
+*/
+struct RenderBatch {
+	std::vector<uint32_t> visible; // indices into Scene::components, in scene order
+	std::vector<uint64_t> marks; // a bit per component, for ordering visible
+	std::vector<SDL_Rect> rects;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// circles as quads, older SDL has no SDL_RenderGeometry and draws them a line at a time
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+#endif
+};
+
+// What a component covers in the world, the same bounds the scene compiler puts in the spatial index. Components of
+// types without an overload are always drawn.
+inline sg::SceneBounds ComponentBounds(const sg::Circle& c) {
+	// drawn as a line from the position to radius down and right, but culled as the circle it stands for
+	const float radius = c.radius < 0.0f ? -c.radius : c.radius;
+	return {c.transform.x - radius, c.transform.y - radius, c.transform.x + radius, c.transform.y + radius};
+}
+
+inline sg::SceneBounds ComponentBounds(const sg::Rect& r) {
+	const float x = r.transform.x;
+	const float y = r.transform.y;
+	return {std::min(x, x + r.width), std::min(y, y + r.height), std::max(x, x + r.width), std::max(y, y + r.height)};
+}
+
+template<typename T, typename = void>
+struct HasComponentBounds : std::false_type {};
+
+template<typename T>
+struct HasComponentBounds<T, decltype(void(ComponentBounds(std::declval<const T&>())))> : std::true_type {};
+
+// Draws the components of a scene that overlap view with the current draw color, view.minX and view.minY end up at
+// the top left of the renderer. spatial may be nullptr when the scene has no index, jobs to use only the calling thread.
+void RenderScene(SDL_Renderer* renderer, RenderBatch& batch, JobSystem* jobs, const sg::Scene* scene, const sg::SceneSpatialIndex* spatial, const sg::SceneBounds& view);
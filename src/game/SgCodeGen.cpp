@@ -1,90 +1,64 @@
 /* This code is all generated from SG Edit. Any edits to it may be lost.*/
 
 #include "SgCodeGen.h"
+#include "SceneFormat.h"
+#include "SceneSchema.h"
 
 namespace sg {
 
-const Scene* ToScene(void *data) {
+	static_assert(sizeof(String) == sizeof(SceneString) && offsetof(String, hash) == offsetof(SceneString, hash) &&
+		offsetof(String, length) == offsetof(SceneString, length) && offsetof(String, id) == offsetof(SceneString, id), "String does not match SceneString");
 
-#if SG_IMPL
-	const uintptr_t data_start = uintptr_t(data);
-
-	Scene *result = reinterpret_cast<Scene*>(data);
-	result->components = reinterpret_cast<const void**>(data_start + reinterpret_cast<uintptr_t>(result->components));
-	result->componentRanges = reinterpret_cast<const ComponentRange*>(data_start + reinterpret_cast<uintptr_t>(result->componentRanges));
-	const ComponentRange* r = result->componentRanges;
-	const ComponentRange* r_end = result->componentRanges + result->componentRangeCount;
-	const void** c = result->components;
-
-	if (r->typeId == TypeId::Transform) {
-		c += r->count;
-		if (++r == r_end)
-			return result;
+	const Scene* ToScene(const void *data) {
+		const SceneFileHeader *header = reinterpret_cast<const SceneFileHeader*>(data);
+		return reinterpret_cast<const Scene*>(reinterpret_cast<const char*>(data) + header->sections[SCENE_SECTION_SCENE].offset);
 	}
 
-	if (r->typeId == TypeId::Circle) {
-		c += r->count;
-		if (++r == r_end)
-			return result;
-	}
+	static const SceneSchemaType SCHEMA_TYPES[] = {
+		{0xc1fff4f356dfb2fbull, 16, 0, 2, 0}, // Transform
+		{0x14c54ca33d0f3ea9ull, 32, 2, 2, 0}, // Circle
+		{0x7414702bbe6fbc27ull, 32, 4, 3, 0}, // Rect
+	};
+
+	static const SceneSchemaMember SCHEMA_MEMBERS[] = {
+		{0xaf63f54c86021707ull, 0xdd635018ff703544ull, 0x0000000000000000ull, 0, 4}, // Transform::x
+		{0xaf63f44c86021554ull, 0xdd635018ff703544ull, 0x0000000000000000ull, 4, 4}, // Transform::y
+		{0xa293b946d5782cf3ull, 0xdd635018ff703544ull, 0x0000000000000000ull, 16, 4}, // Circle::radius
+		{0xc0dc534e3003c89bull, 0xab048c23baa9b520ull, 0xc1fff4f356dfb2fbull, 0, 16}, // Circle::transform
+		{0xdbdacd932fd1e9bfull, 0xdd635018ff703544ull, 0x0000000000000000ull, 16, 4}, // Rect::width
+		{0x17720bf67d347222ull, 0xdd635018ff703544ull, 0x0000000000000000ull, 20, 4}, // Rect::height
+		{0xc0dc534e3003c89bull, 0xab048c23baa9b520ull, 0xc1fff4f356dfb2fbull, 0, 16}, // Rect::transform
+	};
+
+	static const void* const SCHEMA_DEFAULTS[] = {&Transform::Default, &Circle::Default, &Rect::Default};
+
+	const Ref<void>* FindColdComponents(const Scene* scene, uint64_t range_index) {
+		static const uint32_t NO_COLD = ~0u;
+		static const uint32_t COLD_TYPES[] = {NO_COLD, NO_COLD, NO_COLD};
+
+		const ComponentRange* ranges = scene->componentRanges.get();
+		const uint32_t cold_type = range_index < scene->componentRangeCount && uint32_t(ranges[range_index].typeId) < 3 ? COLD_TYPES[uint32_t(ranges[range_index].typeId)] : NO_COLD;
+
+		// the components of a range start after those of every range before it
+		uint64_t first = 0;
+		for (uint64_t r = 0; r < scene->componentRangeCount && cold_type != NO_COLD; ++r) {
+			if (uint32_t(ranges[r].typeId) == cold_type)
+				return ranges[r].count == ranges[range_index].count ? scene->components.get() + first : nullptr;
+
+			first += ranges[r].count;
+		}
 
-	if (r->typeId == TypeId::Rect) {
-		c += r->count;
-		if (++r == r_end)
-			return result;
+		return nullptr;
 	}
-	return result;
-#endif
-return nullptr;
-}
-
-#ifdef SG_BUILDER
-struct SceneSizes {
-	size_t scene_size;
-	size_t component_array_size;
-	size_t component_size;
-	size_t text_size;
-}
-SceneSizes CalcByteSize(const Scene *scene) {
-
-	SceneSizes result;
-	result.scene_size = sizeof(Scene);
-	result.component_array_size + sizeof(DeferredPtr) * scene->component_count;
-	result.component_size = 0;
-	result.text_size = 0;
-
-	for (const DeferredPtr& p : *scene) {
 
-		switch (p.typeId) {
-
-			case TypeId::Transform {
-				result.component_size += sizeof(Transform);
-			} break;
-
-			case TypeId::Circle {
-				result.component_size += sizeof(Circle);
-			} break;
-
-			case TypeId::Rect {
-				result.component_size += sizeof(Rect);
-			} break;
-		}
+	bool InlineCopiesMatch(const Scene* scene) {
+		// no component holds inline copies
+		(void)scene;
+		return true;
 	}
-	return result;
-}
-
-std::vector<uint8_t> ToBytes(const Scene *scene) {
 
-	const SceneSizes sizes = CalcByteSize(scene);
-	std::vector<uint8_t> result(sizes.scene_size + sizes.component_size + sizes.text_size);
-	Scene* scene_start = reinterpret_cast<Scene*>(result.data());
-	DeferredPtr *out_p = reinterpret_cast<DeferredPtr*>(result.data() + sizes.scene_size);
-	uint8_t* component_start = result.data() + sizes.scene_size + sizes.component_array_size;
-	uint8_t* text_start = result.data() + sizes.text_size;
-	reinterpret_cast<uintptr_t&>(scene_start->components) = sizeof(Scene);
-	scene_start->component_count = scene->component_count;
-	for (const DeferredPtr& in_p : scene) {
-		DeferredPtr& out_p = 	}
-}
-#endif
+	const SceneSchema& GeneratedSchema() {
+		static const SceneSchema schema = {SCHEMA_HASH, SCHEMA_TYPES, 3, SCHEMA_MEMBERS, 7, SCHEMA_DEFAULTS};
+		return schema;
+	}
 }
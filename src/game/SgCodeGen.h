@@ -2,13 +2,41 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "Quantize.h"
+#include "VectorMath.h"
 
-#ifdef SG_BUILDER
-#include <vector>
-#endif
 namespace sg {
 
+	// an offset from the Ref itself, 0 is nullptr. Scenes use these instead of pointers so they can be used straight
+	// from a read only mapping of the file, with no fixups.
+	template<typename T>
+	struct Ref {
+		int64_t offset;
+
+		const T* get() const {
+			return offset ? reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + offset) : nullptr;
+		}
+
+		const T* operator->() const { return get(); }
+		explicit operator bool() const { return offset != 0; }
+	};
+
+	// Text is pooled by the scene compiler, the same text is stored once per scene or pack, so equal text is the same
+	// String. hash is sg::StringHash of the characters, so a name known up front is found by comparing integers.
+	struct String {
+		uint64_t hash;
+		uint32_t length; // without the null
+		uint32_t id; // numbered from 0, so it can index tables
+
+		// the characters follow, null terminated
+		const char* c_str() const { return reinterpret_cast<const char*>(this + 1); }
+	};
+
 	enum class TypeId {
 		Transform,
 		Circle,
@@ -20,45 +48,83 @@ namespace sg {
 		X(Circle)\
 		X(Rect)
 
+	#define SG_COLD_COMPONENTS
+
 
 	struct alignas(16) Transform {
 		static const TypeId StaticTypeId = TypeId::Transform;
+		static const bool ParallelSafe = true; // true when it refers to no other component
+		static const Transform Default; // every property at its default value, the same as Transform{}
 
-		float x;
-		float y;
+		float x = 0.0f;
+		float y = 0.0f;
 	};
 
+	static_assert(sizeof(Transform) == 16, "Transform does not match the SG Edit layout");
+	static_assert(offsetof(Transform, x) == 0, "Transform::x does not match the SG Edit layout");
+	static_assert(offsetof(Transform, y) == 4, "Transform::y does not match the SG Edit layout");
+
+	constexpr Transform Transform::Default = {};
+
 	struct alignas(16) Circle {
 		static const TypeId StaticTypeId = TypeId::Circle;
+		static const bool ParallelSafe = true; // true when it refers to no other component
+		static const Circle Default; // every property at its default value, the same as Circle{}
 
-		float radius;
 		Transform transform;
+		float radius = 1.0f;
 	};
 
+	static_assert(sizeof(Circle) == 32, "Circle does not match the SG Edit layout");
+	static_assert(offsetof(Circle, radius) == 16, "Circle::radius does not match the SG Edit layout");
+	static_assert(offsetof(Circle, transform) == 0, "Circle::transform does not match the SG Edit layout");
+
+	constexpr Circle Circle::Default = {};
+
 	struct alignas(16) Rect {
 		static const TypeId StaticTypeId = TypeId::Rect;
+		static const bool ParallelSafe = true; // true when it refers to no other component
+		static const Rect Default; // every property at its default value, the same as Rect{}
 
-		float width;
-		float height;
 		Transform transform;
+		float width = 1.0f;
+		float height = 1.0f;
 	};
 
+	static_assert(sizeof(Rect) == 32, "Rect does not match the SG Edit layout");
+	static_assert(offsetof(Rect, width) == 16, "Rect::width does not match the SG Edit layout");
+	static_assert(offsetof(Rect, height) == 20, "Rect::height does not match the SG Edit layout");
+	static_assert(offsetof(Rect, transform) == 0, "Rect::transform does not match the SG Edit layout");
+
+	constexpr Rect Rect::Default = {};
+
 	struct ComponentRange {
 		TypeId typeId;
 		uint32_t count;
 	};
 
 	struct Scene {
-		const void **components;
-		uintptr_t componentCount;
+		Ref<Ref<void>> components;
+		uint64_t componentCount;
 
-		const ComponentRange *componentRanges;
-		uintptr_t componentRangeCount;
+		Ref<ComponentRange> componentRanges;
+		uint64_t componentRangeCount;
 	};
 
-	const Scene* ToScene(void *data);
+	// scenes compiled for different components than these have to be converted with ConvertScene
+	static const uint64_t SCHEMA_HASH = 0xe053aa86754ccd0bull;
+
+	// The Refs to the cold parts of the components of a range, in the same order as the range, nullptr when its
+	// components have no cold part. The range's type has a Cold member type for them.
+	const Ref<void>* FindColdComponents(const Scene* scene, uint64_t range_index);
+
+	// Whether every copy the scene compiler made of the target of an inline component_ref still matches its target. It
+	// reads every component holding a copy, so it is meant for debug builds.
+	bool InlineCopiesMatch(const Scene* scene);
+
+	// the layouts above the way scene files store them, see SceneSchema.h
+	const struct SceneSchema& GeneratedSchema();
 
-#ifdef SG_BUILDER
-	const std::vector<uint8_t> ToBytes(const Scene* scene);
-#endif
+	// the scene in a file produced by the SG Edit scene compiler, the file must pass ValidateSceneHeader first
+	const Scene* ToScene(const void *data);
 }
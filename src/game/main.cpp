@@ -1,4 +1,7 @@
 #include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
 #include <vector>
 #include <algorithm>
 
@@ -8,6 +11,12 @@
 #include <SDL_render.h>
 
 #include "SgCodeGen.h"
+#include "Benchmark.h"
+#include "FileWatcher.h"
+#include "Profiler.h"
+#include "SceneFormat.h"
+#include "SceneLoader.h"
+#include "SceneRenderer.h"
 
 void ShowError(const char* file, int line_num, const char* msg) {
 
@@ -46,72 +55,162 @@ T* VerifyNotNulll(T* value, const char* file, int line, const char* msg) {
 
 #define VERIFY_NOT_NULL(line) VerifyNotNulll((line), __FILE__, __LINE__, #line)
 
-std::vector<uint8_t> load_file(const char* path) {
-	FILE *fp = fopen(path, "rb");
-	if (!fp) {
+static const char* TRACE_PATH = "sg_trace.json";
 
-		printf("Error loading '%s'\n", path);
-		exit(-1);
-		return {};
-	}
-
-	fseek(fp, SEEK_END, 0);
-	std::vector<uint8_t> result(ftell(fp));
-	fseek(fp, SEEK_SET, 0);
+// how far the arrow keys move the camera per key press, or per repeat while held
+static const float CAMERA_STEP = 32.0f;
 
-	fread(result.data(), 1, result.size(), fp);
-
-	return result;
-}
+int main_loop(SDL_Window *window, SDL_Renderer* renderer, const std::vector<std::string>& scene_paths) {
 
-void RenderTransform(SDL_Renderer*, const sg::Transform*) {}
-
-void RenderCircle(SDL_Renderer* renderer, const sg::Circle *c) {
-	SDL_RenderDrawLine(renderer, c->transform.x, c->transform.y, c->transform.x + c->radius, c->transform.y + c->radius);						
-}
+	SDL_Event e;
+	RenderBatch batch;
+	JobSystem jobs(std::thread::hardware_concurrency());
+
+	// world position at the top left of the window
+	float camera_x = 0.0f;
+	float camera_y = 0.0f;
+
+	SceneLoader loader;
+	size_t scene_index = 0;
+	loader.load(scene_paths[scene_index]);
+
+	// scenes rebuilt by the editor while the game runs are reloaded
+	FileWatcher watcher;
+	for (const std::string& path : scene_paths) {
+		if (!watcher.watch(SceneLoader::FilePath(path)))
+			printf("Not watching '%s' for changes\n", path.c_str());
+	}
 
-void RenderRect(SDL_Renderer* renderer, const sg::Rect *r) {
-	SDL_Rect r2;
-	r2.x = r->transform.x;
-	r2.y = r->transform.y;
-	r2.w = r->width;
-	r2.h = r->height;
-	SDL_RenderFillRect(renderer, &r2);
-}
+	while (true) {
+		PROFILE_ZONE("Frame");
+
+		{
+			PROFILE_ZONE("Events");
+
+			while (SDL_PollEvent(&e) != 0) {
+				if (e.type == SDL_QUIT)
+					return 0;
+
+				// space switches to the next scene, the current one keeps rendering until it has loaded
+				if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_SPACE && scene_paths.size() > 1) {
+					scene_index = (scene_index + 1) % scene_paths.size();
+					loader.load(scene_paths[scene_index]);
+				}
+
+				if (e.type == SDL_KEYDOWN) {
+					switch (e.key.keysym.sym) {
+					case SDLK_LEFT: camera_x -= CAMERA_STEP; break;
+					case SDLK_RIGHT: camera_x += CAMERA_STEP; break;
+					case SDLK_UP: camera_y -= CAMERA_STEP; break;
+					case SDLK_DOWN: camera_y += CAMERA_STEP; break;
+					}
+				}
+
+				// p writes out the last few seconds of zones, right after a spike is the time to press it
+				if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_p && Profiler::enabled()) {
+					Profiler::printReport();
+
+					if (Profiler::writeTrace(TRACE_PATH))
+						printf("Wrote '%s'\n", TRACE_PATH);
+					else
+						printf("Unable to write '%s'\n", TRACE_PATH);
+				}
+			}
 
-int main_loop(SDL_Window *window, SDL_Renderer* renderer) {
+			for (const std::string& changed : watcher.poll()) {
+				if (changed == SceneLoader::FilePath(loader.scenePath()))
+					loader.reload();
+			}
+		}
 
-	SDL_Event e;
+		std::string load_error;
+		bool switched;
+		{
+			PROFILE_ZONE("Scene swap");
+			switched = loader.update(load_error);
+		}
 
-	std::vector<uint8_t> scene_bytes = load_file("scene.bin");
+		if (switched)
+			printf("Switched to '%s'\n", loader.scenePath().c_str());
 
-	const sg::Scene *scene = sg::ToScene(scene_bytes.data());
+		if (!load_error.empty()) {
+			printf("%s\n", load_error.c_str());
 
-	while (true) {
-		while (SDL_PollEvent(&e) != 0) {
-			if (e.type == SDL_QUIT)
-				return 0;
+			// with no scene to fall back to there is nothing to show
+			if (!loader.scene() && !loader.loading())
+				return -1;
 		}
 
-		uint32_t idx = 0;
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+		SDL_RenderClear(renderer);
 
-		for (uint32_t range_idx = 0; range_idx < scene->componentRangeCount; ++range_idx) {
-			const sg::ComponentRange& cr = scene->componentRanges[range_idx];
+		if (const sg::Scene *scene = loader.scene()) {
+			SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
 
-			switch (cr.typeId) {
-#define X(component_id) case sg::TypeId::component_id:\
-				for (const uint32_t end = idx + cr.count; idx < end; ++idx)\
-					Render##component_id(renderer, reinterpret_cast<const sg::component_id*>(scene->components[idx]));
+			int width, height;
+			VERIFY(SDL_GetRendererOutputSize(renderer, &width, &height));
 
-				SG_COMPONENTS
-#undef X
-			}
+			const sg::SceneBounds view = {camera_x, camera_y, camera_x + float(width), camera_y + float(height)};
+			RenderScene(renderer, batch, &jobs, scene, loader.spatialIndex(), view);
+		} else {
+			// the renderer doesn't wait for vsync, so without this the loop would spin while the first scene loads and
+			// take a core from the loader thread
+			SDL_Delay(1);
 		}
+
+		PROFILE_ZONE("Present");
+		SDL_RenderPresent(renderer);
 	}
 }
 
 int main(int argc, char* argv[]) {
 
+	// every scene given on the command line can be switched to, scene.bin by default
+	std::vector<std::string> scene_paths;
+
+	bool benchmark = false;
+	BenchmarkOptions benchmark_options;
+
+	for (int n = 1; n < argc; ++n) {
+		const std::string arg = argv[n];
+		const bool has_value = n + 1 < argc;
+
+		if (arg == "--profile") {
+			Profiler::setEnabled(true);
+		} else if (arg == "--bench") {
+			benchmark = true;
+
+			// the mix is optional, --bench on its own uses the default
+			if (has_value && std::string(argv[n + 1]).find('=') != std::string::npos)
+				benchmark_options.mix = argv[++n];
+		} else if (arg == "--bench_frames" && has_value) {
+			benchmark_options.frames = uint32_t(std::strtoul(argv[++n], nullptr, 10));
+		} else if (arg == "--bench_threads" && has_value) {
+			benchmark_options.threads = uint32_t(std::strtoul(argv[++n], nullptr, 10));
+		} else if (arg == "--bench_world" && has_value) {
+			// WIDTHxHEIGHT
+			char* end = nullptr;
+			benchmark_options.worldWidth = uint32_t(std::strtoul(argv[++n], &end, 10));
+			benchmark_options.worldHeight = *end == 'x' ? uint32_t(std::strtoul(end + 1, nullptr, 10)) : benchmark_options.worldWidth;
+		} else if (arg == "--bench_scene" && has_value) {
+			benchmark_options.scenePath = argv[++n];
+		} else {
+			scene_paths.push_back(arg);
+		}
+	}
+
+	if (benchmark) {
+		const int res = RunBenchmark(benchmark_options);
+
+		if (Profiler::enabled())
+			Profiler::printReport();
+
+		return res;
+	}
+
+	if (scene_paths.empty())
+		scene_paths.push_back("scene.bin");
+
 	VERIFY(SDL_Init(SDL_INIT_VIDEO|SDL_INIT_AUDIO|SDL_INIT_EVENTS));
 
 	SDL_Window *window = VERIFY_NOT_NULL(SDL_CreateWindow(
@@ -129,7 +228,10 @@ int main(int argc, char* argv[]) {
 		0
 	));
 
-	const int res = main_loop(window, renderer);
+	const int res = main_loop(window, renderer, scene_paths);
+
+	if (Profiler::enabled())
+		Profiler::printReport();
 
 	SDL_DestroyWindow(window);
 	SDL_DestroyRenderer(renderer);